@@ -0,0 +1,228 @@
+#include "basin_map_io.hpp"
+#include "palette.hpp"
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std::string_literals;
+
+namespace euleristic {
+
+	constexpr std::array<char, 8> basin_map_magic = { 'N', 'F', 'B', 'A', 'S', 'I', 'N', 'S' };
+	constexpr std::uint32_t basin_map_version = 1;
+	constexpr size_t basin_map_alignment = 64;
+
+	size_t align_up(size_t offset) noexcept {
+		return (offset + basin_map_alignment - 1) / basin_map_alignment * basin_map_alignment;
+	}
+
+	void store_le(std::uint8_t* destination, std::uint64_t value, int bytes) noexcept {
+		for (int byte = 0; byte < bytes; ++byte) {
+			destination[byte] = static_cast<std::uint8_t>(value >> (8 * byte));
+		}
+	}
+
+	std::uint64_t load_le(const std::uint8_t* source, int bytes) noexcept {
+		std::uint64_t value = 0;
+		for (int byte = 0; byte < bytes; ++byte) {
+			value |= static_cast<std::uint64_t>(source[byte]) << (8 * byte);
+		}
+		return value;
+	}
+
+	size_t basin_map_view::basin(size_t pixel) const noexcept {
+		const size_t index = index_bits == 8 ? indices[pixel] : load_le(indices + 2 * pixel, 2);
+		return index < zero_count ? index : zero_count;
+	}
+
+	basin_map_view view(const basin_map& map) noexcept {
+		return { map.width, map.height, map.index_bits, map.zero_count, map.iteration_budget, map.basins.data(), map.iterations.data() };
+	}
+
+	unsigned default_index_bits(const basin_map& map) noexcept {
+		return map.zero_count < 0xff ? 8 : 16;
+	}
+
+	size_t basin_map_file_size(const basin_map& map, unsigned index_bits) noexcept {
+		if (index_bits == 0) index_bits = default_index_bits(map);
+		const size_t pixels = map.width * map.height;
+		return align_up(basin_map_header_size + pixels * index_bits / 8) + pixels;
+	}
+
+	void write_basin_map(std::ostream& output, const basin_map& map, unsigned index_bits) {
+		if (index_bits == 0) {
+			index_bits = default_index_bits(map);
+		}
+		if (index_bits != 8 && index_bits != 16) {
+			throw std::invalid_argument("Basin map indices are 8 or 16 bits.");
+		}
+		if (index_bits == 8 && map.zero_count >= 0xff) {
+			throw std::invalid_argument("8 bit basin map indices only have room for 254 zeros.");
+		}
+
+		const size_t pixels = map.width * map.height;
+		const size_t index_offset = basin_map_header_size;
+		const size_t iteration_offset = align_up(index_offset + pixels * index_bits / 8);
+
+		std::array<std::uint8_t, basin_map_header_size> header{};
+		std::memcpy(header.data(), basin_map_magic.data(), basin_map_magic.size());
+		store_le(header.data() + 8, basin_map_version, 4);
+		store_le(header.data() + 12, index_bits, 4);
+		store_le(header.data() + 16, map.width, 8);
+		store_le(header.data() + 24, map.height, 8);
+		store_le(header.data() + 32, map.zero_count, 4);
+		store_le(header.data() + 36, map.iteration_budget, 4);
+		store_le(header.data() + 40, index_offset, 8);
+		store_le(header.data() + 48, iteration_offset, 8);
+		output.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+		// The map's indices are the file's, unless asked for the other width, which takes them a row at a time
+		if (index_bits == map.index_bits) {
+			output.write(reinterpret_cast<const char*>(map.basins.data()), map.basins.size());
+		}
+		else {
+			const auto source = view(map);
+			std::vector<std::uint8_t> row(map.width * index_bits / 8);
+			for (size_t y = 0; y < map.height; ++y) {
+				for (size_t x = 0; x < map.width; ++x) {
+					const auto basin = source.basin(y * map.width + x);
+					const std::uint16_t index = basin == map.zero_count ? basin_map::no_zero : static_cast<std::uint16_t>(basin);
+					store_le(row.data() + x * index_bits / 8, index, index_bits / 8);
+				}
+				output.write(reinterpret_cast<const char*>(row.data()), row.size());
+			}
+		}
+		const std::array<char, basin_map_alignment> padding{};
+		output.write(padding.data(), iteration_offset - (index_offset + pixels * index_bits / 8));
+		output.write(reinterpret_cast<const char*>(map.iterations.data()), map.iterations.size());
+		if (!output) {
+			throw std::runtime_error("Could not write the basin map.");
+		}
+	}
+
+	mapped_basin_map::mapped_basin_map(const std::filesystem::path& path) {
+		const auto fail = [&](const std::string& reason) {
+			release();
+			throw std::runtime_error(path.string() + ": " + reason);
+		};
+
+#ifdef _WIN32
+		file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			file = nullptr;
+			fail("could not open it.");
+		}
+		LARGE_INTEGER file_size{};
+		if (!GetFileSizeEx(file, &file_size)) fail("could not get its size.");
+		size = static_cast<size_t>(file_size.QuadPart);
+		if (size < basin_map_header_size) fail("too short to be a basin map.");
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping) fail("could not map it.");
+		data = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!data) fail("could not map it.");
+#else
+		const int descriptor = ::open(path.c_str(), O_RDONLY);
+		if (descriptor < 0) fail("could not open it.");
+		struct stat status {};
+		if (::fstat(descriptor, &status) != 0) {
+			::close(descriptor);
+			fail("could not get its size.");
+		}
+		size = static_cast<size_t>(status.st_size);
+		if (size < basin_map_header_size) {
+			::close(descriptor);
+			fail("too short to be a basin map.");
+		}
+		void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		// The mapping keeps the file open on its own
+		::close(descriptor);
+		if (address == MAP_FAILED) fail("could not map it.");
+		data = static_cast<const std::uint8_t*>(address);
+#endif
+
+		if (!std::equal(basin_map_magic.begin(), basin_map_magic.end(), data)) fail("not a basin map.");
+		if (load_le(data + 8, 4) != basin_map_version) {
+			fail("a basin map of version "s + std::to_string(load_le(data + 8, 4)) + ", which this doesn't read.");
+		}
+		map_view.index_bits = static_cast<unsigned>(load_le(data + 12, 4));
+		map_view.width = load_le(data + 16, 8);
+		map_view.height = load_le(data + 24, 8);
+		map_view.zero_count = load_le(data + 32, 4);
+		map_view.iteration_budget = static_cast<unsigned>(load_le(data + 36, 4));
+		const auto index_offset = load_le(data + 40, 8);
+		const auto iteration_offset = load_le(data + 48, 8);
+
+		if (map_view.index_bits != 8 && map_view.index_bits != 16) fail("its indices are neither 8 nor 16 bits.");
+		// All ones is "no zero" at either width, so that can't be a zero's index, and the palette is sized by the count
+		if (map_view.zero_count >= (map_view.index_bits == 8 ? 0xffu : 0xffffu)) {
+			fail("it has more zeros than its "s + std::to_string(map_view.index_bits) + " bit indices have room for.");
+		}
+		// Checked so that the products below can't wrap around
+		if (map_view.width > (1ull << 31) || map_view.height > (1ull << 31)) fail("its size is implausible.");
+		const std::uint64_t pixels = map_view.width * map_view.height;
+		if (index_offset < basin_map_header_size || index_offset > size || (size - index_offset) / (map_view.index_bits / 8) < pixels
+			|| iteration_offset < index_offset + pixels * (map_view.index_bits / 8) || iteration_offset > size || size - iteration_offset < pixels) {
+			fail("truncated, or its planes overlap.");
+		}
+		map_view.indices = data + index_offset;
+		map_view.iterations = data + iteration_offset;
+	}
+
+	mapped_basin_map::~mapped_basin_map() noexcept {
+		release();
+	}
+
+	void mapped_basin_map::release() noexcept {
+#ifdef _WIN32
+		if (data) UnmapViewOfFile(data);
+		if (mapping) CloseHandle(mapping);
+		if (file) CloseHandle(file);
+		mapping = file = nullptr;
+#else
+		if (data) ::munmap(const_cast<std::uint8_t*>(data), size);
+#endif
+		data = nullptr;
+	}
+
+	void apply_palette(const basin_map_view& map, image& target, thread_pool* pool) {
+		if (target.width != map.width || target.height != map.height || target.pixels.size() != map.width * map.height) {
+			target = image(map.width, map.height);
+		}
+
+		// Indexed by basin(), which puts the pixels that converged to none last
+		std::vector<glm::u8vec4> palette;
+		for (size_t i = 0; i < map.zero_count; ++i) {
+			palette.push_back(to_rgba8(generate_color(i)));
+		}
+		palette.emplace_back(0, 0, 0, 255);
+
+		const auto color_rows = [&](size_t first_row, size_t last_row) {
+			for (size_t pixel = first_row * map.width; pixel < last_row * map.width; ++pixel) {
+				target.pixels[pixel] = palette[map.basin(pixel)];
+			}
+		};
+		constexpr size_t rows_per_task = 64;
+		if (!pool || map.height <= rows_per_task) {
+			color_rows(0, map.height);
+			return;
+		}
+		pool->run((map.height + rows_per_task - 1) / rows_per_task, [&](size_t task, unsigned) {
+			color_rows(task * rows_per_task, std::min((task + 1) * rows_per_task, map.height));
+		});
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <span>
+#include <cstdint>
+#include <ostream>
+#include <filesystem>
+
+#include "cpu_renderer.hpp"
+#include "thread_pool.hpp"
+
+namespace euleristic {
+
+	// Basin map files (.basins) hold a basin_map as it is, so it can be colored or encoded again without rendering it
+	// again. Everything is little-endian, and the planes start 64 byte aligned, so the file can be memory mapped and
+	// used where it lies.
+	//
+	//   offset  size  field
+	//        0     8  magic, "NFBASINS"
+	//        8     4  version, 1
+	//       12     4  index bits, 8 or 16
+	//       16     8  width
+	//       24     8  height
+	//       32     4  zero count
+	//       36     4  iteration budget
+	//       40     8  offset of the index plane, from the start of the file
+	//       48     8  offset of the iteration plane
+	//       56     8  reserved, 0
+	//
+	// The index plane has an index per pixel, row major with the top row first, of index bits each. All ones is a pixel
+	// that didn't converge to any zero. 8 bits are used when there are fewer than 255 zeros, so the plane is a quarter
+	// of the RGBA image's size. The iteration plane has a byte per pixel: the Newton steps it took, saturating at 254,
+	// or 255 for a pixel subdivision filled in without iterating.
+	constexpr size_t basin_map_header_size = 64;
+
+	// A basin map's planes where they lie, in memory or in a mapped file
+	struct basin_map_view {
+		size_t width{}, height{};
+		unsigned index_bits{};
+		size_t zero_count{};
+		unsigned iteration_budget{};
+		const std::uint8_t* indices{};
+		const std::uint8_t* iterations{};
+
+		// The zero pixel converged to, or zero_count if none
+		size_t basin(size_t pixel) const noexcept;
+	};
+
+	// The index bits are picked from the zero count when 0
+	void write_basin_map(std::ostream& output, const basin_map& map, unsigned index_bits = 0);
+	size_t basin_map_file_size(const basin_map& map, unsigned index_bits = 0) noexcept;
+
+	// The map where it lies, since its indices are laid out like the file's
+	basin_map_view view(const basin_map& map) noexcept;
+
+	// A basin map file mapped into memory read only. The header is checked, so a view of it is safe to read.
+	class mapped_basin_map {
+	public:
+		explicit mapped_basin_map(const std::filesystem::path& path);
+		~mapped_basin_map() noexcept;
+		mapped_basin_map(const mapped_basin_map&) = delete;
+		mapped_basin_map& operator=(const mapped_basin_map&) = delete;
+
+		const basin_map_view& view() const noexcept { return map_view; }
+		size_t file_size() const noexcept { return size; }
+
+	private:
+		const std::uint8_t* data{};
+		size_t size{};
+		basin_map_view map_view;
+#ifdef _WIN32
+		void* file{};
+		void* mapping{};
+#endif
+
+		void release() noexcept;
+	};
+
+	// Colors each pixel by its zero with generate_color, and leaves those that converged to none black, exactly as
+	// cpu_renderer::render would have. Rows are spread over pool's threads if given.
+	void apply_palette(const basin_map_view& map, image& target, thread_pool* pool = nullptr);
+}
@@ -0,0 +1,448 @@
+#include "cpu_renderer.hpp"
+#include "palette.hpp"
+#include "zero_index.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+
+namespace euleristic {
+
+	glm::dmat3 make_screen_to_fractal_space(size_t width, size_t height, std::complex<double> center, double pixels_per_unit) noexcept {
+		const double units_per_pixel = 1.0 / pixels_per_unit;
+		return glm::dmat3(
+			glm::dvec3(units_per_pixel, 0.0, 0.0),
+			glm::dvec3(0.0, -units_per_pixel, 0.0),
+			glm::dvec3(center.real() - 0.5 * static_cast<double>(width) * units_per_pixel,
+				center.imag() + 0.5 * static_cast<double>(height) * units_per_pixel, 1.0));
+	}
+
+	void set_viewport(fractal_scene& scene, size_t width, size_t height, double_double center_real, double_double center_imag,
+		double pixels_per_unit) noexcept {
+		scene.screen_to_fractal_space = make_screen_to_fractal_space(width, height, std::complex<double>(center_real.hi, center_imag.hi),
+			pixels_per_unit);
+		const double units_per_pixel = 1.0 / pixels_per_unit;
+		const auto left = center_real - two_product(0.5 * static_cast<double>(width), units_per_pixel);
+		const auto top = center_imag + two_product(0.5 * static_cast<double>(height), units_per_pixel);
+		scene.screen_to_fractal_space[2][0] = left.hi;
+		scene.screen_to_fractal_space[2][1] = top.hi;
+		scene.translation_low = glm::dvec2(left.lo, top.lo);
+	}
+
+	bool needs_double_double(const glm::dmat3& screen_to_fractal_space, size_t width, size_t height) noexcept {
+		const auto& transform = screen_to_fractal_space;
+		const double pixel = std::max(std::abs(transform[0][0]) + std::abs(transform[0][1]),
+			std::abs(transform[1][0]) + std::abs(transform[1][1]));
+
+		// The coordinates are largest at one of the corners
+		double magnitude = 0.0;
+		for (const double x : { 0.0, static_cast<double>(width) }) {
+			for (const double y : { 0.0, static_cast<double>(height) }) {
+				const auto corner = transform * glm::dvec3(x, y, 1.0);
+				magnitude = std::max({ magnitude, std::abs(corner.x), std::abs(corner.y) });
+			}
+		}
+		return pixel < magnitude * deep_zoom_threshold;
+	}
+
+	image::image(size_t width, size_t height) : width(width), height(height), pixels(width * height) {}
+
+	basin_map::basin_map(size_t width, size_t height)
+		: width(width), height(height), basins(width * height, static_cast<std::uint8_t>(no_zero)), iterations(width * height, not_iterated) {}
+
+	double render_statistics::megapixels_per_second() const noexcept {
+		return elapsed.count() > 0.0 ? static_cast<double>(pixel_count) / elapsed.count() * 1e-6 : 0.0;
+	}
+
+	double render_statistics::subdivision_saving() const noexcept {
+		return pixel_count > 0 ? 1.0 - static_cast<double>(evaluated_pixels) / static_cast<double>(pixel_count) : 0.0;
+	}
+
+	size_t iteration_histogram::pixel_count() const noexcept {
+		return std::accumulate(counts.begin(), counts.end(), size_t{});
+	}
+
+	double iteration_histogram::mean() const noexcept {
+		const size_t pixels = pixel_count();
+		if (pixels == 0) return 0.0;
+		double steps = 0.0;
+		for (size_t n = 0; n < counts.size(); ++n) {
+			steps += static_cast<double>(n) * static_cast<double>(counts[n]);
+		}
+		return steps / static_cast<double>(pixels);
+	}
+
+	unsigned iteration_histogram::percentile(double share) const noexcept {
+		const double wanted = share * static_cast<double>(pixel_count());
+		size_t seen = 0;
+		for (size_t n = 0; n < counts.size(); ++n) {
+			seen += counts[n];
+			if (seen > 0 && static_cast<double>(seen) >= wanted) return static_cast<unsigned>(n);
+		}
+		return budget;
+	}
+
+	double iteration_histogram::budget_used() const noexcept {
+		return budget > 0 ? mean() / budget : 0.0;
+	}
+
+	// Sentinels in the basin map, next to the indices of the zeros
+	constexpr std::uint32_t no_zero = std::numeric_limits<std::uint32_t>::max();
+	constexpr std::uint32_t unknown_basin = no_zero - 1;
+	constexpr std::uint32_t pending_basin = no_zero - 2;
+
+	cpu_renderer::cpu_renderer(unsigned thread_count, size_t tile_size, instruction_set isa)
+		: pool(thread_count), tile_size(tile_size), isa(isa), kernel(select_newton_kernel(isa)),
+		product_kernel(select_product_form_kernel(isa)), double_double_kernel(select_newton_kernel_double_double(isa)),
+		double_double_product_kernel(select_product_form_kernel_double_double(isa)), scratch(pool.thread_count()) {
+		if (tile_size == 0) {
+			throw std::invalid_argument("Tile size must be positive.");
+		}
+		if (tile_size > 4096) {
+			throw std::invalid_argument("Tile size must be at most 4096.");
+		}
+		for (auto& worker_scratch : scratch) {
+			worker_scratch.real.resize(tile_size * tile_size);
+			worker_scratch.imag.resize(tile_size * tile_size);
+			worker_scratch.real_low.resize(tile_size * tile_size);
+			worker_scratch.imag_low.resize(tile_size * tile_size);
+			worker_scratch.iterations.resize(tile_size * tile_size);
+			worker_scratch.basins.resize(tile_size * tile_size);
+			worker_scratch.pixel_iterations.resize(tile_size * tile_size);
+			worker_scratch.pending.reserve(tile_size * tile_size);
+		}
+	}
+
+	render_statistics cpu_renderer::render(const fractal_scene& scene, image& target) {
+		return render_rows(scene, target, 0, target.height);
+	}
+
+	render_statistics cpu_renderer::render_rows(const fractal_scene& scene, image& target, size_t first_row, size_t image_height) {
+		if (target.pixels.size() != target.width * target.height) {
+			throw std::invalid_argument("The target image's pixel count doesn't match its dimensions.");
+		}
+
+		// Pixels not converging to a zero are left black, but opaque, since there is nothing to blend them onto
+		std::vector<glm::u8vec4> palette;
+		for (size_t i = 0; i < scene.zeros.size(); ++i) {
+			palette.push_back(to_rgba8(generate_color(i)));
+		}
+		const glm::u8vec4 no_zero_color(0, 0, 0, 255);
+
+		return render_tiles(scene, target.width, target.height, first_row, image_height,
+			[&](size_t x_begin, size_t y_begin, std::uint32_t tile_width, std::uint32_t tile_height, const tile_scratch& tile) {
+				for (std::uint32_t y = 0; y < tile_height; ++y) {
+					for (std::uint32_t x = 0; x < tile_width; ++x) {
+						const auto basin = tile.basins[y * tile_size + x];
+						target.pixels[(y_begin + y) * target.width + x_begin + x] = basin == no_zero ? no_zero_color : palette[basin];
+					}
+				}
+			});
+	}
+
+	render_statistics cpu_renderer::render(const fractal_scene& scene, basin_map& target) {
+		if (target.iterations.size() != target.width * target.height) {
+			throw std::invalid_argument("The target basin map's pixel count doesn't match its dimensions.");
+		}
+		if (scene.zeros.size() >= basin_map::no_zero) {
+			throw std::invalid_argument("A basin map has room for the indices of at most 65534 zeros.");
+		}
+		target.zero_count = scene.zeros.size();
+		target.iteration_budget = scene.iteration_count;
+		// Bytes, so that the map is half the size of the image for the scenes anyone looks at
+		target.index_bits = scene.zeros.size() < 0xff ? 8 : 16;
+		target.basins.resize(target.width * target.height * target.index_bits / 8);
+		const bool wide = target.index_bits == 16;
+
+		return render_tiles(scene, target.width, target.height, 0, target.height,
+			[&](size_t x_begin, size_t y_begin, std::uint32_t tile_width, std::uint32_t tile_height, const tile_scratch& tile) {
+				for (std::uint32_t y = 0; y < tile_height; ++y) {
+					const size_t row = (y_begin + y) * target.width + x_begin;
+					for (std::uint32_t x = 0; x < tile_width; ++x) {
+						const auto basin = tile.basins[y * tile_size + x];
+						const std::uint16_t index = basin == no_zero ? basin_map::no_zero : static_cast<std::uint16_t>(basin);
+						if (wide) {
+							target.basins[2 * (row + x)] = static_cast<std::uint8_t>(index);
+							target.basins[2 * (row + x) + 1] = static_cast<std::uint8_t>(index >> 8);
+						}
+						else target.basins[row + x] = static_cast<std::uint8_t>(index);
+						target.iterations[row + x] = tile.pixel_iterations[y * tile_size + x];
+					}
+				}
+			});
+	}
+
+	template<typename tile_store>
+	render_statistics cpu_renderer::render_tiles(const fractal_scene& scene, size_t width, size_t height, size_t first_row,
+		size_t image_height, tile_store&& store) {
+		if (scene.zeros.empty()) {
+			throw std::invalid_argument("The scene needs at least one zero.");
+		}
+		if (scene.evaluation == evaluation_mode::coefficients && scene.coefficients.size() != scene.zeros.size() + 1) {
+			throw std::invalid_argument("The scene needs one more coefficient than zeros.");
+		}
+
+		if (first_row + height > image_height) {
+			throw std::invalid_argument("The rows to render run past the bottom of the image.");
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+
+		const size_t tiles_x = (width + tile_size - 1) / tile_size;
+		const size_t tiles_y = (height + tile_size - 1) / tile_size;
+
+		const auto& transform = scene.screen_to_fractal_space;
+
+		// Only one of these is used, depending on the evaluation mode
+		const std::optional<newton_polynomial> polynomial = scene.evaluation == evaluation_mode::coefficients
+			? std::optional<newton_polynomial>(scene.coefficients) : std::nullopt;
+		const newton_zeros zeros(scene.zeros);
+		// For classifying the pixels and for the exit radius, both without comparing against every zero
+		const double classification_radius = std::sqrt(scene.epsilon_squared);
+		const zero_index index(scene.zeros, classification_radius);
+
+		const bool double_double_points = scene.precision == precision_mode::double_double
+			|| (scene.precision == precision_mode::automatic && needs_double_double(transform, width, image_height));
+		if (double_double_points && scene.method != iteration_method::newton) {
+			throw std::invalid_argument("Only Newton's method is iterated in double-double, which this zoom needs.");
+		}
+
+		// What make_newton_exit works out, but from the grid rather than by comparing every pair of zeros
+		const newton_exit exit = scene.early_exit
+			? newton_exit{ scene.iteration_count, std::min(scene.epsilon_squared, index.closest_pair_distance_squared() / 16.0), scene.step_squared }
+			: newton_exit{ scene.iteration_count };
+		for (auto& worker_scratch : scratch) {
+			worker_scratch.histogram.assign(static_cast<size_t>(scene.iteration_count) + 1, 0);
+		}
+
+		std::atomic<size_t> evaluated_pixels = 0;
+
+		pool.run(tiles_x * tiles_y, [&](size_t tile_index, unsigned worker_index) {
+			const size_t x_begin = (tile_index % tiles_x) * tile_size;
+			const size_t y_begin = (tile_index / tiles_x) * tile_size;
+			const auto tile_width = static_cast<std::uint32_t>(std::min(x_begin + tile_size, width) - x_begin);
+			const auto tile_height = static_cast<std::uint32_t>(std::min(y_begin + tile_size, height) - y_begin);
+
+			auto& worker_scratch = scratch[worker_index];
+			auto& real = worker_scratch.real;
+			auto& imag = worker_scratch.imag;
+			auto& real_low = worker_scratch.real_low;
+			auto& imag_low = worker_scratch.imag_low;
+			auto& iterations = worker_scratch.iterations;
+			auto& histogram = worker_scratch.histogram;
+			auto& basins = worker_scratch.basins;
+			auto& pixel_iterations = worker_scratch.pixel_iterations;
+			auto& pending = worker_scratch.pending;
+			auto& rectangles = worker_scratch.rectangles;
+			std::fill(basins.begin(), basins.end(), unknown_basin);
+			std::fill(pixel_iterations.begin(), pixel_iterations.end(), basin_map::not_iterated);
+
+			const auto queue = [&](std::uint32_t x, std::uint32_t y) {
+				const std::uint32_t local = y * static_cast<std::uint32_t>(tile_size) + x;
+				if (basins[local] == unknown_basin) {
+					basins[local] = pending_basin;
+					pending.push_back(local);
+				}
+			};
+
+			// Iterates the queued pixels in one go, so the vector kernels get as long a run as there is
+			const auto evaluate_pending = [&] {
+				if (double_double_points) {
+					const double_double translation_x(transform[2][0], scene.translation_low.x);
+					const double_double translation_y(transform[2][1], scene.translation_low.y);
+					for (size_t point = 0; point < pending.size(); ++point) {
+						const double screen_x = static_cast<double>(x_begin + pending[point] % tile_size) + 0.5;
+						const double screen_y = static_cast<double>(first_row + y_begin + pending[point] / tile_size) + 0.5;
+						const auto z_real = translation_x + two_product(transform[0][0], screen_x) + two_product(transform[1][0], screen_y);
+						const auto z_imag = translation_y + two_product(transform[0][1], screen_x) + two_product(transform[1][1], screen_y);
+						real[point] = z_real.hi;
+						real_low[point] = z_real.lo;
+						imag[point] = z_imag.hi;
+						imag_low[point] = z_imag.lo;
+					}
+
+					if (polynomial) {
+						double_double_kernel(*polynomial, zeros, exit, real.data(), real_low.data(), imag.data(), imag_low.data(),
+							iterations.data(), pending.size());
+					}
+					else {
+						double_double_product_kernel(zeros, exit, real.data(), real_low.data(), imag.data(), imag_low.data(),
+							iterations.data(), pending.size());
+					}
+				}
+				else {
+					for (size_t point = 0; point < pending.size(); ++point) {
+						// Sample pixel centers, like the rasterizer does
+						const double screen_x = static_cast<double>(x_begin + pending[point] % tile_size) + 0.5;
+						const double screen_y = static_cast<double>(first_row + y_begin + pending[point] / tile_size) + 0.5;
+						real[point] = transform[0][0] * screen_x + transform[1][0] * screen_y + transform[2][0];
+						imag[point] = transform[0][1] * screen_x + transform[1][1] * screen_y + transform[2][1];
+					}
+
+					if (scene.method != iteration_method::newton) {
+						if (polynomial) {
+							higher_order_iterate_scalar(scene.method, *polynomial, zeros, exit, real.data(), imag.data(), iterations.data(), pending.size());
+						}
+						else {
+							higher_order_iterate_product_form_scalar(scene.method, zeros, exit, real.data(), imag.data(), iterations.data(), pending.size());
+						}
+					}
+					else if (polynomial) {
+						kernel(*polynomial, zeros, exit, real.data(), imag.data(), iterations.data(), pending.size());
+					}
+					else {
+						product_kernel(zeros, exit, real.data(), imag.data(), iterations.data(), pending.size());
+					}
+				}
+
+				for (size_t point = 0; point < pending.size(); ++point) {
+					// The nearest zero within epsilon, in case the zeros are closer together than that
+					const auto basin = index.classify({ real[point], imag[point] }, classification_radius);
+					basins[pending[point]] = basin ? static_cast<std::uint32_t>(*basin) : no_zero;
+					pixel_iterations[pending[point]] = static_cast<std::uint8_t>(std::min(iterations[point], unsigned{ basin_map::not_iterated - 1 }));
+					++histogram[iterations[point]];
+				}
+				evaluated_pixels.fetch_add(pending.size(), std::memory_order_relaxed);
+				pending.clear();
+			};
+
+			const auto basin_at = [&](std::uint32_t x, std::uint32_t y) {
+				return basins[y * tile_size + x];
+			};
+
+			if (!subdivide) {
+				for (std::uint32_t y = 0; y < tile_height; ++y) {
+					for (std::uint32_t x = 0; x < tile_width; ++x) {
+						queue(x, y);
+					}
+				}
+				evaluate_pending();
+			}
+			else {
+				auto& next_rectangles = worker_scratch.next_rectangles;
+				auto& fill_candidates = worker_scratch.fill_candidates;
+				rectangles.clear();
+				rectangles.push_back({ 0, 0, tile_width - 1, tile_height - 1 });
+
+				const auto queue_interior = [&](const tile_scratch::rectangle& rectangle) {
+					for (std::uint32_t y = rectangle.top + 1; y < rectangle.bottom; ++y) {
+						for (std::uint32_t x = rectangle.left + 1; x < rectangle.right; ++x) {
+							queue(x, y);
+						}
+					}
+				};
+
+				// Small rectangles are iterated whole, along with the next batch. Larger ones are split in two along
+				// the longer side, the halves sharing the dividing row or column so that it's only iterated once.
+				const auto split = [&](const tile_scratch::rectangle& rectangle) {
+					const auto [left, top, right, bottom] = rectangle;
+					if (static_cast<size_t>(right - left + 1) * (bottom - top + 1) < subdivision_minimum_area) {
+						queue_interior(rectangle);
+					}
+					else if (right - left >= bottom - top) {
+						const std::uint32_t middle = (left + right) / 2;
+						next_rectangles.push_back({ left, top, middle, bottom });
+						next_rectangles.push_back({ middle, top, right, bottom });
+					}
+					else {
+						const std::uint32_t middle = (top + bottom) / 2;
+						next_rectangles.push_back({ left, top, right, middle });
+						next_rectangles.push_back({ left, middle, right, bottom });
+					}
+				};
+
+				while (!rectangles.empty()) {
+					// Edges shared with an earlier rectangle are already known, and queue skips them
+					for (const auto [left, top, right, bottom] : rectangles) {
+						for (std::uint32_t x = left; x <= right; ++x) {
+							queue(x, top);
+							queue(x, bottom);
+						}
+						for (std::uint32_t y = top + 1; y < bottom; ++y) {
+							queue(left, y);
+							queue(right, y);
+						}
+					}
+					evaluate_pending();
+
+					for (const auto& rectangle : rectangles) {
+						const auto [left, top, right, bottom] = rectangle;
+						// No interior to speak of
+						if (right - left < 2 || bottom - top < 2) continue;
+
+						const auto basin = basin_at(left, top);
+						bool uniform = basin != no_zero;
+						for (std::uint32_t x = left; uniform && x <= right; ++x) {
+							uniform = basin_at(x, top) == basin && basin_at(x, bottom) == basin;
+						}
+						for (std::uint32_t y = top + 1; uniform && y < bottom; ++y) {
+							uniform = basin_at(left, y) == basin && basin_at(right, y) == basin;
+						}
+
+						if (uniform) {
+							queue((left + right) / 2, (top + bottom) / 2);
+							fill_candidates.push_back(rectangle);
+						}
+						else {
+							split(rectangle);
+						}
+					}
+					evaluate_pending();
+
+					// The guard: the center has to agree with the border too. If it doesn't, it lies on the dividing
+					// line of the split, so it's not lost.
+					for (const auto& rectangle : fill_candidates) {
+						const auto [left, top, right, bottom] = rectangle;
+						const auto basin = basin_at(left, top);
+						if (basin_at((left + right) / 2, (top + bottom) / 2) != basin) {
+							split(rectangle);
+							continue;
+						}
+						for (std::uint32_t y = top + 1; y < bottom; ++y) {
+							for (std::uint32_t x = left + 1; x < right; ++x) {
+								basins[y * tile_size + x] = basin;
+							}
+						}
+					}
+
+					fill_candidates.clear();
+					std::swap(rectangles, next_rectangles);
+					next_rectangles.clear();
+				}
+				evaluate_pending();
+			}
+
+			store(x_begin, y_begin, tile_width, tile_height, worker_scratch);
+		});
+
+		render_statistics statistics;
+		statistics.elapsed = std::chrono::steady_clock::now() - start;
+		statistics.pixel_count = width * height;
+		statistics.evaluated_pixels = evaluated_pixels;
+		statistics.tile_count = tiles_x * tiles_y;
+		statistics.stolen_tiles = pool.last_steal_count();
+		statistics.thread_count = pool.thread_count();
+		statistics.isa = scene.method == iteration_method::newton ? isa : instruction_set::scalar;
+		statistics.precision = double_double_points ? precision_mode::double_double : precision_mode::standard;
+		statistics.iterations.budget = scene.iteration_count;
+		statistics.iterations.counts.assign(static_cast<size_t>(scene.iteration_count) + 1, 0);
+		for (const auto& worker_scratch : scratch) {
+			for (size_t n = 0; n < worker_scratch.histogram.size(); ++n) {
+				statistics.iterations.counts[n] += worker_scratch.histogram[n];
+			}
+		}
+		return statistics;
+	}
+
+	unsigned cpu_renderer::thread_count() const noexcept {
+		return pool.thread_count();
+	}
+
+	thread_pool& cpu_renderer::worker_pool() noexcept {
+		return pool;
+	}
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <chrono>
+#include <cstdint>
+#define GLM_FORCE_SWIZZLE
+#include <glm/glm.hpp>
+
+#include "thread_pool.hpp"
+#include "newton_kernel.hpp"
+#include "newton_kernel_double_double.hpp"
+
+namespace euleristic {
+
+	// Everything needed to shade a frame of the fractal, independent of any window or OpenGL context.
+	struct fractal_scene {
+		std::vector<std::complex<double>> zeros;
+		std::vector<std::complex<double>> coefficients;
+		// Maps pixel coordinates (origin in the top left corner, y pointing down) of the target image to fractal space
+		glm::dmat3 screen_to_fractal_space{ 1.0 };
+		// The low parts of screen_to_fractal_space's translation, which places the viewport of a deep zoom to
+		// double-double precision. Only double-double rendering uses it.
+		glm::dvec2 translation_low{ 0.0 };
+		precision_mode precision = precision_mode::automatic;
+		// The most Newton steps a pixel gets
+		unsigned iteration_count = 20;
+		double epsilon_squared = 0.1;
+		// Stop iterating a pixel as soon as it is within epsilon of a zero, or its step is shorter than sqrt(step_squared).
+		// Turning this off iterates every pixel the full iteration_count, which is what the colors used to be based on.
+		bool early_exit = true;
+		double step_squared = 1e-24;
+		// In product form the coefficients aren't used, and may be left empty
+		evaluation_mode evaluation = evaluation_mode::coefficients;
+		// The methods other than Newton's are only iterated in double, by the scalar kernels
+		iteration_method method = iteration_method::newton;
+	};
+
+	// The transform fractal_window starts out with, for an image of the given size: center in the middle of the image,
+	// pixels_per_unit pixels per unit in fractal space, and fractal space's y axis pointing up.
+	glm::dmat3 make_screen_to_fractal_space(size_t width, size_t height, std::complex<double> center, double pixels_per_unit) noexcept;
+
+	// Like make_screen_to_fractal_space, but with the center to double-double precision, for zooms too deep to place
+	// with a double. Sets both scene.screen_to_fractal_space and scene.translation_low.
+	void set_viewport(fractal_scene& scene, size_t width, size_t height, double_double center_real, double_double center_imag,
+		double pixels_per_unit) noexcept;
+
+	// Automatic precision switches to double-double once a pixel is smaller than this, relative to the largest coordinate
+	// in the image. That leaves 16 of a double's 52 bits for telling apart points within a pixel, and for the Newton
+	// steps to lose: past about 2^-45, neighbouring pixels start landing on the same double and the image turns blocky.
+	constexpr double deep_zoom_threshold = 1.0 / (1ull << 36);
+
+	bool needs_double_double(const glm::dmat3& screen_to_fractal_space, size_t width, size_t height) noexcept;
+
+	// An 8 bit RGBA framebuffer, row major with the top row first.
+	struct image {
+		size_t width{}, height{};
+		std::vector<glm::u8vec4> pixels;
+
+		image() = default;
+		image(size_t width, size_t height);
+	};
+
+	// Which zero each pixel converged to, and how many steps it took to get there, rather than its color. The colors can
+	// be applied later, in a pass far cheaper than rendering (see basin_map_io.hpp). With fewer than 255 zeros a pixel
+	// takes 2 bytes rather than 4, and 3 with more.
+	struct basin_map {
+		// In basins, for pixels not converging to any zero, at either width
+		static constexpr std::uint16_t no_zero = 0xffff;
+		// In iterations, for pixels subdivision filled in without iterating. Counts saturate just below.
+		static constexpr std::uint8_t not_iterated = 0xff;
+
+		size_t width{}, height{};
+		// Row major with the top row first, like image. The indices are laid out like a basin map file's index plane,
+		// index_bits each and little-endian, which render picks from the zero count and sizes basins for.
+		unsigned index_bits = 8;
+		std::vector<std::uint8_t> basins;
+		std::vector<std::uint8_t> iterations;
+		// Of the scene it was rendered from, for whoever colors it
+		size_t zero_count{};
+		unsigned iteration_budget{};
+
+		basin_map() = default;
+		basin_map(size_t width, size_t height);
+	};
+
+	// How many Newton steps the iterated pixels took: counts[n] pixels took n steps, so the ones that used up the
+	// whole budget are at counts[budget].
+	struct iteration_histogram {
+		unsigned budget{};
+		std::vector<size_t> counts;
+
+		size_t pixel_count() const noexcept;
+		double mean() const noexcept;
+		// The least step count that at least the given share of the pixels, in [0, 1], needed no more than
+		unsigned percentile(double share) const noexcept;
+		// Steps taken over the steps a full iteration_count for every pixel would have taken
+		double budget_used() const noexcept;
+	};
+
+	struct render_statistics {
+		size_t pixel_count{};
+		// Pixels actually run through the Newton kernel. The rest were filled in by subdivision.
+		size_t evaluated_pixels{};
+		size_t tile_count{};
+		size_t stolen_tiles{};
+		unsigned thread_count{};
+		// What the kernels used, which is scalar for the higher order methods
+		instruction_set isa{};
+		// Which of standard or double_double the scene was rendered in
+		precision_mode precision{};
+		std::chrono::duration<double> elapsed{};
+		// Of the iterated pixels only, not of the ones subdivision filled in
+		iteration_histogram iterations;
+
+		double megapixels_per_second() const noexcept;
+		// The share of the pixels subdivision spared from iterating, in [0, 1]
+		double subdivision_saving() const noexcept;
+	};
+
+	// Renders Newton's fractal on the CPU, doing per pixel what fractal_fragment_shader_template.glsl does.
+	// The image is cut into square tiles which are spread over a work stealing thread pool, and each tile is iterated
+	// by the widest Newton kernel the CPU supports.
+	//
+	// Unless subdivision is turned off, each tile is rendered Mariani-Silver style: only the border of a rectangle is
+	// iterated, and if all of it lands in the same basin, the interior is filled without iterating it. Otherwise the
+	// rectangle is split in two along its longer side and each half gets the same treatment. Newton basins aren't
+	// guaranteed to be simply connected, so as a guard the center pixel is iterated too and has to agree before a fill,
+	// and pixels not converging to any zero are never filled.
+	class cpu_renderer {
+		thread_pool pool;
+		size_t tile_size;
+		instruction_set isa;
+		newton_kernel kernel;
+		product_form_kernel product_kernel;
+		newton_kernel_double_double double_double_kernel;
+		product_form_kernel_double_double double_double_product_kernel;
+
+		// Per worker scratch space
+		struct tile_scratch {
+			// The points being iterated, real and imaginary parts apart, and how many steps each took. The low parts
+			// are only used in double-double.
+			std::vector<double> real, imag, real_low, imag_low;
+			std::vector<unsigned> iterations;
+			// Summed over all the tiles the worker rendered
+			std::vector<size_t> histogram;
+			// Which zero each pixel of the tile converged to, row major with a stride of tile_size
+			std::vector<std::uint32_t> basins;
+			// How many steps each iterated pixel of the tile took, saturated, laid out like basins
+			std::vector<std::uint8_t> pixel_iterations;
+			// Tile local indices of the pixels waiting to be iterated
+			std::vector<std::uint32_t> pending;
+			// Rectangles in tile local pixels, last row and column included. Subdivision goes a generation at a time,
+			// so that the borders of all rectangles of a generation make a single batch for the kernel.
+			struct rectangle { std::uint32_t left, top, right, bottom; };
+			std::vector<rectangle> rectangles, next_rectangles, fill_candidates;
+		};
+		std::vector<tile_scratch> scratch;
+
+		// Renders the tiles, handing each to store(x_begin, y_begin, tile_width, tile_height, scratch) once its basins are known
+		template<typename tile_store>
+		render_statistics render_tiles(const fractal_scene& scene, size_t width, size_t height, size_t first_row, size_t image_height,
+			tile_store&& store);
+
+	public:
+		// Rectangles with fewer pixels than this are just iterated whole rather than split further
+		static constexpr size_t subdivision_minimum_area = 16;
+
+		// Turn off to iterate every pixel, for reference images or for comparing against
+		bool subdivide = true;
+
+		// A thread count of 0 means one thread per hardware thread.
+		explicit cpu_renderer(unsigned thread_count = 0, size_t tile_size = 32,
+			instruction_set isa = best_supported_instruction_set());
+
+		render_statistics render(const fractal_scene& scene, image& target);
+		// Renders the rows from first_row on of an image image_height tall, as wide as target, into target. That's
+		// for images too large to hold in memory, which are rendered and written a band at a time. The pixels come out
+		// exactly as a whole render's would, as long as first_row is a multiple of the tile size: the tiles then line up
+		// with the whole image's, and subdivision makes the same choices.
+		render_statistics render_rows(const fractal_scene& scene, image& target, size_t first_row, size_t image_height);
+		// The same, but only which zero each pixel converged to and how many steps it took. Needs fewer than 65535 zeros.
+		render_statistics render(const fractal_scene& scene, basin_map& target);
+
+		unsigned thread_count() const noexcept;
+		// For other parallel work between frames, like finding the zeros of a polynomial given by its coefficients
+		thread_pool& worker_pool() noexcept;
+	};
+}
@@ -0,0 +1,124 @@
+#include "double_double.hpp"
+
+#include <vector>
+#include <format>
+
+namespace euleristic {
+
+	std::optional<double_double> parse_double_double(std::string_view text) noexcept {
+		size_t position = 0;
+		const bool negative = !text.empty() && text[0] == '-';
+		if (!text.empty() && (text[0] == '-' || text[0] == '+')) ++position;
+
+		// The digits are accumulated as an integer, and the decimal point and exponent applied at the end. Digits past
+		// what a double-double can hold only count towards the exponent.
+		constexpr int max_significant_digits = 36;
+		double_double mantissa{};
+		int significant_digits = 0;
+		int exponent = 0;
+		bool any_digits = false, seen_point = false;
+		for (; position < text.size(); ++position) {
+			const char character = text[position];
+			if (character == '.' && !seen_point) {
+				seen_point = true;
+				continue;
+			}
+			if (character < '0' || character > '9') break;
+			any_digits = true;
+
+			if (significant_digits < max_significant_digits) {
+				if (significant_digits > 0 || character != '0') {
+					mantissa = mantissa * 10.0 + static_cast<double>(character - '0');
+					++significant_digits;
+				}
+				if (seen_point) --exponent;
+			}
+			else if (!seen_point) {
+				++exponent;
+			}
+		}
+		if (!any_digits) return {};
+
+		if (position < text.size() && (text[position] == 'e' || text[position] == 'E')) {
+			++position;
+			const bool negative_exponent = position < text.size() && text[position] == '-';
+			if (position < text.size() && (text[position] == '-' || text[position] == '+')) ++position;
+			if (position == text.size()) return {};
+			int written_exponent = 0;
+			for (; position < text.size() && text[position] >= '0' && text[position] <= '9'; ++position) {
+				written_exponent = written_exponent * 10 + (text[position] - '0');
+				if (written_exponent > 1000) return {};
+			}
+			exponent += negative_exponent ? -written_exponent : written_exponent;
+		}
+		if (position != text.size()) return {};
+
+		// 10^|exponent| by squaring. Powers up to 10^22 are exact in a double, and the rest lose a few ulps of a double-double.
+		double_double scale = 1.0, power = 10.0;
+		for (int remaining = exponent < 0 ? -exponent : exponent; remaining > 0; remaining /= 2) {
+			if (remaining % 2 == 1) scale *= power;
+			power *= power;
+		}
+		const auto value = exponent < 0 ? mantissa / scale : mantissa * scale;
+		return negative ? -value : value;
+	}
+
+	std::string to_string(double_double value, int significant_digits) {
+		if (value.hi == 0.0 || !std::isfinite(value.hi)) return std::format("{}", value.hi);
+		std::string text = value.hi < 0.0 ? "-" : "";
+		if (value.hi < 0.0) value = -value;
+
+		// Scaled into [1, 10), the digits come off the front one at a time
+		int exponent = static_cast<int>(std::floor(std::log10(value.hi)));
+		double_double scale = 1.0, power = 10.0;
+		for (int remaining = exponent < 0 ? -exponent : exponent; remaining > 0; remaining /= 2) {
+			if (remaining % 2 == 1) scale *= power;
+			power *= power;
+		}
+		value = exponent < 0 ? value * scale : value / scale;
+		if (value.hi >= 10.0) {
+			value = value / 10.0;
+			++exponent;
+		}
+		else if (value.hi < 1.0) {
+			value = value * 10.0;
+			--exponent;
+		}
+
+		// Taking floor of the high part can overshoot by one when the low part is negative, which shows up as a
+		// negative digit next, so the digits are normalized afterwards along with the rounding carry
+		std::vector<int> digits;
+		for (int i = 0; i <= significant_digits; ++i) {
+			const double digit = std::floor(value.hi);
+			digits.push_back(static_cast<int>(digit));
+			value = (value - digit) * 10.0;
+		}
+		if (digits.back() >= 5) ++digits[digits.size() - 2];
+		digits.pop_back();
+		for (size_t i = digits.size() - 1; i > 0; --i) {
+			while (digits[i] < 0) {
+				digits[i] += 10;
+				--digits[i - 1];
+			}
+			while (digits[i] >= 10) {
+				digits[i] -= 10;
+				++digits[i - 1];
+			}
+		}
+		if (digits.front() >= 10) {
+			digits.front() -= 10;
+			digits.insert(digits.begin(), 1);
+			digits.pop_back();
+			++exponent;
+		}
+		while (digits.size() > 1 && digits.back() == 0) digits.pop_back();
+
+		text += static_cast<char>('0' + digits.front());
+		if (digits.size() > 1) {
+			text += '.';
+			for (size_t i = 1; i < digits.size(); ++i) text += static_cast<char>('0' + digits[i]);
+		}
+		if (exponent != 0) text += std::format("e{}", exponent);
+		return text;
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <optional>
+#include <string_view>
+
+namespace euleristic {
+
+	// An unevaluated sum hi + lo of two doubles with |lo| <= ulp(hi) / 2, which carries about 106 bits of mantissa.
+	// That's what deep zooms need: a double runs out of bits for telling neighbouring pixels apart once they are
+	// about 1e-16 of the coordinates' magnitude apart, a double-double around 1e-32.
+	//
+	// The algorithms are the usual error free transformations (Dekker, Knuth, and Hida, Li and Bailey's QD library),
+	// with FMA for the exact products. They depend on every operation being rounded exactly as written, so nothing
+	// that includes this may be compiled with /fp:fast or -ffast-math.
+	struct double_double {
+		double hi{}, lo{};
+
+		double_double() = default;
+		constexpr double_double(double value) noexcept : hi(value) {}
+		constexpr double_double(double hi, double lo) noexcept : hi(hi), lo(lo) {}
+	};
+
+	// a + b exactly, for any a and b
+	inline double_double two_sum(double a, double b) noexcept {
+		const double sum = a + b;
+		const double b_virtual = sum - a;
+		return { sum, (a - (sum - b_virtual)) + (b - b_virtual) };
+	}
+
+	// a + b exactly, if |a| >= |b|
+	inline double_double quick_two_sum(double a, double b) noexcept {
+		const double sum = a + b;
+		return { sum, b - (sum - a) };
+	}
+
+	// a * b exactly
+	inline double_double two_product(double a, double b) noexcept {
+		const double product = a * b;
+		return { product, std::fma(a, b, -product) };
+	}
+
+	inline double_double operator-(double_double a) noexcept {
+		return { -a.hi, -a.lo };
+	}
+
+	// The careful sum, which stays accurate when a and b nearly cancel, as they do in every converging Newton step
+	inline double_double operator+(double_double a, double_double b) noexcept {
+		auto high = two_sum(a.hi, b.hi);
+		const auto low = two_sum(a.lo, b.lo);
+		high.lo += low.hi;
+		high = quick_two_sum(high.hi, high.lo);
+		high.lo += low.lo;
+		return quick_two_sum(high.hi, high.lo);
+	}
+
+	inline double_double operator-(double_double a, double_double b) noexcept {
+		return a + -b;
+	}
+
+	// A sum that is accurate relative to the larger of |a| and |b|, rather than to |a + b|, in about half the
+	// operations. That's all that Horner's method and the Newton step need, since their errors are measured against
+	// the size of the terms anyway.
+	inline double_double sloppy_add(double_double a, double_double b) noexcept {
+		auto sum = two_sum(a.hi, b.hi);
+		sum.lo += a.lo + b.lo;
+		return quick_two_sum(sum.hi, sum.lo);
+	}
+
+	inline double_double sloppy_subtract(double_double a, double_double b) noexcept {
+		return sloppy_add(a, -b);
+	}
+
+	inline double_double operator*(double_double a, double_double b) noexcept {
+		auto product = two_product(a.hi, b.hi);
+		product.lo += a.hi * b.lo + a.lo * b.hi;
+		return quick_two_sum(product.hi, product.lo);
+	}
+
+	inline double_double operator*(double_double a, double b) noexcept {
+		auto product = two_product(a.hi, b);
+		product.lo += a.lo * b;
+		return quick_two_sum(product.hi, product.lo);
+	}
+
+	// Long division with one correction, accurate to a few ulps of a double-double
+	inline double_double operator/(double_double a, double_double b) noexcept {
+		const double first = a.hi / b.hi;
+		const auto remainder = sloppy_subtract(a, b * first);
+		return quick_two_sum(first, remainder.hi / b.hi);
+	}
+
+	inline double_double& operator+=(double_double& a, double_double b) noexcept { return a = a + b; }
+	inline double_double& operator-=(double_double& a, double_double b) noexcept { return a = a - b; }
+	inline double_double& operator*=(double_double& a, double_double b) noexcept { return a = a * b; }
+
+	// Parses a decimal number such as -0.743643887037158704752191506114774 to full double-double precision, which
+	// std::from_chars can't do. Returns nothing unless all of text is a number.
+	std::optional<double_double> parse_double_double(std::string_view text) noexcept;
+
+	// The other way around: value in scientific notation to the given number of significant digits, trailing zeros
+	// dropped, which parse_double_double reads back to within an ulp or so of a double-double
+	std::string to_string(double_double value, int significant_digits = 32);
+}
@@ -0,0 +1,18 @@
+# Writes a file's bytes as a comma separated list, for embedded_shaders.cpp to #include into an array initializer.
+# Run by the custom build step on each .glsl in interactive_newtons_fractal.vcxproj.
+param(
+	[Parameter(Mandatory = $true)][string]$Source,
+	[Parameter(Mandatory = $true)][string]$Destination
+)
+
+$ErrorActionPreference = 'Stop'
+
+$bytes = [System.IO.File]::ReadAllBytes($Source)
+$lines = [System.Collections.Generic.List[string]]::new()
+for ($i = 0; $i -lt $bytes.Length; $i += 32) {
+	$last = [Math]::Min($i + 32, $bytes.Length) - 1
+	$lines.Add((($bytes[$i..$last] | ForEach-Object { $_.ToString() }) -join ',') + ',')
+}
+
+New-Item -ItemType Directory -Force -Path (Split-Path -Parent $Destination) | Out-Null
+[System.IO.File]::WriteAllLines($Destination, $lines)
@@ -0,0 +1,35 @@
+#include "embedded_shaders.hpp"
+
+namespace euleristic {
+
+	// Each .inc is the .glsl's bytes as a comma separated list, generated into the intermediate directory by the custom
+	// build step on the .glsl. A byte array rather than a string literal, because MSVC caps string literals at 64 KiB.
+
+	constexpr unsigned char fractal_vertex_shader_bytes[] = {
+#include "fractal_vertex_shader.glsl.inc"
+	};
+	constexpr unsigned char fractal_fragment_shader_bytes[] = {
+#include "fractal_fragment_shader_template.glsl.inc"
+	};
+	constexpr unsigned char zeros_vertex_shader_bytes[] = {
+#include "zeros_vertex_shader.glsl.inc"
+	};
+	constexpr unsigned char zeros_fragment_shader_bytes[] = {
+#include "zeros_fragment_shader_template.glsl.inc"
+	};
+
+	template<size_t size>
+	std::string_view as_source(const unsigned char (&bytes)[size]) noexcept {
+		return { reinterpret_cast<const char*>(bytes), size };
+	}
+
+	std::string_view source_of(embedded_shader shader) noexcept {
+		switch (shader) {
+		case embedded_shader::fractal_vertex: return as_source(fractal_vertex_shader_bytes);
+		case embedded_shader::fractal_fragment: return as_source(fractal_fragment_shader_bytes);
+		case embedded_shader::zeros_vertex: return as_source(zeros_vertex_shader_bytes);
+		case embedded_shader::zeros_fragment: return as_source(zeros_fragment_shader_bytes);
+		default: return {};
+		}
+	}
+}
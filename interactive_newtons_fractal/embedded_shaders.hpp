@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string_view>
+
+namespace euleristic {
+
+	enum class embedded_shader {
+		fractal_vertex,
+		fractal_fragment, // fractal_fragment_shader_template.glsl
+		zeros_vertex,
+		zeros_fragment // zeros_fragment_shader_template.glsl, with TEMPLATE_RADIUS_SQR still to fill in
+	};
+
+	// The GLSL files, compiled into the executable by embed_shader.ps1 when it's built, so that it runs from any
+	// directory and doesn't touch the disk for them at startup. Editing a shader means building again.
+	std::string_view source_of(embedded_shader shader) noexcept;
+}
@@ -2,20 +2,48 @@
 
 // This shader renders a Newton's fractal.
 // It does this by seeing what zero the seed value represented by the pixel approaches under Newton's method, coloring it accordingly.
-// If the iterated value is not within the allowed error sqrt(TEMPLATE_EPSILON_SQR) of a zero after TEMPLATE_ITERATION_COUNT iterations,
-// the pixel is left black.
+// If the iterated value is not within the allowed error sqrt(epsilon_squared) of a zero after at most iteration_count iterations,
+// the pixel is left black. Iteration stops early once the value is within sqrt(exit_epsilon_squared) of a zero, or once a step
+// is shorter than sqrt(step_squared), which is after a handful of iterations for most pixels. Both are 0 to never stop early.
+// The zeros, coefficients and colors come from buffer textures, which have room for tens of thousands of zeros where uniform
+// arrays ran out at a few hundred. Which zero a point is near is looked up in a uniform grid over the zeros (zero_index.hpp),
+// whose cells each list the few zeros that can be nearest to a point in them, rather than by measuring the distance to every zero.
+// Past where double can tell the pixels apart, the points are iterated in double-double instead (double_double_points).
 
 in vec2 render_space_position;
 
 out vec4 frag_color;
 
 uniform dvec4 fractal_space_screen_rect; // Where xy is center and zw is half in positive x and positive y
-uniform dvec2 coefficients[TEMPLATE_DEGREE + 1];
-uniform dvec2 zeros[TEMPLATE_DEGREE];
+uniform dvec2 fractal_space_screen_center_low; // What's left of the center after rounding it to double, for double_double_points
+uniform bool double_double_points; // Iterate in double-double, for zooms too deep for double to tell the pixels apart
+uniform int degree;
+uniform int iteration_count;
+uniform double epsilon_squared;
+uniform double exit_epsilon_squared;
+uniform double step_squared;
+uniform usamplerBuffer zeros; // A dvec2 per texel, each double as its low and high 32 bits
+uniform usamplerBuffer coefficients; // The same, lowest power first
+uniform samplerBuffer colors; // By zero index
+uniform isamplerBuffer grid_cell_offsets; // The candidates of cell x + y * grid_size.x start at grid_cell_offsets[cell], and end where the next cell's start
+uniform isamplerBuffer grid_candidates;
+uniform dvec2 grid_origin; // The grid's lower left corner
+uniform double grid_inverse_cell_size;
+uniform ivec2 grid_size;
+uniform bool evaluate_from_zeros; // Product form Newton steps, which don't need the coefficients
 
-const vec4 colors[TEMPLATE_DEGREE] = {
-	TEMPLATE_COLOR_LIST
-};
+dvec2 fetch_dvec2(usamplerBuffer buffer, int index) {
+	uvec4 texel = texelFetch(buffer, index);
+	return dvec2(packDouble2x32(texel.xy), packDouble2x32(texel.zw));
+}
+
+dvec2 zero(int i) {
+	return fetch_dvec2(zeros, i);
+}
+
+dvec2 coefficient(int n) {
+	return fetch_dvec2(coefficients, n);
+}
 
 dvec2 conjugate(dvec2 z) {
 	return dvec2(z.x, -z.y);
@@ -29,17 +57,28 @@ dvec2 complex_div(dvec2 numerator, dvec2 denominator) {
 	return complex_mul(numerator, conjugate(denominator)) / (denominator.x * denominator.x + denominator.y * denominator.y); 
 }
 
-dvec2 newton_iterate(dvec2 z) {
+dvec2 newton_step(dvec2 z) {
 	dvec2 p = dvec2(0.0, 0.0);
 	dvec2 p_prime = dvec2(0.0, 0.0);
 	dvec2 accumulated_power = dvec2(1.0, 0.0);
-	for (uint n = 0; n < TEMPLATE_DEGREE; ++n) {
-		p += complex_mul(coefficients[n], accumulated_power);
-		p_prime += (n + 1) * complex_mul(coefficients[n + 1], accumulated_power);
+	for (int n = 0; n < degree; ++n) {
+		p += complex_mul(coefficient(n), accumulated_power);
+		p_prime += (n + 1) * complex_mul(coefficient(n + 1), accumulated_power);
 		accumulated_power = complex_mul(accumulated_power, z);
 	}
-	p += complex_mul(coefficients[TEMPLATE_DEGREE], accumulated_power);
-	return z - complex_div(p, p_prime);
+	p += complex_mul(coefficient(degree), accumulated_power);
+	return complex_div(p, p_prime);
+}
+
+// Since p'/p = sum(1 / (z - zero(i))), the step needs no coefficients. This stays accurate at high degree.
+dvec2 newton_step_from_zeros(dvec2 z) {
+	dvec2 reciprocal_sum = dvec2(0.0, 0.0);
+	for (int i = 0; i < degree; ++i) {
+		reciprocal_sum += complex_div(dvec2(1.0, 0.0), z - zero(i));
+	}
+	dvec2 step = complex_div(dvec2(1.0, 0.0), reciprocal_sum);
+	// Right on a zero, the step is NaN, but the point has converged
+	return any(isnan(step)) ? dvec2(0.0, 0.0) : step;
 }
 
 dvec2 fractal_space_point() {
@@ -47,22 +86,168 @@ dvec2 fractal_space_point() {
 	return fractal_space_screen_rect.xy + dvec2(fractal_space_screen_rect.z * type_casted.x, fractal_space_screen_rect.w * type_casted.y);
 }
 
+// Double-double arithmetic, as in double_double.hpp. A double-double is a dvec2 of high and low parts, and a complex
+// double-double a dvec4 of the real high, real low, imaginary high and imaginary low parts. Everything is precise, since
+// a compiler that reassociates or contracts these turns them back into plain double without a word.
+
+dvec2 two_sum(double a, double b) {
+	precise double sum = a + b;
+	precise double b_virtual = sum - a;
+	precise double error = (a - (sum - b_virtual)) + (b - b_virtual);
+	return dvec2(sum, error);
+}
+
+dvec2 quick_two_sum(double a, double b) {
+	precise double sum = a + b;
+	precise double error = b - (sum - a);
+	return dvec2(sum, error);
+}
+
+dvec2 two_product(double a, double b) {
+	precise double product = a * b;
+	precise double error = fma(a, b, -product);
+	return dvec2(product, error);
+}
+
+// The sloppy sum, like sloppy_add
+dvec2 dd_add(dvec2 a, dvec2 b) {
+	dvec2 sum = two_sum(a.x, b.x);
+	precise double low = sum.y + (a.y + b.y);
+	return quick_two_sum(sum.x, low);
+}
+
+dvec2 dd_mul(dvec2 a, dvec2 b) {
+	dvec2 product = two_product(a.x, b.x);
+	precise double low = product.y + (a.x * b.y + a.y * b.x);
+	return quick_two_sum(product.x, low);
+}
+
+dvec2 dd_mul(dvec2 a, double b) {
+	dvec2 product = two_product(a.x, b);
+	precise double low = product.y + a.y * b;
+	return quick_two_sum(product.x, low);
+}
+
+dvec2 dd_div(dvec2 a, dvec2 b) {
+	precise double first = a.x / b.x;
+	dvec2 remainder = dd_add(a, -dd_mul(b, first));
+	precise double second = remainder.x / b.x;
+	return quick_two_sum(first, second);
+}
+
+dvec4 complex_dd_add(dvec4 lhs, dvec4 rhs) {
+	return dvec4(dd_add(lhs.xy, rhs.xy), dd_add(lhs.zw, rhs.zw));
+}
 
+dvec4 complex_dd_sub(dvec4 lhs, dvec4 rhs) {
+	return complex_dd_add(lhs, -rhs);
+}
 
-vec4 select_color(dvec2 z) {
-	for (int i = 0; i < TEMPLATE_DEGREE; ++i) {
-		dvec2 relative = zeros[i] - z;
-		if (dot(relative, relative) < TEMPLATE_EPSILON_SQR) {
-			return colors[i];
+dvec4 complex_dd_mul(dvec4 lhs, dvec4 rhs) {
+	return dvec4(dd_add(dd_mul(lhs.xy, rhs.xy), -dd_mul(lhs.zw, rhs.zw)), dd_add(dd_mul(lhs.xy, rhs.zw), dd_mul(lhs.zw, rhs.xy)));
+}
+
+// By a complex double, which is what the coefficients are
+dvec4 complex_dd_mul(dvec4 lhs, dvec2 rhs) {
+	return dvec4(dd_add(dd_mul(lhs.xy, rhs.x), -dd_mul(lhs.zw, rhs.y)), dd_add(dd_mul(lhs.xy, rhs.y), dd_mul(lhs.zw, rhs.x)));
+}
+
+dvec4 complex_dd_div(dvec4 numerator, dvec4 denominator) {
+	dvec2 norm = dd_add(dd_mul(denominator.xy, denominator.xy), dd_mul(denominator.zw, denominator.zw));
+	dvec4 product = complex_dd_mul(numerator, dvec4(denominator.xy, -denominator.zw));
+	return dvec4(dd_div(product.xy, norm), dd_div(product.zw, norm));
+}
+
+dvec4 newton_step_double_double(dvec4 z) {
+	dvec4 p = dvec4(0.0);
+	dvec4 p_prime = dvec4(0.0);
+	dvec4 accumulated_power = dvec4(1.0, 0.0, 0.0, 0.0);
+	for (int n = 0; n < degree; ++n) {
+		p = complex_dd_add(p, complex_dd_mul(accumulated_power, coefficient(n)));
+		p_prime = complex_dd_add(p_prime, complex_dd_mul(accumulated_power, (n + 1) * coefficient(n + 1)));
+		accumulated_power = complex_dd_mul(accumulated_power, z);
+	}
+	p = complex_dd_add(p, complex_dd_mul(accumulated_power, coefficient(degree)));
+	return complex_dd_div(p, p_prime);
+}
+
+dvec4 newton_step_from_zeros_double_double(dvec4 z) {
+	dvec4 one = dvec4(1.0, 0.0, 0.0, 0.0);
+	dvec4 reciprocal_sum = dvec4(0.0);
+	for (int i = 0; i < degree; ++i) {
+		reciprocal_sum = complex_dd_add(reciprocal_sum, complex_dd_div(one, complex_dd_sub(z, dvec4(zero(i).x, 0.0, zero(i).y, 0.0))));
+	}
+	dvec4 step = complex_dd_div(one, reciprocal_sum);
+	return any(isnan(step.xz)) ? dvec4(0.0) : step;
+}
+
+dvec4 fractal_space_point_double_double() {
+	dvec2 type_casted = render_space_position;
+	dvec2 real = dd_add(dvec2(fractal_space_screen_rect.x, fractal_space_screen_center_low.x), two_product(fractal_space_screen_rect.z, type_casted.x));
+	dvec2 imag = dd_add(dvec2(fractal_space_screen_rect.y, fractal_space_screen_center_low.y), two_product(fractal_space_screen_rect.w, type_casted.y));
+	return dvec4(real, imag);
+}
+
+
+
+// The index of the nearest zero within sqrt(radius_squared) of z, or -1. The nearest rather than the first, since the
+// zeros may be closer together than that. Only the candidates of z's grid cell can be, and the grid reaches
+// sqrt(epsilon_squared) past the outermost zeros, so anything outside of it is near none.
+int converged_zero(dvec2 z, double radius_squared) {
+	dvec2 cell_position = (z - grid_origin) * grid_inverse_cell_size;
+	// Written so that NaN is outside too
+	if (!(cell_position.x >= 0.0 && cell_position.y >= 0.0 && cell_position.x < double(grid_size.x) && cell_position.y < double(grid_size.y))) {
+		return -1;
+	}
+	int cell = int(cell_position.x) + int(cell_position.y) * grid_size.x;
+	int candidates_end = texelFetch(grid_cell_offsets, cell + 1).x;
+
+	int nearest = -1;
+	for (int candidate = texelFetch(grid_cell_offsets, cell).x; candidate < candidates_end; ++candidate) {
+		int i = texelFetch(grid_candidates, candidate).x;
+		dvec2 relative = zero(i) - z;
+		double distance_squared = dot(relative, relative);
+		if (distance_squared < radius_squared) {
+			nearest = i;
+			radius_squared = distance_squared;
 		}
 	}
-	return vec4(0.0);
+	return nearest;
 }
 
-void main() {
+// Only the points are double-double. Whether they have converged is plenty to tell from the high parts.
+dvec2 iterate_double_double() {
+	dvec4 z = fractal_space_point_double_double();
+	for (int i = 0; i < iteration_count; ++i) {
+		if (exit_epsilon_squared > 0.0 && converged_zero(z.xz, exit_epsilon_squared) >= 0) {
+			break;
+		}
+		dvec4 step = evaluate_from_zeros ? newton_step_from_zeros_double_double(z) : newton_step_double_double(z);
+		z = complex_dd_sub(z, step);
+		if (!(dot(step.xz, step.xz) >= step_squared)) {
+			break;
+		}
+	}
+	return z.xz;
+}
+
+dvec2 iterate() {
 	dvec2 z = fractal_space_point();
-	for (int i = 0; i < TEMPLATE_ITERATION_COUNT; ++i) {
-		z = newton_iterate(z);
+	for (int i = 0; i < iteration_count; ++i) {
+		if (exit_epsilon_squared > 0.0 && converged_zero(z, exit_epsilon_squared) >= 0) {
+			break;
+		}
+		dvec2 step = evaluate_from_zeros ? newton_step_from_zeros(z) : newton_step(z);
+		z -= step;
+		// Written so that NaN stops too
+		if (!(dot(step, step) >= step_squared)) {
+			break;
+		}
 	}
-	frag_color = select_color(z);
+	return z;
+}
+
+void main() {
+	int basin = converged_zero(double_double_points ? iterate_double_double() : iterate(), epsilon_squared);
+	frag_color = basin < 0 ? vec4(0.0) : texelFetch(colors, basin);
 }
\ No newline at end of file
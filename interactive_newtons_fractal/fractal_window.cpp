@@ -1,21 +1,27 @@
 #include "fractal_window.hpp"
+#include "palette.hpp"
+#include "polynomial.hpp"
+#include "cpu_renderer.hpp"
+#include "embedded_shaders.hpp"
 
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
-#include "glm/gtx/norm.hpp"
 
 #include <string_view>
+#include <algorithm>
 #include <fstream>
 #include <exception>
 #include <sstream>
 #include <ranges>
-#include <bit>
+#include <numeric>
 #include <span>
 #include <cmath>
 #include <filesystem>
-#include <numbers>
+#include <iostream>
+#include <cstddef>
+#include <format>
 
 using namespace std::string_literals;
 
@@ -61,27 +67,6 @@ namespace euleristic {
 		return destination;
 	}
 
-	// This could be any arithmetic type, but for clarity only complex is used there
-	constexpr std::vector<std::complex<double>> zeros_to_coefficients(std::span<std::complex<double>> zeros) {
-
-		if (zeros.size() > 63) {
-			throw std::invalid_argument("Size of zeros was greater than 63.");
-		}
-
-		std::vector coefs(zeros.size() + 1, std::complex<double>{});
-
-		for (std::uint64_t bits = 0; bits < (1ui64 << zeros.size()); ++bits) {
-			std::complex<double> product(1.0f, 0.0f);
-			for (size_t i = 0; i < zeros.size(); ++i) {
-				if ((bits >> i) & 1ui64) {
-					product *= -zeros[i];
-				}
-			}
-			coefs[zeros.size() - std::popcount(bits)] += product;
-		}
-		return coefs;
-	}
-
 	template<std::floating_point component_type>
 	constexpr glm::mat<3, 3, component_type> translate(const glm::vec<2, component_type> by) {
 		return glm::mat<3, 3, component_type>(
@@ -105,78 +90,6 @@ namespace euleristic {
 		return (mat * glm::vec<length + 1, component_type>(vec, 1.0)).xy;
 	}
 
-	std::string load_file(std::filesystem::path path) {
-		std::ifstream input_file(path);
-		if (!input_file.is_open()) {
-			throw std::exception(("Could not load file at path: "s + path.string()).c_str());
-		}
-		std::stringstream stringstream;
-		stringstream << input_file.rdbuf();
-		input_file.close();
-		return stringstream.str();
-	}
-
-	void compile_shader(const int shader_id, const char* source, const char* shader_name = "Unspecified") {
-		glShaderSource(shader_id, 1, &source, nullptr);
-		glCompileShader(shader_id);
-
-		int success;
-		glGetShaderiv(shader_id, GL_COMPILE_STATUS, &success);
-		if (!success) {
-			char info_log[512];
-			glGetShaderInfoLog(shader_id, 512, nullptr, info_log);
-			throw graphics_error{ "COMPILATION_ERROR in : "s + shader_name, info_log };
-		}
-	}
-
-	// Where h, s, v are in [0, 1]
-	glm::vec4 hsv_to_rgba(float hue, float saturation, float value) {
-		// Credit to Wikipedia: https://en.wikipedia.org/wiki/HSL_and_HSV#HSV_to_RGB
-
-		float chroma = value * saturation;
-		float x = chroma * (1.0f - std::fabsf(std::fmodf(hue * 6.0f, 2.0f) - 1.0f));
-
-		glm::vec3 rgb1;
-		if (hue <= 1.0 / 6.0)
-			rgb1 = glm::vec3(chroma, x, 0.0f);
-		else if (hue <= 2.0 / 6.0)
-			rgb1 = glm::vec3(x, chroma, 0.0f);
-		else if (hue <= 3.0 / 6.0)
-			rgb1 = glm::vec3(0.0f, chroma, x);
-		else if (hue <= 4.0 / 6.0)
-			rgb1 = glm::vec3(0.0f, x, chroma);
-		else if (hue <= 5.0 / 6.0)
-			rgb1 = glm::vec3(x, 0.0f, chroma);
-		else
-			rgb1 = glm::vec3(chroma, 0.0f, x);
-
-		float m = value - chroma;
-
-		return glm::vec4(rgb1.r + m, rgb1.g + m, rgb1.b + m, 1.0f);
-	}
-
-	glm::vec4 generate_color(const size_t index) {
-		constexpr float saturation = 1.0f;
-		constexpr float value = 0.5f;
-		// I'm sure I'm not the first to think of this, but the palette is basically selected by walking phi 
-		// circumferences around the color wheel from the previous one. Since phi is the "most irrational number",
-		// this method generates the an optimally uniform distribution of colors as the size of the palette approaches infinity.
-		return hsv_to_rgba(fmodf((float)index * std::numbers::phi_v<float>, 1.0), saturation, value);
-	}
-
-	std::string generate_color_list_code(size_t count) {
-		std::string code;
-		for (size_t i = 0; i < count; ++i) {
-			auto color = generate_color(i);
-			code += "vec4(" + std::to_string(color.r) + ", " + std::to_string(color.g) + ", "
-				+ std::to_string(color.b) + ", " + std::to_string(color.a) + ')';
-			if (i + 1 < count) {
-				code += ",\n\t";
-			}
-		}
-		return code;
-	}
-
 	// Can't wait for reflection in C++41!
 
 	constexpr const char* reflect_GL_error(GLenum code) {
@@ -215,75 +128,148 @@ namespace euleristic {
 	constexpr double initial_pixels_per_unit = 200.0; //This being double saves a cast.
 	constexpr double zoom_rate = 1.1;
 	constexpr float zero_total_radius = 10.0f;
-	constexpr float zero_total_radius_sqr = zero_total_radius * zero_total_radius;
 	constexpr float zero_inner_radius_ratio = 0.8f;
-	constexpr auto zero_scale = scale(glm::vec2(zero_total_radius, zero_total_radius));
+	// Well past where the Newton steps, at O(degree) per iteration per pixel, take seconds a frame anyway
+	constexpr size_t max_zero_count = 1 << 16;
+	// While nothing changes, the fractal is rendered at 1/8, 1/4, 1/2 and full resolution on consecutive frames
+	constexpr std::array<int, 4> refinement_divisors = { 8, 4, 2, 1 };
 
 	// Fractal Window
 
-	void fractal_window::recompile_shaders() {
-
-		// Complete fractal shader
-
-		std::string source = replace_all_of(fractal_fragment_shader_source_template, "TEMPLATE_DEGREE", std::to_string(zeros.size()));
-		source = replace_all_of(source, "TEMPLATE_ITERATION_COUNT", std::to_string(iteration_count));
-		source = replace_all_of(source, "TEMPLATE_EPSILON_SQR", std::to_string(epsilon_squared));
-		source = replace_all_of(source, "TEMPLATE_COLOR_LIST", generate_color_list_code(zeros.size()).c_str());
+	void fractal_window::compile_shaders(program_cache& cache) {
+		auto timer = profiler.time(frame_stage::shader_compile);
 
-		compile_shader(fractal_fragment_shader, source.c_str(), "Fractal Fragment Shader");
+		// Everything the fractal shader depends on is a uniform or in a buffer texture, so this only happens once.
+		// The zeros shader's marker proportions are baked in, and so are part of its cache key.
 
-		glAttachShader(fractal_shader_program, fractal_vertex_shader);
-		glAttachShader(fractal_shader_program, fractal_fragment_shader);
-		glLinkProgram(fractal_shader_program);
-
-		int success;
-		glGetProgramiv(fractal_shader_program, GL_LINK_STATUS, &success);
-		if (!success) {
-			char info_log[512];
-			glGetProgramInfoLog(fractal_shader_program, 512, nullptr, info_log);
-			throw graphics_error{ "SHADER_LINKING_ERROR", info_log };
-		}
+		const std::array fractal_stages = {
+			shader_stage{ GL_VERTEX_SHADER, source_of(embedded_shader::fractal_vertex), "Fractal Vertex Shader" },
+			shader_stage{ GL_FRAGMENT_SHADER, source_of(embedded_shader::fractal_fragment), "Fractal Fragment Shader" } };
+		cache.build(fractal_shader_program, fractal_stages);
 
-		// Complete zeros shader
+		const std::string zeros_fragment_source = replace_all_of(source_of(embedded_shader::zeros_fragment),
+			"TEMPLATE_RADIUS_SQR", std::to_string(zero_inner_radius_ratio));
+		const std::array zeros_stages = {
+			shader_stage{ GL_VERTEX_SHADER, source_of(embedded_shader::zeros_vertex), "Zeros Vertex Shader" },
+			shader_stage{ GL_FRAGMENT_SHADER, zeros_fragment_source, "Zeros Fragment Shader" } };
+		cache.build(zeros_shader_program, zeros_stages);
 
-		source = replace_all_of(zeros_fragment_shader_source_template, "TEMPLATE_RADIUS_SQR", std::to_string(zero_inner_radius_ratio));
-
-		compile_shader(zeros_fragment_shader, source.c_str(), "Zeros Fragment Shader");
-
-		glAttachShader(zeros_shader_program, zeros_vertex_shader);
-		glAttachShader(zeros_shader_program, zeros_fragment_shader);
-		glLinkProgram(zeros_shader_program);
-
-		glGetProgramiv(zeros_shader_program, GL_LINK_STATUS, &success);
-		if (!success) {
-			char info_log[512];
-			glGetProgramInfoLog(zeros_shader_program, 512, nullptr, info_log);
-			throw graphics_error{ "SHADER_LINKING_ERROR", info_log };
-		}
+		shader_statistics = cache.stats();
+		shader_cache_path = cache.path();
 
 		// Get uniforms
 
 		fractal_screen_rect_uniform = glGetUniformLocation(fractal_shader_program, "fractal_space_screen_rect");
-		fractal_coefficients_uniform = glGetUniformLocation(fractal_shader_program, "coefficients");
-		fractal_zeros_uniform = glGetUniformLocation(fractal_shader_program, "zeros");
-
-		zeros_transform_uniform = glGetUniformLocation(zeros_shader_program, "transform");
-		zeros_color_uniform = glGetUniformLocation(zeros_shader_program, "color");
+		fractal_evaluate_from_zeros_uniform = glGetUniformLocation(fractal_shader_program, "evaluate_from_zeros");
+		fractal_degree_uniform = glGetUniformLocation(fractal_shader_program, "degree");
+		fractal_iteration_count_uniform = glGetUniformLocation(fractal_shader_program, "iteration_count");
+		fractal_epsilon_squared_uniform = glGetUniformLocation(fractal_shader_program, "epsilon_squared");
+		fractal_exit_epsilon_squared_uniform = glGetUniformLocation(fractal_shader_program, "exit_epsilon_squared");
+		fractal_step_squared_uniform = glGetUniformLocation(fractal_shader_program, "step_squared");
+		fractal_screen_center_low_uniform = glGetUniformLocation(fractal_shader_program, "fractal_space_screen_center_low");
+		fractal_double_double_uniform = glGetUniformLocation(fractal_shader_program, "double_double_points");
+		fractal_grid_origin_uniform = glGetUniformLocation(fractal_shader_program, "grid_origin");
+		fractal_grid_inverse_cell_size_uniform = glGetUniformLocation(fractal_shader_program, "grid_inverse_cell_size");
+		fractal_grid_size_uniform = glGetUniformLocation(fractal_shader_program, "grid_size");
+
+		// The buffer textures stay bound to the first five texture units while the fractal is rendered
+		glUseProgram(fractal_shader_program);
+		glUniform1i(glGetUniformLocation(fractal_shader_program, "zeros"), 0);
+		glUniform1i(glGetUniformLocation(fractal_shader_program, "coefficients"), 1);
+		glUniform1i(glGetUniformLocation(fractal_shader_program, "colors"), 2);
+		glUniform1i(glGetUniformLocation(fractal_shader_program, "grid_cell_offsets"), 3);
+		glUniform1i(glGetUniformLocation(fractal_shader_program, "grid_candidates"), 4);
+		glUseProgram(0);
+
+		zeros_origin_uniform = glGetUniformLocation(zeros_shader_program, "fractal_space_origin");
+		zeros_origin_low_uniform = glGetUniformLocation(zeros_shader_program, "fractal_space_origin_low");
+		zeros_fractal_to_screen_uniform = glGetUniformLocation(zeros_shader_program, "fractal_to_screen");
+		zeros_screen_to_normal_uniform = glGetUniformLocation(zeros_shader_program, "screen_to_normal");
+		glUseProgram(zeros_shader_program);
+		glUniform1f(glGetUniformLocation(zeros_shader_program, "radius"), zero_total_radius);
+		glUseProgram(0);
 	}
 
 	void fractal_window::add_zero(const std::complex<double> zero) noexcept {
+		// The shader has no room for more
+		if (zeros.size() >= max_degree) return;
+		auto timer = profiler.time(frame_stage::coefficients);
 		zeros.push_back(zero);
-		recompile_shaders();
-		coefficients = zeros_to_coefficients(zeros);
+		multiply_in_zero(coefficients, zero);
+		zeros_changed();
 	}
 
 	void fractal_window::remove_zero(const size_t index) {
+		auto timer = profiler.time(frame_stage::coefficients);
 		zeros.erase(zeros.cbegin() + index);
-		recompile_shaders();
 		coefficients = zeros_to_coefficients(zeros);
+		zeros_changed();
+	}
+
+	void fractal_window::zeros_changed() noexcept {
+		zeros_vertex_buffer_dirty = true;
+		zero_index_dirty = true;
+		fractal_buffers_dirty = true;
 	}
 
-	fractal_window::fractal_window(int width, int height) {
+	void fractal_window::update_zero_index() {
+		const double radius = std::sqrt(epsilon_squared);
+		if (!zero_index_dirty && radius == indexed_radius) return;
+		indexed_zeros = zero_index(zeros, radius);
+		indexed_radius = radius;
+		// What make_newton_exit works out, but from the grid rather than by comparing every pair of zeros
+		exit_epsilon_squared = std::min(epsilon_squared, indexed_zeros.closest_pair_distance_squared() / 16.0);
+		zero_index_dirty = false;
+		fractal_buffers_dirty = true;
+	}
+
+	void upload_buffer_texture(unsigned int buffer, const void* data, size_t size) noexcept {
+		glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+		glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(size), data, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+
+	void fractal_window::update_fractal_buffers() {
+		update_zero_index();
+		if (!fractal_buffers_dirty) return;
+
+		// A std::complex<double> is two doubles, which is one RGBA32UI texel
+		upload_buffer_texture(zeros_texture.buffer, zeros.data(), zeros.size() * sizeof(zeros[0]));
+		upload_buffer_texture(coefficients_texture.buffer, coefficients.data(), coefficients.size() * sizeof(coefficients[0]));
+
+		const auto candidates = indexed_zeros.candidates();
+		if (candidates.size() < static_cast<size_t>(max_texture_buffer_size)) {
+			const auto offsets = indexed_zeros.cell_offsets();
+			upload_buffer_texture(grid_offsets_texture.buffer, offsets.data(), offsets.size_bytes());
+			upload_buffer_texture(grid_candidates_texture.buffer, candidates.data(), candidates.size_bytes());
+			glUniform2d(fractal_grid_origin_uniform, indexed_zeros.origin().real(), indexed_zeros.origin().imag());
+			glUniform1d(fractal_grid_inverse_cell_size_uniform, 1.0 / indexed_zeros.cell_size());
+			glUniform2i(fractal_grid_size_uniform, static_cast<GLint>(indexed_zeros.columns()), static_cast<GLint>(indexed_zeros.rows()));
+		}
+		else {
+			// A radius far larger than the spacing of the zeros can give every cell most of the zeros, and more
+			// candidates than a buffer texture holds. Then it's one cell with all the zeros in it, every point in it.
+			const std::array<std::int32_t, 2> offsets = { 0, static_cast<std::int32_t>(zeros.size()) };
+			std::vector<std::int32_t> all_zeros(zeros.size());
+			std::iota(all_zeros.begin(), all_zeros.end(), 0);
+			upload_buffer_texture(grid_offsets_texture.buffer, offsets.data(), sizeof(offsets));
+			upload_buffer_texture(grid_candidates_texture.buffer, all_zeros.data(), all_zeros.size() * sizeof(all_zeros[0]));
+			glUniform2d(fractal_grid_origin_uniform, 0.0, 0.0);
+			glUniform1d(fractal_grid_inverse_cell_size_uniform, 0.0);
+			glUniform2i(fractal_grid_size_uniform, 1, 1);
+		}
+		fractal_buffers_dirty = false;
+	}
+
+	std::optional<size_t> fractal_window::zero_at(glm::dvec2 screen_position) {
+		update_zero_index();
+		// The markers are circles in screen space, and the view is only ever scaled evenly
+		const auto point = screen_to_fractal_space * screen_position;
+		const double pixel_size = std::hypot(screen_to_fractal_space[0][0], screen_to_fractal_space[0][1]);
+		return indexed_zeros.nearest(std::complex(point.x, point.y), zero_total_radius * pixel_size);
+	}
+
+	fractal_window::fractal_window(int width, int height, bool visible) {
 		window_width = width;
 		window_height = height;
 
@@ -305,6 +291,7 @@ namespace euleristic {
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
 		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
 		window = glfwCreateWindow(width, height, "", nullptr, nullptr);
 
@@ -328,23 +315,38 @@ namespace euleristic {
 		fractal_shader_program = glCreateProgram();
 		zeros_shader_program = glCreateProgram();
 
-		// Load, compile and link shaders
+		// The fractal shader's arrays are buffer textures, which the driver has to allow at least 65536 texels each. The
+		// grid over the zeros has at most a few cells per zero (and a few dozen to spare), and takes the most room.
 
-		fractal_vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-		compile_shader(fractal_vertex_shader, load_file("fractal_vertex_shader.glsl").c_str(), "Fractal Vertex Shader");
-		zeros_vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-		compile_shader(zeros_vertex_shader, load_file("zeros_vertex_shader.glsl").c_str(), "Zeros Vertex Shader");
+		glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texture_buffer_size);
+		max_degree = std::min(static_cast<size_t>(std::max(max_texture_buffer_size - 65, 4)) / 4, max_zero_count);
 
-		fractal_fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-		fractal_fragment_shader_source_template = load_file("fractal_fragment_shader_template.glsl");
-		zeros_fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-		zeros_fragment_shader_source_template = load_file("zeros_fragment_shader_template.glsl");
+		for (auto* array : { &zeros_texture, &coefficients_texture, &colors_texture, &grid_offsets_texture, &grid_candidates_texture }) {
+			glGenBuffers(1, &array->buffer);
+			glGenTextures(1, &array->texture);
+		}
+		const std::array<std::pair<const buffer_texture*, GLenum>, 5> buffer_texture_formats = { {
+			{ &zeros_texture, GL_RGBA32UI }, { &coefficients_texture, GL_RGBA32UI }, { &colors_texture, GL_RGBA32F },
+			{ &grid_offsets_texture, GL_R32I }, { &grid_candidates_texture, GL_R32I } } };
+		for (const auto& [array, format] : buffer_texture_formats) {
+			glBindTexture(GL_TEXTURE_BUFFER, array->texture);
+			glTexBuffer(GL_TEXTURE_BUFFER, format, array->buffer);
+		}
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+		// The palette only depends on the index, so every color there is room for is uploaded once and for all
+		std::vector<glm::vec4> colors;
+		for (size_t i = 0; i < max_degree; ++i) {
+			colors.push_back(generate_color(i));
+		}
+		upload_buffer_texture(colors_texture.buffer, colors.data(), colors.size() * sizeof(colors[0]));
 
-		// Complete and compile shader templates, and link shaders
+		// Complete the shader templates, and link them or load them from the cache
 
-		recompile_shaders();
+		program_cache cache;
+		compile_shaders(cache);
 
-		// Square vertex array (the same for both shader, nice)
+		// Square vertex array
 
 		glGenVertexArrays(1, &normal_square_vao);
 		glBindVertexArray(normal_square_vao);
@@ -355,11 +357,53 @@ namespace euleristic {
 		glBufferData(GL_ARRAY_BUFFER, normal_square_buffer.size() * sizeof(float), normal_square_buffer.data(), GL_STATIC_DRAW);
 		glVertexAttribPointer(0, 2, GL_FLOAT, false, 2 * sizeof(float), reinterpret_cast<void*>(0));
 
+		// The zero markers share the square, and take their positions and colors from the instance buffer
+
+		glGenVertexArrays(1, &zeros_vao);
+		glBindVertexArray(zeros_vao);
+		glEnableVertexAttribArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, normal_square_vbo);
+		glVertexAttribPointer(0, 2, GL_FLOAT, false, 2 * sizeof(float), reinterpret_cast<void*>(0));
+
+		glGenBuffers(1, &zeros_instance_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, zeros_instance_vbo);
+		glEnableVertexAttribArray(1);
+		glVertexAttribLPointer(1, 2, GL_DOUBLE, sizeof(zero_instance), reinterpret_cast<void*>(offsetof(zero_instance, position)));
+		glVertexAttribDivisor(1, 1);
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 4, GL_FLOAT, false, sizeof(zero_instance), reinterpret_cast<void*>(offsetof(zero_instance, color)));
+		glVertexAttribDivisor(2, 1);
+
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindVertexArray(0);
 
 		coefficients = zeros_to_coefficients(zeros);
 
+		for (auto& timer_query : fractal_timer_queries) {
+			glGenQueries(1, &timer_query.query);
+		}
+
+		// The fractal layer, which is sized to the window when rendering
+
+		glGenTextures(2, fractal_textures.data());
+		glGenFramebuffers(2, fractal_framebuffers.data());
+		for (size_t i = 0; i < 2; ++i) {
+			glBindTexture(GL_TEXTURE_2D, fractal_textures[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+			glBindFramebuffer(GL_FRAMEBUFFER, fractal_framebuffers[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fractal_textures[i], 0);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+				throw graphics_error{ reflect_GL_error(glGetError()), "The fractal framebuffer is incomplete." };
+			}
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		fractal_layer_width = width;
+		fractal_layer_height = height;
+
 		// Enable alpha blending 
 
 		glEnable(GL_BLEND);
@@ -370,80 +414,95 @@ namespace euleristic {
 		glfwSetWindowTitle(window, title);
 	}
 
+	input_frame fractal_window::poll_input() noexcept {
+		input_frame input;
+		input.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - created).count();
+		const auto cursor = mouse_position();
+		input.cursor_x = cursor.x;
+		input.cursor_y = cursor.y;
+		input.scroll = scroll_delta;
+		scroll_delta = 0.0;
+		if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_1) == GLFW_PRESS) input.buttons |= left_mouse_button;
+		if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_2) == GLFW_PRESS) input.buttons |= right_mouse_button;
+		constexpr std::array<std::pair<int, std::uint8_t>, 7> keys = { {
+			{ GLFW_KEY_E, evaluation_key }, { GLFW_KEY_P, progressive_key }, { GLFW_KEY_X, early_exit_key },
+			{ GLFW_KEY_C, continuous_key }, { GLFW_KEY_T, timings_key }, { GLFW_KEY_B, batch_key }, { GLFW_KEY_G, governor_key } } };
+		for (const auto& [key, bit] : keys) {
+			if (glfwGetKey(window, key) == GLFW_PRESS) input.keys |= bit;
+		}
+		return input;
+	}
+
+	void fractal_window::begin_frame(const input_frame& input) noexcept {
+		profiler.begin_frame();
+		current_input = input;
+	}
+
 	void fractal_window::handle_scroll_wheel() noexcept {
-		if (scroll_delta == 0.0) return;
-		auto mouse_pos = mouse_position();
-		auto scale_factor = std::pow(zoom_rate, -scroll_delta);
-
-		glm::dmat3 delta(
-			scale_factor, 0.0, 0.0,
-			0.0, scale_factor, 0.0,
-			(1.0 - scale_factor) * (mouse_pos.x * screen_to_fractal_space[0][0] + screen_to_fractal_space[2][0]),
-			(1.0 - scale_factor) * (mouse_pos.y * screen_to_fractal_space[1][1] + screen_to_fractal_space[2][1]),
-			1.0);
-
-		screen_to_fractal_space = delta * screen_to_fractal_space;
+		if (current_input.scroll == 0.0) return;
+		auto timer = profiler.time(frame_stage::input);
+		const glm::dvec2 mouse_pos(current_input.cursor_x, current_input.cursor_y);
+		auto scale_factor = std::pow(zoom_rate, -current_input.scroll);
+
+		// The point under the mouse stays put: the origin moves (1 - scale_factor) of the way there, and then the pixels shrink
+		shift_fractal_space((1.0 - scale_factor) * mouse_pos);
+		screen_to_fractal_space[0] *= scale_factor;
+		screen_to_fractal_space[1] *= scale_factor;
 		fractal_to_screen_space = glm::inverse(screen_to_fractal_space);
-		scroll_delta = 0.0;
 	}
 
 	void fractal_window::handle_mouse_buttons() noexcept {
+		auto timer = profiler.time(frame_stage::input);
 		// Left button
 
-		bool current_left_state = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_1) == GLFW_PRESS;
-		auto current_mouse_pos = mouse_position();
+		bool current_left_state = (current_input.buttons & left_mouse_button) != 0;
+		const glm::dvec2 current_mouse_pos(current_input.cursor_x, current_input.cursor_y);
 
 		// Did the press begin this frame?
 		if (!last_left_mouse_button_state && current_left_state) {
-			for (size_t i = 0; i < zeros.size(); ++i) {
-				if (glm::length2(current_mouse_pos - fractal_to_screen_space * glm::dvec2(zeros[i].real(), zeros[i].imag())) < zero_total_radius_sqr) {
-					held_zero = i;
-					break;
-				}
-			}
+			held_zero = zero_at(current_mouse_pos);
 		}
 		// Is the press continuing?
 		else if (last_left_mouse_button_state && current_left_state) {
 			if (held_zero) {
 				auto zero = screen_to_fractal_space * current_mouse_pos;
+				// O(n) per frame, rather than expanding all the zeros again
+				auto coefficients_timer = profiler.time(frame_stage::coefficients);
+				move_zero(coefficients, zeros[*held_zero], std::complex(zero.x, zero.y));
 				zeros[*held_zero] = std::complex(zero.x, zero.y);
-				coefficients = zeros_to_coefficients(zeros);
+				zeros_changed();
 			}
 			else {
-				fractal_to_screen_space = translate(current_mouse_pos - last_mouse_pos) * fractal_to_screen_space;
-				screen_to_fractal_space = glm::inverse(fractal_to_screen_space);
+				shift_fractal_space(last_mouse_pos - current_mouse_pos);
+				fractal_to_screen_space = glm::inverse(screen_to_fractal_space);
 			}
 		}
 		// Was the button released?
 		else if (last_left_mouse_button_state && !current_left_state) {
+			// Wash out the rounding errors the incremental updates have collected during the drag
+			if (held_zero) {
+				auto coefficients_timer = profiler.time(frame_stage::coefficients);
+				coefficients = zeros_to_coefficients(zeros);
+				fractal_buffers_dirty = true;
+			}
 			held_zero = {};
 		}
 		last_mouse_pos = current_mouse_pos;
 		last_left_mouse_button_state = current_left_state;
 
 		// Right button
-		bool current_right_state = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_2) == GLFW_PRESS;
+		bool current_right_state = (current_input.buttons & right_mouse_button) != 0;
 
 		// Did the press begin this frame?
 		if (!last_right_mouse_button_state && current_right_state) {
-			for (size_t i = 0; i < zeros.size(); ++i) {
-				if (glm::length2(current_mouse_pos - fractal_to_screen_space * glm::dvec2(zeros[i].real(), zeros[i].imag())) < zero_total_radius_sqr) {
-					zero_to_remove = i;
-					break;
-				}
-			}
+			zero_to_remove = zero_at(current_mouse_pos);
 		}
 		// Was the button released?
 		else if (last_right_mouse_button_state && !current_right_state) {
 			if (zero_to_remove) {
-				for (size_t i = 0; i < zeros.size(); ++i) {
-					if (glm::length2(current_mouse_pos - fractal_to_screen_space * glm::dvec2(zeros[i].real(), zeros[i].imag())) < zero_total_radius_sqr) {
-						if (zero_to_remove == i) {
-							if (zeros.size() > 1)
-								remove_zero(i);
-							break;
-						}
-					}
+				// Only if the mouse is still on the same zero
+				if (zero_at(current_mouse_pos) == zero_to_remove && zeros.size() > 1) {
+					remove_zero(*zero_to_remove);
 				}
 			}
 			else {
@@ -456,63 +515,411 @@ namespace euleristic {
 		last_right_mouse_button_state = current_right_state;
 	}
 
+	void fractal_window::handle_keyboard() noexcept {
+		auto timer = profiler.time(frame_stage::input);
+
+		// E switches between evaluating the polynomial from its coefficients and from its zeros
+		bool current_evaluation_key_state = (current_input.keys & evaluation_key) != 0;
+		if (!last_evaluation_key_state && current_evaluation_key_state) {
+			evaluation = evaluation == evaluation_mode::coefficients ? evaluation_mode::zeros : evaluation_mode::coefficients;
+		}
+		last_evaluation_key_state = current_evaluation_key_state;
+
+		// P toggles progressive rendering
+		bool current_progressive_key_state = (current_input.keys & progressive_key) != 0;
+		if (!last_progressive_key_state && current_progressive_key_state) {
+			progressive = !progressive;
+		}
+		last_progressive_key_state = current_progressive_key_state;
+
+		// X toggles early exit
+		bool current_early_exit_key_state = (current_input.keys & early_exit_key) != 0;
+		if (!last_early_exit_key_state && current_early_exit_key_state) {
+			early_exit = !early_exit;
+		}
+		last_early_exit_key_state = current_early_exit_key_state;
+
+		// C toggles continuous rendering
+		bool current_continuous_key_state = (current_input.keys & continuous_key) != 0;
+		if (!last_continuous_key_state && current_continuous_key_state) {
+			continuous = !continuous;
+		}
+		last_continuous_key_state = current_continuous_key_state;
+
+		// T writes the recent stage timings out, and their percentiles to stdout
+		bool current_timings_key_state = (current_input.keys & timings_key) != 0;
+		if (!last_timings_key_state && current_timings_key_state) {
+			try {
+				write_frame_timings("frame_timings");
+				profiler.write_summary(std::cout);
+				std::cout << "Wrote frame_timings.json and frame_timings.csv.\n";
+			} catch (std::exception& err) {
+				std::cerr << err.what() << '\n';
+			}
+		}
+		last_timings_key_state = current_timings_key_state;
+
+		// B prints the batch options for the view, to export it at a higher resolution with --scale and --export
+		bool current_batch_key_state = (current_input.keys & batch_key) != 0;
+		if (!last_batch_key_state && current_batch_key_state) {
+			std::cout << batch_options() << '\n';
+		}
+		last_batch_key_state = current_batch_key_state;
+
+		// G toggles the frame budget governor
+		bool current_governor_key_state = (current_input.keys & governor_key) != 0;
+		if (!last_governor_key_state && current_governor_key_state) {
+			governed = !governed;
+		}
+		last_governor_key_state = current_governor_key_state;
+	}
+
 	bool fractal_window::should_close() const noexcept {
 		return glfwWindowShouldClose(window);
 	}
 
-	void fractal_window::render() noexcept {
+	void fractal_window::shift_fractal_space(glm::dvec2 by) noexcept {
+		const auto& transform = screen_to_fractal_space;
+		const auto x = double_double(transform[2][0], translation_low.x) + two_product(transform[0][0], by.x) + two_product(transform[1][0], by.y);
+		const auto y = double_double(transform[2][1], translation_low.y) + two_product(transform[0][1], by.x) + two_product(transform[1][1], by.y);
+		screen_to_fractal_space[2][0] = x.hi;
+		screen_to_fractal_space[2][1] = y.hi;
+		translation_low = glm::dvec2(x.lo, y.lo);
+	}
+
+	std::string fractal_window::batch_options() const {
+		// The batch renderer builds its transform from the center and zoom the same way the window starts out, so
+		// the center has to carry the double-double translation along
+		const auto& transform = screen_to_fractal_space;
+		const auto center_x = double_double(transform[2][0], translation_low.x)
+			+ two_product(transform[0][0], window_width / 2.0) + two_product(transform[1][0], window_height / 2.0);
+		const auto center_y = double_double(transform[2][1], translation_low.y)
+			+ two_product(transform[0][1], window_width / 2.0) + two_product(transform[1][1], window_height / 2.0);
+
+		auto options = std::format("--size {}x{} --center {},{} --pixels-per-unit {} --iterations {} --epsilon-squared {} --step-squared {}",
+			static_cast<size_t>(window_width), static_cast<size_t>(window_height), to_string(center_x), to_string(center_y), 1.0 / transform[0][0], iteration_count,
+			epsilon_squared, step_squared);
+		if (!early_exit) options += " --no-early-exit";
+		options += evaluation == evaluation_mode::zeros ? " --evaluation zeros" : " --evaluation coefficients";
+		if (precision != precision_mode::automatic) {
+			options += precision == precision_mode::double_double ? " --precision double-double" : " --precision double";
+		}
+		options += " --zeros";
+		for (const auto& zero : zeros) {
+			options += std::format(" {},{}", zero.real(), zero.imag());
+		}
+		return options;
+	}
 
-		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
+	bool fractal_window::double_double_points() const noexcept {
+		return precision == precision_mode::double_double || (precision == precision_mode::automatic
+			&& needs_double_double(screen_to_fractal_space, static_cast<size_t>(window_width), static_cast<size_t>(window_height)));
+	}
+
+	fractal_window::fractal_state fractal_window::current_fractal_state() const {
+		return { zeros, screen_to_fractal_space, translation_low, double_double_points(), iteration_count, epsilon_squared, early_exit, step_squared, evaluation,
+			static_cast<int>(window_width), static_cast<int>(window_height) };
+	}
+
+	void fractal_window::render_fractal_layer(int width, int height, bool clear) noexcept {
+		glBindFramebuffer(GL_FRAMEBUFFER, fractal_framebuffers[current_layer]);
+		glViewport(0, 0, width, height);
+		if (clear) {
+			glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+		}
 		glBindVertexArray(normal_square_vao);
 		glUseProgram(fractal_shader_program);
-		auto center = screen_to_fractal_space * glm::dvec2(window_width / 2.0, window_height / 2.0);
-		auto half = screen_to_fractal_space * glm::dvec2(window_width, 0.0) - center;
-		glUniform4d(fractal_screen_rect_uniform, center.x, center.y, half.x, half.y);
+		// The center to double-double precision, which is only used at deep zooms, but costs next to nothing
+		const auto& transform = screen_to_fractal_space;
+		const auto center_x = double_double(transform[2][0], translation_low.x)
+			+ two_product(transform[0][0], window_width / 2.0) + two_product(transform[1][0], window_height / 2.0);
+		const auto center_y = double_double(transform[2][1], translation_low.y)
+			+ two_product(transform[0][1], window_width / 2.0) + two_product(transform[1][1], window_height / 2.0);
+		const auto half = glm::dmat2(transform) * glm::dvec2(window_width / 2.0, -window_height / 2.0);
+		glUniform4d(fractal_screen_rect_uniform, center_x.hi, center_y.hi, half.x, half.y);
+		glUniform2d(fractal_screen_center_low_uniform, center_x.lo, center_y.lo);
+		glUniform1i(fractal_double_double_uniform, double_double_points());
 
 		// The C++ standard guarantees that std::complex is castable in this manner, independent of implementation! :D
-		glUniform2dv(fractal_coefficients_uniform, coefficients.size(), reinterpret_cast<GLdouble*>(coefficients.data()));
-		glUniform2dv(fractal_zeros_uniform, zeros.size(), reinterpret_cast<GLdouble*>(zeros.data()));
+		update_fractal_buffers();
+		const std::array<const buffer_texture*, 5> buffer_textures = { &zeros_texture, &coefficients_texture, &colors_texture,
+			&grid_offsets_texture, &grid_candidates_texture };
+		for (size_t unit = 0; unit < buffer_textures.size(); ++unit) {
+			glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(unit));
+			glBindTexture(GL_TEXTURE_BUFFER, buffer_textures[unit]->texture);
+		}
+		glActiveTexture(GL_TEXTURE0);
+		glUniform1i(fractal_evaluate_from_zeros_uniform, evaluation == evaluation_mode::zeros);
+		glUniform1i(fractal_degree_uniform, static_cast<GLint>(zeros.size()));
+		glUniform1i(fractal_iteration_count_uniform, static_cast<GLint>(iteration_count));
+		glUniform1d(fractal_epsilon_squared_uniform, epsilon_squared);
+		glUniform1d(fractal_exit_epsilon_squared_uniform, early_exit ? exit_epsilon_squared : 0.0);
+		glUniform1d(fractal_step_squared_uniform, early_exit ? step_squared : 0.0);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
 
-		glm::mat3 screen_to_normal_space = translate(glm::vec2(-1.0, 1.0)) * scale(glm::vec2(2.0 / window_width, -2.0 / window_height));
+	std::optional<glm::ivec2> fractal_window::pixel_aligned_pan(const fractal_state& from, const fractal_state& to) {
+		if (from.zeros != to.zeros || from.double_double_points != to.double_double_points
+			|| from.iteration_count != to.iteration_count || from.epsilon_squared != to.epsilon_squared
+			|| from.early_exit != to.early_exit || from.step_squared != to.step_squared
+			|| from.evaluation != to.evaluation || from.width != to.width || from.height != to.height) {
+			return {};
+		}
 
-		auto zero = glm::vec2(zeros[0].real(), zeros[0].imag());
-		auto trans = translate(glm::mat3(fractal_to_screen_space) * zero);
-		auto normal_pos = screen_to_normal_space * trans * glm::vec2(0.0);
+		// The scale can't have changed, but inverting the transforms may have rounded it a little
+		constexpr double scale_tolerance = 1e-12;
+		for (int column = 0; column < 2; ++column) {
+			for (int row = 0; row < 2; ++row) {
+				if (std::abs(from.screen_to_fractal_space[column][row] - to.screen_to_fractal_space[column][row])
+					> scale_tolerance * std::abs(from.screen_to_fractal_space[0][0])) {
+					return {};
+				}
+			}
+		}
 
-		glUseProgram(zeros_shader_program);
-		for (size_t i = 0; i < zeros.size(); ++i) {
-			auto transform = screen_to_normal_space * translate(glm::mat3(fractal_to_screen_space) * glm::vec2(zeros[i].real(), zeros[i].imag()))
-				* zero_scale;
-			glUniformMatrix3fv(zeros_transform_uniform, 1, GL_FALSE, glm::value_ptr(glm::mat3(transform)));
-			auto color = generate_color(i);
-			glUniform4f(zeros_color_uniform, color.r, color.g, color.b, color.a);
-			glDrawArrays(GL_TRIANGLES, 0, 6);
+		// Where the old screen's origin ended up on the new screen. The translations are subtracted high and low parts
+		// separately, since at a deep zoom the pan may be all in the low parts.
+		const glm::dvec2 translation_difference(
+			(from.screen_to_fractal_space[2][0] - to.screen_to_fractal_space[2][0]) + (from.translation_low.x - to.translation_low.x),
+			(from.screen_to_fractal_space[2][1] - to.screen_to_fractal_space[2][1]) + (from.translation_low.y - to.translation_low.y));
+		const auto offset = glm::inverse(glm::dmat2(to.screen_to_fractal_space)) * translation_difference;
+		const glm::dvec2 rounded(std::round(offset.x), std::round(offset.y));
+		constexpr double alignment_tolerance = 1e-6;
+		if (std::abs(offset.x - rounded.x) > alignment_tolerance || std::abs(offset.y - rounded.y) > alignment_tolerance) {
+			return {};
 		}
+		return glm::ivec2(static_cast<int>(rounded.x), static_cast<int>(rounded.y));
+	}
 
-		glBindVertexArray(0);
-		glfwSwapBuffers(window);
+	void fractal_window::render() noexcept {
+		const int width = static_cast<int>(window_width);
+		const int height = static_cast<int>(window_height);
+		collect_timer_queries();
+
+		{
+			auto timer = profiler.time(frame_stage::fractal_draw);
+			// What the governor measures the pass by
+			size_t shaded_pixels = 0;
+			// The GPU time is only measured when a query is free, rather than waiting on an old one to come back
+			auto& timer_query = fractal_timer_queries[next_timer_query];
+			const bool gpu_timed = !timer_query.pending;
+			if (gpu_timed) {
+				timer_query.frame = profiler.current_frame();
+				timer_query.start = frame_profiler::clock::now();
+				timer_query.shaded_pixels = 0;
+				timer_query.window_pixels = static_cast<size_t>(width) * static_cast<size_t>(height);
+				glBeginQuery(GL_TIME_ELAPSED, timer_query.query);
+			}
+
+			if (width != fractal_layer_width || height != fractal_layer_height) {
+				for (auto texture : fractal_textures) {
+					glBindTexture(GL_TEXTURE_2D, texture);
+					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+				}
+				glBindTexture(GL_TEXTURE_2D, 0);
+				fractal_layer_width = width;
+				fractal_layer_height = height;
+			}
+
+			// Anything the fractal depends on changing sends it back to the coarsest level (or straight to the finest).
+			// Otherwise it is refined one level per frame, until it is complete and only needs to be blitted, like when
+			// only the mouse has moved. Rendering continuously draws the full resolution layer again regardless.
+			auto state = current_fractal_state();
+			if (state != rendered_state) {
+				// A complete layer that has only been panned is shifted into the other layer, leaving only the exposed strips to shade.
+				// Anything else starts over.
+				const bool layer_complete = next_refinement_level == refinement_divisors.size() && displayed_size == glm::ivec2(width, height);
+				const auto pan = layer_complete ? pixel_aligned_pan(rendered_state, state) : std::nullopt;
+				rendered_state = std::move(state);
+
+				if (pan && std::abs(pan->x) < width && std::abs(pan->y) < height) {
+					// Screen space y points down, framebuffer y points up
+					const glm::ivec2 shift(pan->x, -pan->y);
+
+					glBindFramebuffer(GL_READ_FRAMEBUFFER, fractal_framebuffers[current_layer]);
+					current_layer = 1 - current_layer;
+					glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fractal_framebuffers[current_layer]);
+					glBlitFramebuffer(0, 0, width, height, shift.x, shift.y, width + shift.x, height + shift.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+					glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+					glEnable(GL_SCISSOR_TEST);
+					glDisable(GL_BLEND); // The strips are written as they are, since they aren't cleared first
+					if (shift.x != 0) {
+						glScissor(shift.x > 0 ? 0 : width + shift.x, 0, std::abs(shift.x), height);
+						render_fractal_layer(width, height, false);
+						shaded_pixels += static_cast<size_t>(std::abs(shift.x)) * static_cast<size_t>(height);
+					}
+					if (shift.y != 0) {
+						glScissor(0, shift.y > 0 ? 0 : height + shift.y, width, std::abs(shift.y));
+						render_fractal_layer(width, height, false);
+						shaded_pixels += static_cast<size_t>(width) * static_cast<size_t>(std::abs(shift.y));
+					}
+					glEnable(GL_BLEND);
+					glDisable(GL_SCISSOR_TEST);
+				}
+				else {
+					next_refinement_level = progressive ? 0 : refinement_divisors.size() - 1;
+				}
+			}
+			if (continuous && next_refinement_level == refinement_divisors.size()) {
+				next_refinement_level = refinement_divisors.size() - 1;
+			}
+			// The levels are shaded at the governor's scale. Once they are done and nothing has changed, the last one is
+			// shaded again at the window's resolution, which may take longer than a frame, but there's only the one.
+			if (next_refinement_level < refinement_divisors.size()) {
+				const double scale = governed ? governor.scale() : 1.0;
+				const int divisor = refinement_divisors[next_refinement_level++];
+				displayed_size = glm::ivec2(std::max(1, static_cast<int>(width * scale) / divisor),
+					std::max(1, static_cast<int>(height * scale) / divisor));
+				render_fractal_layer(displayed_size.x, displayed_size.y, true);
+				shaded_pixels += static_cast<size_t>(displayed_size.x) * static_cast<size_t>(displayed_size.y);
+			}
+			else if (displayed_size != glm::ivec2(width, height)) {
+				displayed_size = glm::ivec2(width, height);
+				render_fractal_layer(width, height, true);
+				shaded_pixels += static_cast<size_t>(width) * static_cast<size_t>(height);
+			}
+
+			glViewport(0, 0, width, height);
+			glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, fractal_framebuffers[current_layer]);
+			glBlitFramebuffer(0, 0, displayed_size.x, displayed_size.y, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+			if (gpu_timed) {
+				timer_query.shaded_pixels = shaded_pixels;
+				glEndQuery(GL_TIME_ELAPSED);
+				timer_query.pending = true;
+				next_timer_query = (next_timer_query + 1) % fractal_timer_queries.size();
+			}
+		}
+
+		{
+			auto timer = profiler.time(frame_stage::zero_markers);
+			if (zeros_vertex_buffer_dirty) {
+				zeros_vertex_buffer.clear();
+				for (size_t i = 0; i < zeros.size(); ++i) {
+					zeros_vertex_buffer.push_back({ glm::dvec2(zeros[i].real(), zeros[i].imag()), generate_color(i) });
+				}
+				glBindBuffer(GL_ARRAY_BUFFER, zeros_instance_vbo);
+				glBufferData(GL_ARRAY_BUFFER, zeros_vertex_buffer.size() * sizeof(zero_instance), zeros_vertex_buffer.data(), GL_DYNAMIC_DRAW);
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+				zeros_vertex_buffer_dirty = false;
+			}
+
+			const glm::mat3 screen_to_normal_space = translate(glm::vec2(-1.0, 1.0)) * scale(glm::vec2(2.0 / window_width, -2.0 / window_height));
+			const glm::dmat2 fractal_to_screen_linear(fractal_to_screen_space);
+
+			glUseProgram(zeros_shader_program);
+			glUniform2d(zeros_origin_uniform, screen_to_fractal_space[2][0], screen_to_fractal_space[2][1]);
+			glUniform2d(zeros_origin_low_uniform, translation_low.x, translation_low.y);
+			glUniformMatrix2dv(zeros_fractal_to_screen_uniform, 1, GL_FALSE, glm::value_ptr(fractal_to_screen_linear));
+			glUniformMatrix3fv(zeros_screen_to_normal_uniform, 1, GL_FALSE, glm::value_ptr(screen_to_normal_space));
+			glBindVertexArray(zeros_vao);
+			glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(zeros.size()));
+			glBindVertexArray(0);
+		}
+
+		{
+			auto timer = profiler.time(frame_stage::swap);
+			glfwSwapBuffers(window);
+		}
+
+		if (!first_frame_reported) {
+			report_first_frame();
+		}
+	}
 
+	void fractal_window::report_first_frame() noexcept {
+		// Some drivers only really link at the first draw, so the frame is waited on to count all of it
+		glFinish();
+		first_frame_reported = true;
+		const std::chrono::duration<double, std::milli> startup = frame_profiler::clock::now() - created;
+		std::cout << std::format("First frame {:.1f} ms after startup. Shaders: {} programs loaded from the cache in {:.1f} ms, "
+			"{} compiled in {:.1f} ms{}. ", startup.count(), shader_statistics.hits, shader_statistics.loading.count(),
+			shader_statistics.misses, shader_statistics.compiling.count(),
+			shader_statistics.rejected > 0 ? std::format(" ({} cached binaries refused by the driver)", shader_statistics.rejected) : "");
+		if (shader_cache_path.empty()) {
+			std::cout << "The shader cache is off.\n";
+		}
+		else {
+			std::cout << "Shader cache: " << shader_cache_path.string() << '\n';
+		}
+	}
+
+	void fractal_window::collect_timer_queries() noexcept {
+		for (auto& timer_query : fractal_timer_queries) {
+			if (!timer_query.pending) continue;
+			GLint available = 0;
+			glGetQueryObjectiv(timer_query.query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) continue;
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(timer_query.query, GL_QUERY_RESULT, &nanoseconds);
+			// The GPU's clock isn't the CPU's, so the pass is placed where it was issued
+			profiler.record(frame_stage::fractal_gpu, timer_query.frame, timer_query.start, std::chrono::nanoseconds(nanoseconds));
+			governor.record(std::chrono::nanoseconds(nanoseconds), timer_query.shaded_pixels, timer_query.window_pixels);
+			timer_query.pending = false;
+		}
 	}
 
 	void fractal_window::poll_events() {
+		auto timer = profiler.time(frame_stage::events);
 		glfwPollEvents();
 	}
 
+	bool fractal_window::idle() const noexcept {
+		// Input is handled before rendering, so the layer has caught up with it unless it's still being refined. A scroll
+		// that arrived while polling hasn't been handled yet, though.
+		return !continuous && next_refinement_level == refinement_divisors.size()
+			&& displayed_size == glm::ivec2(static_cast<int>(window_width), static_cast<int>(window_height)) && scroll_delta == 0.0;
+	}
+
+	void fractal_window::wait_events() {
+		if (!idle()) {
+			poll_events();
+			return;
+		}
+		auto timer = profiler.time(frame_stage::wait);
+		glfwWaitEvents();
+	}
+
 	glm::dvec2 fractal_window::mouse_position() const noexcept {
 		double x, y;
 		glfwGetCursorPos(window, &x, &y);
 		return { x, y };
 	}
 
+	const frame_profiler& fractal_window::frame_timings() const noexcept {
+		return profiler;
+	}
+
+	void fractal_window::write_frame_timings(const std::string& path_stem) const {
+		std::ofstream trace(path_stem + ".json");
+		std::ofstream csv(path_stem + ".csv");
+		if (!trace.is_open() || !csv.is_open()) {
+			throw std::runtime_error("Could not open " + path_stem + ".json or .csv for writing.");
+		}
+		profiler.write_chrome_trace(trace);
+		profiler.write_csv(csv);
+	}
+
 	fractal_window::~fractal_window() noexcept {
+		for (auto& timer_query : fractal_timer_queries) {
+			glDeleteQueries(1, &timer_query.query);
+		}
+		glDeleteFramebuffers(2, fractal_framebuffers.data());
+		glDeleteTextures(2, fractal_textures.data());
+		for (auto* array : { &zeros_texture, &coefficients_texture, &colors_texture, &grid_offsets_texture, &grid_candidates_texture }) {
+			glDeleteTextures(1, &array->texture);
+			glDeleteBuffers(1, &array->buffer);
+		}
+		glDeleteBuffers(1, &zeros_instance_vbo);
+		glDeleteVertexArrays(1, &zeros_vao);
 		glDeleteBuffers(1, &normal_square_vbo);
 		glDeleteVertexArrays(1, &normal_square_vao);
-		glDeleteShader(zeros_fragment_shader);
-		glDeleteShader(fractal_fragment_shader);
-		glDeleteShader(zeros_vertex_shader);
-		glDeleteShader(fractal_vertex_shader);
 		glDeleteProgram(zeros_shader_program);
 		glDeleteProgram(fractal_shader_program);
 		glfwDestroyWindow(window);
@@ -3,9 +3,19 @@
 #include <string>
 #include <complex>
 #include <chrono>
+#include <optional>
+#include <filesystem>
 #define GLM_FORCE_SWIZZLE
 #include <glm/glm.hpp>
 
+#include "newton_kernel.hpp"
+#include "newton_kernel_double_double.hpp"
+#include "frame_profiler.hpp"
+#include "zero_index.hpp"
+#include "program_cache.hpp"
+#include "input_recording.hpp"
+#include "frame_governor.hpp"
+
 struct GLFWwindow;
 
 namespace euleristic {
@@ -17,54 +27,194 @@ namespace euleristic {
 	// This class encapsulates an OpenGL context, manages the visuals and handles devices input.
 	class fractal_window {
 		GLFWwindow* window;
+		// For the time to the first frame
+		std::chrono::steady_clock::time_point created = std::chrono::steady_clock::now();
+
+		// First, so that the shader compilation in the constructor can be timed
+		frame_profiler profiler;
 
 		std::vector<std::complex<double>> coefficients;
 		std::vector<std::complex<double>> zeros;
-		std::vector<std::byte> zeros_vertex_buffer;
+		// One marker per zero, drawn instanced. The instances are only uploaded again when the zeros change.
+		struct zero_instance {
+			glm::dvec2 position; // In fractal space
+			glm::vec4 color;
+		};
+		std::vector<zero_instance> zeros_vertex_buffer;
+		bool zeros_vertex_buffer_dirty = true;
+		// A grid over the zeros, for picking them with the mouse and for the fractal shader to tell which zero a pixel
+		// converged to. Rebuilt when the zeros or epsilon change.
+		zero_index indexed_zeros;
+		double indexed_radius{};
+		bool zero_index_dirty = true;
+		// What early exit counts as converged, which depends on how close together the zeros are
+		double exit_epsilon_squared{};
 
-		std::string fractal_fragment_shader_source_template{};
-		std::string zeros_fragment_shader_source_template{};
+		// Buffer textures hold the fractal shader's zeros, coefficients, colors and grid, since uniform arrays only
+		// have room for a few hundred zeros. They are only uploaded again when something in them changes.
+		struct buffer_texture {
+			unsigned int buffer{};
+			unsigned int texture{};
+		};
+		buffer_texture zeros_texture, coefficients_texture, colors_texture, grid_offsets_texture, grid_candidates_texture;
+		bool fractal_buffers_dirty = true;
+		int max_texture_buffer_size{};
+
+		// How the shaders were built at startup, from the program cache or the compiler, for the first frame's report
+		program_cache::statistics shader_statistics{};
+		std::filesystem::path shader_cache_path{};
+		bool first_frame_reported{};
 
 		unsigned int normal_square_vbo{};
 		unsigned int normal_square_vao{};
+		unsigned int zeros_instance_vbo{};
+		unsigned int zeros_vao{};
 
-		unsigned int fractal_vertex_shader{};
-		unsigned int fractal_fragment_shader{};
 		unsigned int fractal_shader_program{};
-		unsigned int zeros_vertex_shader{};
-		unsigned int zeros_fragment_shader{};
 		unsigned int zeros_shader_program{};
 		unsigned int fractal_screen_rect_uniform{};
-		unsigned int fractal_coefficients_uniform{};
-		unsigned int fractal_zeros_uniform{};
-		unsigned int zeros_transform_uniform{};
-		unsigned int zeros_color_uniform{};
+		unsigned int fractal_evaluate_from_zeros_uniform{};
+		unsigned int fractal_degree_uniform{};
+		unsigned int fractal_iteration_count_uniform{};
+		unsigned int fractal_epsilon_squared_uniform{};
+		unsigned int fractal_exit_epsilon_squared_uniform{};
+		unsigned int fractal_step_squared_uniform{};
+		unsigned int fractal_screen_center_low_uniform{};
+		unsigned int fractal_double_double_uniform{};
+		unsigned int fractal_grid_origin_uniform{};
+		unsigned int fractal_grid_inverse_cell_size_uniform{};
+		unsigned int fractal_grid_size_uniform{};
+		unsigned int zeros_origin_uniform{};
+		unsigned int zeros_origin_low_uniform{};
+		unsigned int zeros_fractal_to_screen_uniform{};
+		unsigned int zeros_screen_to_normal_uniform{};
 
 		glm::dmat3 fractal_to_screen_space;
 		glm::dmat3 screen_to_fractal_space;
+		// What's left of screen_to_fractal_space's translation after rounding it to double. Zooming and panning keep track
+		// of it, so that a deep zoom stays where it is put and double-double rendering can place the pixels exactly.
+		glm::dvec2 translation_low{ 0.0 };
+
+		// The fractal is rendered into one of these textures, possibly at a fraction of the window's resolution, and blitted to the window.
+		// There are two so that a panned layer can be shifted from one into the other.
+		std::array<unsigned int, 2> fractal_framebuffers{};
+		std::array<unsigned int, 2> fractal_textures{};
+		size_t current_layer{};
+		int fractal_layer_width{}, fractal_layer_height{};
 
+		// Everything the fractal layer depends on, to tell when it has to be rendered again
+		struct fractal_state {
+			std::vector<std::complex<double>> zeros;
+			glm::dmat3 screen_to_fractal_space{};
+			glm::dvec2 translation_low{};
+			bool double_double_points{};
+			unsigned iteration_count{};
+			double epsilon_squared{};
+			bool early_exit{};
+			double step_squared{};
+			evaluation_mode evaluation{};
+			int width{}, height{};
+
+			bool operator==(const fractal_state&) const = default;
+		};
+		// GPU time of the fractal pass. The results are read back a few frames later, when they are ready, rather than
+		// stalling the pipeline, so there are a few queries in flight.
+		struct gpu_timer_query {
+			unsigned int query{};
+			std::uint32_t frame{};
+			frame_profiler::clock::time_point start{};
+			size_t shaded_pixels{}, window_pixels{};
+			bool pending{};
+		};
+		std::array<gpu_timer_query, 4> fractal_timer_queries{};
+		size_t next_timer_query{};
+
+		fractal_state rendered_state{};
+		size_t next_refinement_level{};
+		// The part of the layer that's blitted to the window, which is smaller than it while refining or governed
+		glm::ivec2 displayed_size{ 0 };
+
+		// What the handlers act on this frame, from poll_input or a replay
+		input_frame current_input{};
 		glm::dvec2 last_mouse_pos;
 		std::optional<size_t> held_zero{};
 		std::optional<size_t> zero_to_remove{};
 		bool last_left_mouse_button_state{};
 		bool last_right_mouse_button_state{};
+		bool last_evaluation_key_state{};
+		bool last_progressive_key_state{};
+		bool last_early_exit_key_state{};
+		bool last_continuous_key_state{};
+		bool last_timings_key_state{};
+		bool last_batch_key_state{};
+		bool last_governor_key_state{};
+
+		// The most zeros the fractal shader's buffer textures have room for
+		size_t max_degree{};
 
-		void recompile_shaders();
+		void compile_shaders(program_cache& cache);
+		// Prints how long the first frame took to get to the screen, and how much of that was shaders
+		void report_first_frame() noexcept;
 		void add_zero(const std::complex<double> zero) noexcept;
 		void remove_zero(const size_t index);
+		// Marks everything built from the zeros as out of date
+		void zeros_changed() noexcept;
+		void update_zero_index();
+		// Uploads the zeros, coefficients and grid if they changed, with the fractal shader in use
+		void update_fractal_buffers();
+		// The zero whose marker is under the given screen position, if any
+		std::optional<size_t> zero_at(glm::dvec2 screen_position);
+		// Moves the view by the screen space vector by, with the translation in double-double
+		void shift_fractal_space(glm::dvec2 by) noexcept;
+		// The newtons_fractal_batch options that render what's on screen, pixel for pixel
+		std::string batch_options() const;
+		fractal_state current_fractal_state() const;
+		void render_fractal_layer(int width, int height, bool clear) noexcept;
+		void collect_timer_queries() noexcept;
+		// If the only difference between the states is a translation by a whole number of pixels, that translation in screen space
+		static std::optional<glm::ivec2> pixel_aligned_pan(const fractal_state& from, const fractal_state& to);
 
 	public:
+		// The input as it is now, with the scrolling since the last call, for begin_frame or an input_recorder
+		input_frame poll_input() noexcept;
+		// Marks the start of a frame for the stage timings, and gives the handlers the input to act on. Anything that
+		// happens to the window follows from that input, so feeding in a recording plays the session back frame for frame.
+		void begin_frame(const input_frame& input) noexcept;
 		void handle_scroll_wheel() noexcept;
 		void handle_mouse_buttons() noexcept;
+		void handle_keyboard() noexcept;
 		double epsilon_squared = 0.1;
 		unsigned iteration_count = 20;
+		// Stop iterating a pixel once it is within epsilon of a zero, or once its step is shorter than sqrt(step_squared)
+		bool early_exit = true;
+		double step_squared = 1e-24;
+		evaluation_mode evaluation = evaluation_mode::coefficients;
+		// Automatic switches to double-double once zoomed in too far for double
+		precision_mode precision = precision_mode::automatic;
+		// Whether the fractal is currently iterated in double-double
+		bool double_double_points() const noexcept;
+		// Render a coarse fractal first while interacting, and refine it over the following frames
+		bool progressive = true;
+		// Render the full fractal every frame and never wait for events, rather than only when something it depends on changes
+		bool continuous = false;
+		// Shades the fractal at a lower resolution when it can't keep up with the frame budget. Press G to toggle it.
+		frame_governor governor;
+		bool governed = true;
+		// Whether the fractal layer is complete and up to date, so that the next frame can wait for something to happen
+		bool idle() const noexcept;
 
-		fractal_window(int width, int height);
+		// A window that isn't visible still renders, for replaying input without one popping up
+		fractal_window(int width, int height, bool visible = true);
 		void set_title(const char* title) noexcept;
 		void render() noexcept;
 		bool should_close() const noexcept;
 		void poll_events();
+		// Polls, or blocks until there is an event when idle
+		void wait_events();
 		glm::dvec2 mouse_position() const noexcept;
+		const frame_profiler& frame_timings() const noexcept;
+		// Writes the recent stage timings to path_stem.json, as a Chrome trace, and path_stem.csv
+		void write_frame_timings(const std::string& path_stem) const;
 
 		fractal_window(const fractal_window&) = default;
 		fractal_window& operator=(const fractal_window&) = default;
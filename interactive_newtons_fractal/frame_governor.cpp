@@ -0,0 +1,63 @@
+#include "frame_governor.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+namespace euleristic {
+
+	// Scales are kept to multiples of this, so that noise in the measurements doesn't change them by a pixel or two
+	constexpr double scale_quantum = 1.0 / 32.0;
+	// How much of each new measurement goes into the smoothed cost
+	constexpr double cost_smoothing = 0.3;
+
+	frame_governor::frame_governor(governor_settings settings) : config(settings) {
+		if (!(config.target.count() > 0.0)) {
+			throw std::invalid_argument("The frame budget must be positive.");
+		}
+		// The layers are the window's size, so there's no room to shade more pixels than it has
+		config.max_scale = std::clamp(config.max_scale, scale_quantum, 1.0);
+		config.min_scale = std::clamp(config.min_scale, scale_quantum, config.max_scale);
+		config.step_up = std::max(config.step_up, 1.0 + scale_quantum);
+		current_scale = config.max_scale;
+	}
+
+	void frame_governor::reset() noexcept {
+		current_scale = config.max_scale;
+		measured = false;
+		frames_over = frames_under = 0;
+	}
+
+	void frame_governor::record(std::chrono::duration<double, std::milli> elapsed, size_t shaded_pixels, size_t window_pixels) noexcept {
+		// Passes that only blitted a finished layer say nothing about the cost of shading
+		if (shaded_pixels == 0 || window_pixels == 0) return;
+
+		const double cost = elapsed.count() / static_cast<double>(shaded_pixels);
+		cost_per_pixel = measured ? cost_per_pixel + cost_smoothing * (cost - cost_per_pixel) : cost;
+		measured = true;
+
+		const auto full_pass = [&](double scale) {
+			return cost_per_pixel * static_cast<double>(window_pixels) * scale * scale;
+		};
+		const double target = config.target.count();
+
+		if (full_pass(current_scale) > target * config.over_budget) {
+			frames_under = 0;
+			if (++frames_over < config.frames_to_step_down) return;
+			frames_over = 0;
+			// Straight to the scale that should fit, since the pixels are what the time goes to
+			const double fitting = current_scale * std::sqrt(target / full_pass(current_scale));
+			current_scale = std::clamp(std::floor(fitting / scale_quantum) * scale_quantum, config.min_scale, config.max_scale);
+		}
+		else if (current_scale < config.max_scale && full_pass(std::min(current_scale * config.step_up, config.max_scale)) < target * config.headroom) {
+			frames_over = 0;
+			if (++frames_under < config.frames_to_step_up) return;
+			frames_under = 0;
+			const double stepped = std::ceil(current_scale * config.step_up / scale_quantum) * scale_quantum;
+			current_scale = std::clamp(stepped, config.min_scale, config.max_scale);
+		}
+		else {
+			frames_over = frames_under = 0;
+		}
+	}
+}
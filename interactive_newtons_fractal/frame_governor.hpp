@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace euleristic {
+
+	struct governor_settings {
+		// What the fractal pass may take on the GPU. A little under a 60 Hz frame, to leave room for the markers and the swap.
+		std::chrono::duration<double, std::milli> target{ 14.0 };
+		// Of the window's width and height. The fractal is never shaded at more than the window's resolution.
+		double min_scale = 0.25, max_scale = 1.0;
+		// The dead band: the scale goes down once a full pass would take over_budget times the target, and up once a
+		// step up would still come in under headroom times it
+		double over_budget = 1.1, headroom = 0.75;
+		// How many passes in a row have to agree before the scale changes. Down is quick, up is slow, so a single fast
+		// frame doesn't undo what a run of slow ones did.
+		size_t frames_to_step_down = 2, frames_to_step_up = 30;
+		double step_up = 1.25;
+	};
+
+	// Picks the resolution the fractal is shaded at, from how long the fractal passes take on the GPU, so that it stays
+	// within a frame budget at any degree and iteration count. Passes are measured per shaded pixel, which is what the
+	// scale controls, so a measurement that comes back a few frames late, from before the scale last changed, still
+	// counts. Nothing here touches OpenGL, like frame_profiler.
+	class frame_governor {
+	public:
+		explicit frame_governor(governor_settings settings = {});
+
+		// A fractal pass which shaded shaded_pixels in elapsed, in a window of window_pixels
+		void record(std::chrono::duration<double, std::milli> elapsed, size_t shaded_pixels, size_t window_pixels) noexcept;
+		// What to multiply the window's width and height by
+		double scale() const noexcept { return current_scale; }
+		const governor_settings& settings() const noexcept { return config; }
+		// Starts from max_scale again, forgetting what the passes cost, for when what they cost has changed completely
+		void reset() noexcept;
+
+	private:
+		governor_settings config;
+		double current_scale;
+		// Milliseconds, smoothed over the last few passes
+		double cost_per_pixel{};
+		bool measured{};
+		size_t frames_over{}, frames_under{};
+	};
+}
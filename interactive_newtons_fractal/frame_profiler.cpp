@@ -0,0 +1,143 @@
+#include "frame_profiler.hpp"
+
+#include <algorithm>
+#include <map>
+#include <format>
+#include <cmath>
+#include <stdexcept>
+
+namespace euleristic {
+
+	const char* to_string(frame_stage stage) noexcept {
+		switch (stage) {
+		case frame_stage::frame: return "frame";
+		case frame_stage::input: return "input";
+		case frame_stage::coefficients: return "coefficients";
+		case frame_stage::shader_compile: return "shader_compile";
+		case frame_stage::fractal_draw: return "fractal_draw";
+		case frame_stage::fractal_gpu: return "fractal_gpu";
+		case frame_stage::zero_markers: return "zero_markers";
+		case frame_stage::swap: return "swap";
+		case frame_stage::events: return "events";
+		case frame_stage::wait: return "wait";
+		}
+		return "unknown";
+	}
+
+	frame_profiler::scoped_timer::scoped_timer(frame_profiler& profiler, frame_stage stage) noexcept
+		: profiler(profiler), stage(stage), start(clock::now()) {}
+
+	frame_profiler::scoped_timer::~scoped_timer() noexcept {
+		profiler.record(stage, start, clock::now() - start);
+	}
+
+	frame_profiler::frame_profiler(size_t capacity) : epoch(clock::now()), frame_start(epoch), ring(capacity) {
+		if (capacity == 0) {
+			throw std::invalid_argument("The frame profiler needs room for at least one sample.");
+		}
+	}
+
+	void frame_profiler::begin_frame() noexcept {
+		const auto now = clock::now();
+		if (frame_started) {
+			record(frame_stage::frame, frame_start, now - frame_start);
+			++frame;
+		}
+		frame_started = true;
+		frame_start = now;
+	}
+
+	std::uint32_t frame_profiler::current_frame() const noexcept {
+		return frame;
+	}
+
+	frame_profiler::scoped_timer frame_profiler::time(frame_stage stage) noexcept {
+		return scoped_timer(*this, stage);
+	}
+
+	void frame_profiler::record(frame_stage stage, clock::time_point start, clock::duration duration) noexcept {
+		record(stage, frame, start, duration);
+	}
+
+	void frame_profiler::record(frame_stage stage, std::uint32_t frame, clock::time_point start, clock::duration duration) noexcept {
+		ring[next] = { stage, frame,
+			std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch).count(),
+			std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() };
+		next = (next + 1) % ring.size();
+		count = std::min(count + 1, ring.size());
+	}
+
+	std::vector<frame_profiler::sample> frame_profiler::samples() const {
+		std::vector<sample> ordered;
+		ordered.reserve(count);
+		const size_t oldest = (next + ring.size() - count) % ring.size();
+		for (size_t i = 0; i < count; ++i) {
+			ordered.push_back(ring[(oldest + i) % ring.size()]);
+		}
+		return ordered;
+	}
+
+	std::array<frame_profiler::stage_summary, frame_stage_count> frame_profiler::summarize() const {
+		// A stage may run more than once a frame, input for one, and it's the total per frame that makes a spike
+		std::array<std::map<std::uint32_t, double>, frame_stage_count> per_frame;
+		for (const auto& sample : samples()) {
+			per_frame[static_cast<size_t>(sample.stage)][sample.frame] += static_cast<double>(sample.duration) / 1e6;
+		}
+
+		std::array<stage_summary, frame_stage_count> summaries{};
+		for (size_t stage = 0; stage < frame_stage_count; ++stage) {
+			std::vector<double> sorted;
+			for (const auto& [frame, duration] : per_frame[stage]) sorted.push_back(duration);
+			if (sorted.empty()) continue;
+			std::ranges::sort(sorted);
+			const auto percentile = [&](double share) {
+				const auto rank = static_cast<size_t>(std::ceil(share * static_cast<double>(sorted.size())));
+				return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+			};
+			double total = 0.0;
+			for (const double duration : sorted) total += duration;
+			summaries[stage] = { sorted.size(), total / static_cast<double>(sorted.size()),
+				percentile(0.50), percentile(0.95), percentile(0.99), sorted.back() };
+		}
+		return summaries;
+	}
+
+	void frame_profiler::write_chrome_trace(std::ostream& stream) const {
+		// Complete events, in microseconds. The frames get a track of their own so that they don't hide the stages.
+		const auto track = [](frame_stage stage) {
+			if (stage == frame_stage::frame) return 1;
+			if (stage == frame_stage::fractal_gpu) return 3;
+			return 2;
+		};
+		stream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+		stream << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"Frames\"}},\n";
+		stream << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 2, \"args\": {\"name\": \"CPU\"}},\n";
+		stream << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 3, \"args\": {\"name\": \"GPU\"}}";
+		for (const auto& sample : samples()) {
+			stream << std::format(",\n{{\"name\": \"{}\", \"cat\": \"{}\", \"ph\": \"X\", \"ts\": {:.3f}, \"dur\": {:.3f}, "
+				"\"pid\": 1, \"tid\": {}, \"args\": {{\"frame\": {}}}}}",
+				to_string(sample.stage), sample.stage == frame_stage::fractal_gpu ? "gpu" : "cpu",
+				static_cast<double>(sample.start) / 1e3, static_cast<double>(sample.duration) / 1e3, track(sample.stage), sample.frame);
+		}
+		stream << "\n]}\n";
+	}
+
+	void frame_profiler::write_csv(std::ostream& stream) const {
+		stream << "frame,stage,start_us,duration_us\n";
+		for (const auto& sample : samples()) {
+			stream << std::format("{},{},{:.3f},{:.3f}\n", sample.frame, to_string(sample.stage),
+				static_cast<double>(sample.start) / 1e3, static_cast<double>(sample.duration) / 1e3);
+		}
+	}
+
+	void frame_profiler::write_summary(std::ostream& stream) const {
+		const auto summaries = summarize();
+		stream << std::format("{:<16}{:>8}{:>10}{:>10}{:>10}{:>10}{:>10}\n", "stage (ms)", "count", "mean", "p50", "p95", "p99", "max");
+		for (size_t stage = 0; stage < frame_stage_count; ++stage) {
+			const auto& summary = summaries[stage];
+			if (summary.count == 0) continue;
+			stream << std::format("{:<16}{:>8}{:>10.3f}{:>10.3f}{:>10.3f}{:>10.3f}{:>10.3f}\n", to_string(static_cast<frame_stage>(stage)),
+				summary.count, summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+		}
+	}
+}
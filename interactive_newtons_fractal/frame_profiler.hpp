@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace euleristic {
+
+	// What a frame of fractal_window spends its time on. The stages may nest: coefficient updates happen during input
+	// handling, and the fractal pass is timed on both the CPU (how long it takes to issue) and the GPU.
+	enum class frame_stage {
+		frame, // Everything from one begin_frame to the next, including any wait
+		input, // Scroll wheel, mouse buttons and keyboard
+		coefficients, // Expanding or updating the coefficients after a zero is added, moved or removed
+		shader_compile,
+		fractal_draw, // Issuing the fractal pass, including shifting a panned layer and blitting it to the window
+		fractal_gpu, // The fractal pass on the GPU, from a timer query
+		zero_markers,
+		swap,
+		events, // glfwPollEvents
+		wait // Blocked in glfwWaitEvents, with nothing left to draw
+	};
+
+	constexpr size_t frame_stage_count = 10;
+
+	const char* to_string(frame_stage stage) noexcept;
+
+	// Collects per stage timings into a fixed size ring buffer, so recording never allocates and a long session only
+	// keeps its most recent samples. Nothing here touches OpenGL; GPU timings are measured by the caller and recorded
+	// like any other.
+	class frame_profiler {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		struct sample {
+			frame_stage stage;
+			std::uint32_t frame;
+			// Nanoseconds since the profiler was created
+			std::int64_t start, duration;
+		};
+
+		struct stage_summary {
+			// Frames
+			size_t count{};
+			// All in milliseconds
+			double mean{}, p50{}, p95{}, p99{}, max{};
+		};
+
+		// Records the time from its construction to its destruction as one sample of stage
+		class scoped_timer {
+			frame_profiler& profiler;
+			frame_stage stage;
+			clock::time_point start;
+		public:
+			scoped_timer(frame_profiler& profiler, frame_stage stage) noexcept;
+			~scoped_timer() noexcept;
+			scoped_timer(const scoped_timer&) = delete;
+			scoped_timer& operator=(const scoped_timer&) = delete;
+		};
+
+		explicit frame_profiler(size_t capacity = 1 << 16);
+
+		// Starts a new frame, and records the previous one as a sample of frame_stage::frame
+		void begin_frame() noexcept;
+		std::uint32_t current_frame() const noexcept;
+
+		[[nodiscard]] scoped_timer time(frame_stage stage) noexcept;
+		void record(frame_stage stage, clock::time_point start, clock::duration duration) noexcept;
+		// For samples measured after the fact, such as a GPU timer query read back frames later
+		void record(frame_stage stage, std::uint32_t frame, clock::time_point start, clock::duration duration) noexcept;
+
+		// The samples still in the ring buffer, oldest first
+		std::vector<sample> samples() const;
+		// Nearest rank percentiles of each stage's total per frame, over the samples still in the ring buffer. Indexed by
+		// frame_stage, and counting only the frames the stage ran in.
+		std::array<stage_summary, frame_stage_count> summarize() const;
+
+		// For chrome://tracing or Perfetto, with the CPU stages on one track and the GPU's on another
+		void write_chrome_trace(std::ostream& stream) const;
+		void write_csv(std::ostream& stream) const;
+		// A table of summarize() for people
+		void write_summary(std::ostream& stream) const;
+
+	private:
+		clock::time_point epoch;
+		clock::time_point frame_start;
+		std::uint32_t frame{};
+		bool frame_started{};
+		std::vector<sample> ring;
+		size_t next{}, count{};
+	};
+}
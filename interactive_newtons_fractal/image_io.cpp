@@ -0,0 +1,203 @@
+#include "image_io.hpp"
+
+#include <array>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace euleristic {
+
+	const char* to_string(image_format format) noexcept {
+		switch (format) {
+		case image_format::ppm: return "ppm";
+		case image_format::png: return "png";
+		case image_format::raw: return "raw";
+		default: return "unknown image format";
+		}
+	}
+
+	image_format parse_image_format(std::string_view name) {
+		if (name == "ppm") return image_format::ppm;
+		if (name == "png") return image_format::png;
+		if (name == "raw") return image_format::raw;
+		throw std::invalid_argument("Unknown image format: "s + std::string(name));
+	}
+
+	image_format image_format_from_path(const std::filesystem::path& path) noexcept {
+		auto extension = path.extension().string();
+		if (extension == ".ppm") return image_format::ppm;
+		if (extension == ".png") return image_format::png;
+		return image_format::raw;
+	}
+
+	// PNG bits
+
+	constexpr std::array<std::uint32_t, 256> crc_table = [] {
+		std::array<std::uint32_t, 256> table{};
+		for (std::uint32_t n = 0; n < 256; ++n) {
+			std::uint32_t c = n;
+			for (int k = 0; k < 8; ++k) {
+				c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			}
+			table[n] = c;
+		}
+		return table;
+	}();
+
+	std::uint32_t update_crc(std::uint32_t crc, const std::uint8_t* data, size_t size) noexcept {
+		for (size_t i = 0; i < size; ++i) {
+			crc = crc_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		}
+		return crc;
+	}
+
+	void append_big_endian(std::string& destination, std::uint32_t value) {
+		destination += static_cast<char>(value >> 24);
+		destination += static_cast<char>(value >> 16);
+		destination += static_cast<char>(value >> 8);
+		destination += static_cast<char>(value);
+	}
+
+	void write_png_chunk(std::ostream& output, const char* type, const std::string& data) {
+		std::string chunk;
+		append_big_endian(chunk, static_cast<std::uint32_t>(data.size()));
+		chunk += type;
+		chunk += data;
+		const auto crc = update_crc(0xffffffffu, reinterpret_cast<const std::uint8_t*>(chunk.data()) + 4, chunk.size() - 4) ^ 0xffffffffu;
+		append_big_endian(chunk, crc);
+		output.write(chunk.data(), chunk.size());
+	}
+
+	// Stored deflate blocks hold at most 65535 bytes, and a chunk is kept well clear of the 2^31 byte limit
+	constexpr size_t max_stored_block_size = 65535;
+	constexpr size_t max_idat_size = size_t{ 1 } << 26;
+
+	void append_stored_block(std::string& destination, std::string_view data, bool last) {
+		destination += static_cast<char>(last ? 1 : 0);
+		destination += static_cast<char>(data.size() & 0xff);
+		destination += static_cast<char>(data.size() >> 8);
+		destination += static_cast<char>(~data.size() & 0xff);
+		destination += static_cast<char>((~data.size() >> 8) & 0xff);
+		destination += data;
+	}
+
+	std::uint32_t update_adler(std::uint32_t adler, std::string_view data) noexcept {
+		std::uint32_t a = adler & 0xffff, b = adler >> 16;
+		for (unsigned char byte : data) {
+			a = (a + byte) % 65521;
+			b = (b + a) % 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	image_row_writer::image_row_writer(std::ostream& output, size_t width, size_t height, image_format format, state resume_from)
+		: output(output), width(width), height(height), format(format), progress(resume_from) {
+		if (progress.rows_written > height) {
+			throw std::invalid_argument("Can't resume past the last row of the image.");
+		}
+		if (progress.rows_written > 0) return;
+
+		switch (format) {
+		case image_format::ppm:
+			output << "P6\n" << width << ' ' << height << "\n255\n";
+			break;
+		case image_format::png: {
+			constexpr char signature[] = "\x89PNG\r\n\x1a\n";
+			output.write(signature, 8);
+			std::string header;
+			append_big_endian(header, static_cast<std::uint32_t>(width));
+			append_big_endian(header, static_cast<std::uint32_t>(height));
+			header += "\x08\x06\x00\x00\x00"s; // 8 bits per channel, RGBA, deflate, standard filters, no interlacing
+			write_png_chunk(output, "IHDR", header);
+			// The zlib stream's header goes in an IDAT chunk of its own, so that every band's chunks look the same
+			write_png_chunk(output, "IDAT", "\x78\x01"s);
+			break;
+		}
+		case image_format::raw:
+			break;
+		}
+		if (!output) {
+			throw std::runtime_error("Failed to write "s + to_string(format) + " image.");
+		}
+	}
+
+	void image_row_writer::write_rows(const image& band) {
+		if (band.width != width || progress.rows_written + band.height > height) {
+			throw std::invalid_argument("The band doesn't fit the rest of the image.");
+		}
+
+		switch (format) {
+		case image_format::ppm: {
+			std::string rgb;
+			rgb.reserve(3 * band.pixels.size());
+			for (auto pixel : band.pixels) {
+				rgb += static_cast<char>(pixel.r);
+				rgb += static_cast<char>(pixel.g);
+				rgb += static_cast<char>(pixel.b);
+			}
+			output.write(rgb.data(), rgb.size());
+			break;
+		}
+		case image_format::png: {
+			// Each row is prefixed with its filter type, 0 for none, and as many rows as fit go into each chunk
+			const size_t row_size = 4 * width + 1;
+			const size_t rows_per_chunk = std::max<size_t>(1, max_idat_size / row_size);
+			std::string filtered, compressed;
+			for (size_t first_row = 0; first_row < band.height; first_row += rows_per_chunk) {
+				const size_t rows = std::min(rows_per_chunk, band.height - first_row);
+				filtered.assign(row_size * rows, '\0');
+				for (size_t y = 0; y < rows; ++y) {
+					std::copy_n(reinterpret_cast<const char*>(band.pixels.data() + (first_row + y) * width), 4 * width,
+						filtered.begin() + y * row_size + 1);
+				}
+				progress.adler = update_adler(progress.adler, filtered);
+
+				compressed.clear();
+				for (size_t offset = 0; offset < filtered.size(); offset += max_stored_block_size) {
+					append_stored_block(compressed, std::string_view(filtered).substr(offset, max_stored_block_size), false);
+				}
+				write_png_chunk(output, "IDAT", compressed);
+			}
+			break;
+		}
+		case image_format::raw:
+			output.write(reinterpret_cast<const char*>(band.pixels.data()), band.pixels.size() * sizeof(glm::u8vec4));
+			break;
+		}
+		if (!output) {
+			throw std::runtime_error("Failed to write "s + to_string(format) + " image.");
+		}
+		progress.rows_written += band.height;
+	}
+
+	void image_row_writer::finish() {
+		if (progress.rows_written != height) {
+			throw std::logic_error("The image isn't complete.");
+		}
+		if (format == image_format::png) {
+			// An empty last block closes the deflate stream, and the Adler-32 of the uncompressed data closes the zlib stream
+			std::string trailer;
+			append_stored_block(trailer, {}, true);
+			append_big_endian(trailer, progress.adler);
+			write_png_chunk(output, "IDAT", trailer);
+			write_png_chunk(output, "IEND", "");
+		}
+		output.flush();
+		if (!output) {
+			throw std::runtime_error("Failed to write "s + to_string(format) + " image.");
+		}
+	}
+
+	const image_row_writer::state& image_row_writer::current_state() const noexcept {
+		return progress;
+	}
+
+	void write_image(std::ostream& output, const image& source, image_format format) {
+		image_row_writer writer(output, source.width, source.height, format);
+		writer.write_rows(source);
+		writer.finish();
+	}
+}
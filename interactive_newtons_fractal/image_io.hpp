@@ -0,0 +1,58 @@
+#pragma once
+
+#include <ostream>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+#include "cpu_renderer.hpp"
+
+namespace euleristic {
+
+	enum class image_format {
+		ppm, // Binary P6, the alpha channel is dropped
+		png, // 8 bit RGBA, stored without compression, so it's fast to write and needs no zlib
+		raw // Bare RGBA bytes, row after row, for piping into encoders
+	};
+
+	const char* to_string(image_format format) noexcept;
+
+	// From "ppm", "png" or "raw". Throws on anything else.
+	image_format parse_image_format(std::string_view name);
+
+	// From the extension of path, raw if it has none that is known.
+	image_format image_format_from_path(const std::filesystem::path& path) noexcept;
+
+	void write_image(std::ostream& output, const image& source, image_format format);
+
+	// How far an image_row_writer got
+	struct image_row_writer_state {
+		std::uint64_t rows_written{};
+		// The running Adler-32 of the PNG's zlib stream
+		std::uint32_t adler = 1;
+	};
+
+	// Writes an image a band of rows at a time, top to bottom, so that images far larger than memory can be streamed to
+	// a file. A PNG gets an IDAT chunk (or a few, for wide bands) per band. What the writer needs to carry on is small
+	// enough to save after every band, so an interrupted export can pick up where it left off.
+	class image_row_writer {
+	public:
+		using state = image_row_writer_state;
+
+		// Writes the header, unless resuming from a state with rows already written, in which case output has to be
+		// positioned right after them.
+		image_row_writer(std::ostream& output, size_t width, size_t height, image_format format, state resume_from = {});
+
+		// Appends the rows of band, which has to be as wide as the image and no taller than what's left of it
+		void write_rows(const image& band);
+		// Writes the trailer, once all the rows are in
+		void finish();
+		const state& current_state() const noexcept;
+
+	private:
+		std::ostream& output;
+		size_t width, height;
+		image_format format;
+		state progress;
+	};
+}
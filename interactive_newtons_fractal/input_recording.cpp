@@ -0,0 +1,136 @@
+#include "input_recording.hpp"
+
+#include <bit>
+#include <array>
+#include <string>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+namespace euleristic {
+
+	constexpr std::array<char, 4> input_recording_magic = { 'N', 'F', 'I', 'R' };
+	constexpr std::uint32_t input_recording_version = 1;
+
+	// Byte by byte, so recordings move between machines
+	void write_le(std::ostream& output, std::uint64_t value, int bytes) {
+		for (int byte = 0; byte < bytes; ++byte) {
+			output.put(static_cast<char>((value >> (8 * byte)) & 0xff));
+		}
+	}
+
+	std::uint64_t read_le(std::istream& input, int bytes) {
+		std::uint64_t value = 0;
+		for (int byte = 0; byte < bytes; ++byte) {
+			const auto c = input.get();
+			if (c == std::char_traits<char>::eof()) return 0;
+			value |= static_cast<std::uint64_t>(static_cast<unsigned char>(c)) << (8 * byte);
+		}
+		return value;
+	}
+
+	bool input_frame::same_input(const input_frame& other) const noexcept {
+		return cursor_x == other.cursor_x && cursor_y == other.cursor_y && scroll == other.scroll
+			&& buttons == other.buttons && keys == other.keys;
+	}
+
+	input_recorder::input_recorder(const std::filesystem::path& path, int window_width, int window_height)
+		: output(path, std::ios::binary | std::ios::trunc), path(path) {
+		if (!output.is_open()) {
+			throw std::runtime_error("Could not open " + path.string() + " for recording.");
+		}
+		output.write(input_recording_magic.data(), input_recording_magic.size());
+		write_le(output, input_recording_version, 4);
+		write_le(output, static_cast<std::uint32_t>(window_width), 4);
+		write_le(output, static_cast<std::uint32_t>(window_height), 4);
+	}
+
+	void write_record(std::ostream& output, std::uint32_t index, const input_frame& frame) {
+		write_le(output, index, 4);
+		write_le(output, std::bit_cast<std::uint64_t>(frame.time), 8);
+		write_le(output, std::bit_cast<std::uint64_t>(frame.cursor_x), 8);
+		write_le(output, std::bit_cast<std::uint64_t>(frame.cursor_y), 8);
+		write_le(output, std::bit_cast<std::uint64_t>(frame.scroll), 8);
+		write_le(output, frame.buttons, 1);
+		write_le(output, frame.keys, 1);
+	}
+
+	void input_recorder::record(const input_frame& frame) {
+		// A scroll is an event, not a state, so two scrolls in a row are two records
+		const bool changed = frame_count == 0 || !frame.same_input(previous) || frame.scroll != 0.0;
+		if (changed) {
+			write_record(output, frame_count, frame);
+		}
+		previous = frame;
+		previous_written = changed;
+		++frame_count;
+	}
+
+	void input_recorder::finish() {
+		if (frame_count > 0 && !previous_written) {
+			write_record(output, frame_count - 1, previous);
+			previous_written = true;
+		}
+		output.flush();
+		if (!output) {
+			throw std::runtime_error("Could not write the input recording " + path.string());
+		}
+	}
+
+	input_recorder::~input_recorder() noexcept {
+		try {
+			finish();
+		} catch (...) {}
+	}
+
+	input_replay::input_replay(const std::filesystem::path& path) {
+		std::ifstream input(path, std::ios::binary);
+		if (!input.is_open()) {
+			throw std::runtime_error("Could not open the input recording " + path.string());
+		}
+		std::array<char, 4> magic{};
+		input.read(magic.data(), magic.size());
+		if (!input || magic != input_recording_magic) {
+			throw std::runtime_error(path.string() + " isn't an input recording.");
+		}
+		const auto version = read_le(input, 4);
+		if (version != input_recording_version) {
+			throw std::runtime_error(path.string() + " is an input recording of version " + std::to_string(version)
+				+ ", but only version " + std::to_string(input_recording_version) + " can be replayed.");
+		}
+		width = static_cast<int>(read_le(input, 4));
+		height = static_cast<int>(read_le(input, 4));
+		if (!input || width <= 0 || height <= 0) {
+			throw std::runtime_error(path.string() + " is truncated.");
+		}
+
+		while (input.peek() != std::char_traits<char>::eof()) {
+			record next{};
+			next.index = static_cast<std::uint32_t>(read_le(input, 4));
+			next.input.time = std::bit_cast<double>(read_le(input, 8));
+			next.input.cursor_x = std::bit_cast<double>(read_le(input, 8));
+			next.input.cursor_y = std::bit_cast<double>(read_le(input, 8));
+			next.input.scroll = std::bit_cast<double>(read_le(input, 8));
+			next.input.buttons = static_cast<std::uint8_t>(read_le(input, 1));
+			next.input.keys = static_cast<std::uint8_t>(read_le(input, 1));
+			// A recording cut short by a crash still replays up to its last whole record
+			if (!input) break;
+			if (!records.empty() && next.index <= records.back().index) {
+				throw std::runtime_error(path.string() + " has its frames out of order.");
+			}
+			records.push_back(next);
+		}
+		frames = records.empty() ? 0 : static_cast<size_t>(records.back().index) + 1;
+	}
+
+	input_frame input_replay::frame(size_t index) const noexcept {
+		// The last record at or before the frame
+		const auto after = std::ranges::upper_bound(records, index, {}, [](const record& each) { return static_cast<size_t>(each.index); });
+		if (after == records.begin()) return {};
+		auto frame = std::prev(after)->input;
+		if (std::prev(after)->index != index) {
+			frame.scroll = 0.0;
+		}
+		return frame;
+	}
+}
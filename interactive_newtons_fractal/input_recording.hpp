@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <filesystem>
+
+namespace euleristic {
+
+	constexpr std::uint8_t left_mouse_button = 1 << 0;
+	constexpr std::uint8_t right_mouse_button = 1 << 1;
+
+	// The keys fractal_window reacts to, as bits of input_frame::keys
+	constexpr std::uint8_t evaluation_key = 1 << 0; // E
+	constexpr std::uint8_t progressive_key = 1 << 1; // P
+	constexpr std::uint8_t early_exit_key = 1 << 2; // X
+	constexpr std::uint8_t continuous_key = 1 << 3; // C
+	constexpr std::uint8_t timings_key = 1 << 4; // T
+	constexpr std::uint8_t batch_key = 1 << 5; // B
+	constexpr std::uint8_t governor_key = 1 << 6; // G
+
+	// Everything fractal_window's input handlers look at in a frame. Recording this once per frame, rather than GLFW's
+	// events as they come, is what makes a replay deterministic: the handlers see exactly the same input on the same
+	// frame, however long the frames take this time around.
+	struct input_frame {
+		double time{}; // Seconds since the recording started
+		double cursor_x{}, cursor_y{}; // Screen space
+		double scroll{}; // Scrolled since the previous frame
+		std::uint8_t buttons{};
+		std::uint8_t keys{};
+
+		// Whether the handlers would see the same thing, whenever it happened
+		bool same_input(const input_frame& other) const noexcept;
+	};
+
+	// Writes the input of consecutive frames to a file. A frame is only written when its input differs from the one
+	// before, or when it scrolls, so sitting still costs nothing and a drag costs 38 bytes a frame. The format is a
+	// header (magic, version, window size) and then records of frame index, time, cursor, scroll, buttons and keys,
+	// little-endian.
+	class input_recorder {
+	public:
+		input_recorder(const std::filesystem::path& path, int window_width, int window_height);
+		void record(const input_frame& frame);
+		// Writes the last frame, if it wasn't already, so a replay knows how long the recording was. The destructor
+		// does this too, but can't say if it failed.
+		void finish();
+		~input_recorder() noexcept;
+
+		input_recorder(const input_recorder&) = delete;
+		input_recorder& operator=(const input_recorder&) = delete;
+
+	private:
+		std::ofstream output;
+		std::filesystem::path path;
+		input_frame previous{};
+		std::uint32_t frame_count{};
+		bool previous_written{};
+	};
+
+	// A recording read back whole, frame by frame
+	class input_replay {
+	public:
+		explicit input_replay(const std::filesystem::path& path);
+
+		int window_width() const noexcept { return width; }
+		int window_height() const noexcept { return height; }
+		size_t frame_count() const noexcept { return frames; }
+		// The input of the given frame: the last recorded frame's state, but scrolls only on the frame they happened in
+		input_frame frame(size_t index) const noexcept;
+
+	private:
+		struct record {
+			std::uint32_t index;
+			input_frame input;
+		};
+		std::vector<record> records;
+		int width{}, height{};
+		size_t frames{};
+	};
+}
@@ -3,24 +3,117 @@
 #include <vector>
 #include <iostream>
 #include <format>
+#include <optional>
+#include <string_view>
+#include <thread>
 #include "fractal_window.hpp"
+#include "input_recording.hpp"
+#include "frame_governor.hpp"
+
+constexpr const char* usage =
+	"Usage: interactive_newtons_fractal [options]\n"
+	"  --record FILE     write the input of every frame to FILE, to replay the session later\n"
+	"  --replay FILE     play FILE back instead of taking input, then write the frame timings and exit\n"
+	"  --realtime        replay at the pace it was recorded at, rather than a recorded frame per frame as fast as possible\n"
+	"  --hidden          replay without showing the window\n"
+	"  --timings STEM    where the replay's timings go, as STEM.json and STEM.csv (default replay_timings)\n"
+	"  --frame-budget MS what the fractal pass may take on the GPU before its resolution is lowered (default 14)\n"
+	"  --min-scale S     the lowest resolution the governor goes to, as a share of the window's (default 0.25)\n"
+	"  --max-scale S     the highest, at most 1 (default 1)\n";
+
+constexpr int initial_width = 800, initial_height = 600;
+
+struct command_line {
+	std::optional<std::string> record, replay;
+	bool realtime = false, hidden = false;
+	std::string timings = "replay_timings";
+	euleristic::governor_settings governor;
+};
+
+command_line parse_command_line(int argc, char** argv) {
+	command_line options;
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view argument = argv[i];
+		const auto value = [&]() -> std::string {
+			if (i + 1 >= argc) throw std::invalid_argument(std::format("{} needs a value.", argument));
+			return argv[++i];
+		};
+		if (argument == "--record") options.record = value();
+		else if (argument == "--replay") options.replay = value();
+		else if (argument == "--timings") options.timings = value();
+		else if (argument == "--frame-budget") options.governor.target = std::chrono::duration<double, std::milli>(std::stod(value()));
+		else if (argument == "--min-scale") options.governor.min_scale = std::stod(value());
+		else if (argument == "--max-scale") options.governor.max_scale = std::stod(value());
+		else if (argument == "--realtime") options.realtime = true;
+		else if (argument == "--hidden") options.hidden = true;
+		else throw std::invalid_argument(std::format("Unknown option {}.\n{}", argument, usage));
+	}
+	if (options.record && options.replay) throw std::invalid_argument("--record and --replay can't be used together.");
+	if ((options.realtime || options.hidden) && !options.replay) throw std::invalid_argument("--realtime and --hidden are for --replay.");
+	return options;
+}
+
+auto main(int argc, char** argv) -> int {
+	for (int i = 1; i < argc; ++i) {
+		if (std::string_view(argv[i]) == "--help") {
+			std::cout << usage;
+			return 0;
+		}
+	}
 
-auto main() -> int {
 	try {
-		euleristic::fractal_window fractal(800, 600);
-		auto last_frame = std::chrono::steady_clock::now();
+		const auto options = parse_command_line(argc, argv);
+
+		// A replay opens the window at the size the recording started at, since that decides what every pixel shows.
+		// Resizing the window while recording isn't recorded.
+		std::optional<euleristic::input_replay> replay;
+		if (options.replay) replay.emplace(*options.replay);
+
+		euleristic::fractal_window fractal(replay ? replay->window_width() : initial_width,
+			replay ? replay->window_height() : initial_height, !options.hidden);
+		fractal.governor = euleristic::frame_governor(options.governor);
+
+		std::optional<euleristic::input_recorder> recorder;
+		if (options.record) recorder.emplace(*options.record, initial_width, initial_height);
+
 		std::chrono::duration<double, std::milli> delta_time{};
-		while (!fractal.should_close()) {
-			
+		const auto replay_start = std::chrono::steady_clock::now();
+		for (size_t frame = 0; !fractal.should_close(); ++frame) {
+			if (replay && frame == replay->frame_count()) break;
+			const auto input = replay ? replay->frame(frame) : fractal.poll_input();
+			if (replay && options.realtime) {
+				std::this_thread::sleep_until(replay_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double>(input.time - replay->frame(0).time)));
+			}
+			if (recorder) recorder->record(input);
+
+			const auto frame_start = std::chrono::steady_clock::now();
+			fractal.begin_frame(input);
 			fractal.handle_scroll_wheel();
 			fractal.handle_mouse_buttons();
+			fractal.handle_keyboard();
 			fractal.render();
-			fractal.poll_events();
+			// The time spent waiting for events doesn't count
+			delta_time = std::chrono::steady_clock::now() - frame_start;
+
+			fractal.set_title(std::format("Newton's Fractal! # of iterations: {}. Epsilon squared: {}. Evaluated from: {}. Early exit: {}. Precision: {}. Interactive resolution: {:.0f}%{}. Frame duration: {:.5}ms.",
+				fractal.iteration_count, fractal.epsilon_squared, euleristic::to_string(fractal.evaluation), fractal.early_exit ? "on" : "off",
+				fractal.double_double_points() ? "double-double" : "double",
+				100.0 * (fractal.governed ? fractal.governor.scale() : 1.0), fractal.governed ? "" : " (governor off)",
+				delta_time.count()).c_str());
+			// A replay never waits for events, since the next frame's input is already there
+			if (replay) fractal.poll_events();
+			else fractal.wait_events();
+		}
 
-			fractal.set_title(std::format("Newton's Fractal! # of iterations: {}. Epsilon squared: {}. Frame duration: {:.5}ms.",
-				fractal.iteration_count, fractal.epsilon_squared, delta_time.count()).c_str());
-			delta_time = std::chrono::steady_clock::now() - last_frame;
-			last_frame = std::chrono::steady_clock::now();
+		if (recorder) recorder->finish();
+		if (replay) {
+			const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - replay_start;
+			std::cout << std::format("Replayed {} frames in {:.3f} s, {:.2f} frames/s.\n", replay->frame_count(), elapsed.count(),
+				elapsed.count() > 0.0 ? static_cast<double>(replay->frame_count()) / elapsed.count() : 0.0);
+			fractal.frame_timings().write_summary(std::cout);
+			fractal.write_frame_timings(options.timings);
+			std::cout << std::format("Wrote {0}.json and {0}.csv.\n", options.timings);
 		}
 	} catch (euleristic::graphics_error err) {
 		std::cerr << "A fatal error was encountered. Code: " << err.code_name << ". " << err.message << '\n';
@@ -30,4 +123,4 @@ auto main() -> int {
 		std::cerr << "Unknown error";
 	}
 	return 0;
-}
\ No newline at end of file
+}
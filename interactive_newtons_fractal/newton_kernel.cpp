@@ -0,0 +1,624 @@
+#include "newton_kernel.hpp"
+#include "newton_kernel_double_double.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace euleristic {
+
+	newton_polynomial::newton_polynomial(std::span<const std::complex<double>> coefficients) {
+		if (coefficients.size() < 2) {
+			throw std::invalid_argument("Newton's method needs a polynomial of at least degree one.");
+		}
+		for (auto coefficient = coefficients.rbegin(); coefficient != coefficients.rend(); ++coefficient) {
+			real.push_back(coefficient->real());
+			imag.push_back(coefficient->imag());
+		}
+	}
+
+	size_t newton_polynomial::degree() const noexcept {
+		return real.size() - 1;
+	}
+
+	newton_zeros::newton_zeros(std::span<const std::complex<double>> zeros) {
+		if (zeros.empty()) {
+			throw std::invalid_argument("Newton's method needs a polynomial of at least degree one.");
+		}
+		for (auto zero : zeros) {
+			real.push_back(zero.real());
+			imag.push_back(zero.imag());
+		}
+	}
+
+	size_t newton_zeros::count() const noexcept {
+		return real.size();
+	}
+
+	const char* to_string(evaluation_mode mode) noexcept {
+		switch (mode) {
+		case evaluation_mode::coefficients: return "coefficients";
+		case evaluation_mode::zeros: return "zeros";
+		default: return "unknown evaluation mode";
+		}
+	}
+
+	const char* to_string(iteration_method method) noexcept {
+		switch (method) {
+		case iteration_method::newton: return "newton";
+		case iteration_method::halley: return "halley";
+		case iteration_method::householder: return "householder";
+		case iteration_method::multiplicity: return "multiplicity";
+		default: return "unknown iteration method";
+		}
+	}
+
+	const char* to_string(precision_mode precision) noexcept {
+		switch (precision) {
+		case precision_mode::automatic: return "automatic";
+		case precision_mode::standard: return "double";
+		case precision_mode::double_double: return "double-double";
+		default: return "unknown precision";
+		}
+	}
+
+	const char* to_string(instruction_set isa) noexcept {
+		switch (isa) {
+		case instruction_set::scalar: return "scalar";
+		case instruction_set::avx2: return "AVX2";
+		case instruction_set::avx512: return "AVX-512";
+		default: return "unknown instruction set";
+		}
+	}
+
+	instruction_set best_supported_instruction_set() noexcept {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return instruction_set::scalar;
+
+		__cpuid(info, 1);
+		const bool fma = info[2] & (1 << 12);
+		const bool osxsave = info[2] & (1 << 27);
+		if (!osxsave) return instruction_set::scalar;
+
+		// The OS has to save the vector registers on context switches, or they're of no use
+		const auto enabled_state = _xgetbv(0);
+		const bool ymm_enabled = (enabled_state & 0x06) == 0x06;
+		const bool zmm_enabled = (enabled_state & 0xe6) == 0xe6;
+
+		__cpuidex(info, 7, 0);
+		const bool avx2 = info[1] & (1 << 5);
+		const bool avx512f = info[1] & (1 << 16);
+
+		if (avx512f && zmm_enabled) return instruction_set::avx512;
+		if (avx2 && fma && ymm_enabled) return instruction_set::avx2;
+		return instruction_set::scalar;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		if (__builtin_cpu_supports("avx512f")) return instruction_set::avx512;
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return instruction_set::avx2;
+		return instruction_set::scalar;
+#else
+		return instruction_set::scalar;
+#endif
+	}
+
+	newton_kernel select_newton_kernel(instruction_set isa) {
+		if (isa > best_supported_instruction_set()) {
+			throw std::invalid_argument(std::string(to_string(isa)) + " isn't supported by this CPU.");
+		}
+		switch (isa) {
+		case instruction_set::avx512: return newton_iterate_avx512;
+		case instruction_set::avx2: return newton_iterate_avx2;
+		default: return newton_iterate_scalar;
+		}
+	}
+
+	product_form_kernel select_product_form_kernel(instruction_set isa) {
+		if (isa > best_supported_instruction_set()) {
+			throw std::invalid_argument(std::string(to_string(isa)) + " isn't supported by this CPU.");
+		}
+		switch (isa) {
+		case instruction_set::avx512: return newton_iterate_product_form_avx512;
+		case instruction_set::avx2: return newton_iterate_product_form_avx2;
+		default: return newton_iterate_product_form_scalar;
+		}
+	}
+
+	newton_exit make_newton_exit(std::span<const std::complex<double>> zeros, unsigned iteration_count,
+		double epsilon_squared, double step_squared) noexcept {
+		double exit_epsilon_squared = epsilon_squared;
+		for (size_t i = 0; i < zeros.size(); ++i) {
+			for (size_t j = i + 1; j < zeros.size(); ++j) {
+				exit_epsilon_squared = std::min(exit_epsilon_squared, std::norm(zeros[i] - zeros[j]) / 16.0);
+			}
+		}
+		return { iteration_count, exit_epsilon_squared, step_squared };
+	}
+
+	newton_kernel_double_double select_newton_kernel_double_double(instruction_set isa) {
+		if (isa > best_supported_instruction_set()) {
+			throw std::invalid_argument(std::string(to_string(isa)) + " isn't supported by this CPU.");
+		}
+		switch (isa) {
+		case instruction_set::avx512: return newton_iterate_double_double_avx512;
+		case instruction_set::avx2: return newton_iterate_double_double_avx2;
+		default: return newton_iterate_double_double_scalar;
+		}
+	}
+
+	product_form_kernel_double_double select_product_form_kernel_double_double(instruction_set isa) {
+		if (isa > best_supported_instruction_set()) {
+			throw std::invalid_argument(std::string(to_string(isa)) + " isn't supported by this CPU.");
+		}
+		switch (isa) {
+		case instruction_set::avx512: return newton_iterate_product_form_double_double_avx512;
+		case instruction_set::avx2: return newton_iterate_product_form_double_double_avx2;
+		default: return newton_iterate_product_form_double_double_scalar;
+		}
+	}
+
+	bool within_epsilon(const newton_zeros& zeros, double epsilon_squared, double z_real, double z_imag) noexcept {
+		for (size_t j = 0; j < zeros.count(); ++j) {
+			const double difference_real = z_real - zeros.real[j], difference_imag = z_imag - zeros.imag[j];
+			if (difference_real * difference_real + difference_imag * difference_imag < epsilon_squared) return true;
+		}
+		return false;
+	}
+
+	void newton_iterate_scalar(const newton_polynomial& polynomial, const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept {
+		const size_t degree = polynomial.degree();
+		const double* coefficient_real = polynomial.real.data();
+		const double* coefficient_imag = polynomial.imag.data();
+
+		for (size_t i = 0; i < count; ++i) {
+			double z_real = real[i], z_imag = imag[i];
+			unsigned iteration = 0;
+			while (iteration < exit.iteration_count) {
+				if (exit.epsilon_squared > 0.0 && within_epsilon(zeros, exit.epsilon_squared, z_real, z_imag)) break;
+
+				// Horner's method for p and p' at once: p' = p' * z + p, then p = p * z + c
+				double p_real = coefficient_real[0], p_imag = coefficient_imag[0];
+				double p_prime_real = 0.0, p_prime_imag = 0.0;
+				for (size_t n = 1; n <= degree; ++n) {
+					const double next_p_prime_real = p_prime_real * z_real - p_prime_imag * z_imag + p_real;
+					p_prime_imag = p_prime_real * z_imag + p_prime_imag * z_real + p_imag;
+					p_prime_real = next_p_prime_real;
+
+					const double next_p_real = p_real * z_real - p_imag * z_imag + coefficient_real[n];
+					p_imag = p_real * z_imag + p_imag * z_real + coefficient_imag[n];
+					p_real = next_p_real;
+				}
+				// z -= p / p'
+				const double inverse_norm = 1.0 / (p_prime_real * p_prime_real + p_prime_imag * p_prime_imag);
+				const double step_real = (p_real * p_prime_real + p_imag * p_prime_imag) * inverse_norm;
+				const double step_imag = (p_imag * p_prime_real - p_real * p_prime_imag) * inverse_norm;
+				z_real -= step_real;
+				z_imag -= step_imag;
+				++iteration;
+
+				// Written so that NaN stops too
+				if (!(step_real * step_real + step_imag * step_imag >= exit.step_squared)) break;
+			}
+			real[i] = z_real;
+			imag[i] = z_imag;
+			iterations[i] = iteration;
+		}
+	}
+
+	void newton_iterate_product_form_scalar(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept {
+		const size_t zero_count = zeros.count();
+		const double* zero_real = zeros.real.data();
+		const double* zero_imag = zeros.imag.data();
+
+		for (size_t i = 0; i < count; ++i) {
+			double z_real = real[i], z_imag = imag[i];
+			unsigned iteration = 0;
+			while (iteration < exit.iteration_count) {
+				if (exit.epsilon_squared > 0.0 && within_epsilon(zeros, exit.epsilon_squared, z_real, z_imag)) break;
+
+				double sum_real = 0.0, sum_imag = 0.0;
+				for (size_t block = 0; block < zero_count; block += product_form_block_size) {
+					const size_t block_end = std::min(block + product_form_block_size, zero_count);
+
+					// The block's sum of reciprocals as the fraction n/d
+					double n_real = 1.0, n_imag = 0.0;
+					double d_real = z_real - zero_real[block], d_imag = z_imag - zero_imag[block];
+					for (size_t j = block + 1; j < block_end; ++j) {
+						const double difference_real = z_real - zero_real[j], difference_imag = z_imag - zero_imag[j];
+
+						const double next_n_real = n_real * difference_real - n_imag * difference_imag + d_real;
+						n_imag = n_real * difference_imag + n_imag * difference_real + d_imag;
+						n_real = next_n_real;
+
+						const double next_d_real = d_real * difference_real - d_imag * difference_imag;
+						d_imag = d_real * difference_imag + d_imag * difference_real;
+						d_real = next_d_real;
+					}
+
+					const double inverse_norm = 1.0 / (d_real * d_real + d_imag * d_imag);
+					sum_real += (n_real * d_real + n_imag * d_imag) * inverse_norm;
+					sum_imag += (n_imag * d_real - n_real * d_imag) * inverse_norm;
+				}
+				// z -= 1 / sum. A point that has landed right on a zero gets 0 * inf = NaN for a step, but it has converged.
+				const double inverse_norm = 1.0 / (sum_real * sum_real + sum_imag * sum_imag);
+				const double step_real = sum_real * inverse_norm, step_imag = -sum_imag * inverse_norm;
+				if (step_real == step_real && step_imag == step_imag) {
+					z_real -= step_real;
+					z_imag -= step_imag;
+				}
+				++iteration;
+
+				if (!(step_real * step_real + step_imag * step_imag >= exit.step_squared)) break;
+			}
+			real[i] = z_real;
+			imag[i] = z_imag;
+			iterations[i] = iteration;
+		}
+	}
+
+	// The higher order methods' steps, as numerator / denominator so that they take one complex division like Newton's.
+	// In the coefficient form they're made of p, p' and h = p * p''/2, which comes to p * p' / (p'^2 - h) for Halley's,
+	// p * (p'^2 + h) / p'^3 for Householder's and p * p' / (p'^2 - 2h) for Schroeder's.
+	template<iteration_method method>
+	void higher_order_iterate(const newton_polynomial& polynomial, const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept {
+		const size_t degree = polynomial.degree();
+		const double* coefficient_real = polynomial.real.data();
+		const double* coefficient_imag = polynomial.imag.data();
+
+		for (size_t i = 0; i < count; ++i) {
+			double z_real = real[i], z_imag = imag[i];
+			unsigned iteration = 0;
+			while (iteration < exit.iteration_count) {
+				if (exit.epsilon_squared > 0.0 && within_epsilon(zeros, exit.epsilon_squared, z_real, z_imag)) break;
+
+				// Horner's method for p, p' and p''/2 at once, each updated from the one below it before that moves on
+				double p_real = coefficient_real[0], p_imag = coefficient_imag[0];
+				double p_prime_real = 0.0, p_prime_imag = 0.0;
+				double half_p_second_real = 0.0, half_p_second_imag = 0.0;
+				for (size_t n = 1; n <= degree; ++n) {
+					const double next_half_p_second_real = half_p_second_real * z_real - half_p_second_imag * z_imag + p_prime_real;
+					half_p_second_imag = half_p_second_real * z_imag + half_p_second_imag * z_real + p_prime_imag;
+					half_p_second_real = next_half_p_second_real;
+
+					const double next_p_prime_real = p_prime_real * z_real - p_prime_imag * z_imag + p_real;
+					p_prime_imag = p_prime_real * z_imag + p_prime_imag * z_real + p_imag;
+					p_prime_real = next_p_prime_real;
+
+					const double next_p_real = p_real * z_real - p_imag * z_imag + coefficient_real[n];
+					p_imag = p_real * z_imag + p_imag * z_real + coefficient_imag[n];
+					p_real = next_p_real;
+				}
+
+				const double square_real = p_prime_real * p_prime_real - p_prime_imag * p_prime_imag;
+				const double square_imag = 2.0 * p_prime_real * p_prime_imag;
+				const double h_real = p_real * half_p_second_real - p_imag * half_p_second_imag;
+				const double h_imag = p_real * half_p_second_imag + p_imag * half_p_second_real;
+
+				double numerator_real, numerator_imag, denominator_real, denominator_imag;
+				if constexpr (method == iteration_method::householder) {
+					const double sum_real = square_real + h_real, sum_imag = square_imag + h_imag;
+					numerator_real = p_real * sum_real - p_imag * sum_imag;
+					numerator_imag = p_real * sum_imag + p_imag * sum_real;
+					denominator_real = p_prime_real * square_real - p_prime_imag * square_imag;
+					denominator_imag = p_prime_real * square_imag + p_prime_imag * square_real;
+				}
+				else {
+					constexpr double h_weight = method == iteration_method::halley ? 1.0 : 2.0;
+					numerator_real = p_real * p_prime_real - p_imag * p_prime_imag;
+					numerator_imag = p_real * p_prime_imag + p_imag * p_prime_real;
+					denominator_real = square_real - h_weight * h_real;
+					denominator_imag = square_imag - h_weight * h_imag;
+				}
+
+				const double inverse_norm = 1.0 / (denominator_real * denominator_real + denominator_imag * denominator_imag);
+				const double step_real = (numerator_real * denominator_real + numerator_imag * denominator_imag) * inverse_norm;
+				const double step_imag = (numerator_imag * denominator_real - numerator_real * denominator_imag) * inverse_norm;
+				z_real -= step_real;
+				z_imag -= step_imag;
+				++iteration;
+
+				if (!(step_real * step_real + step_imag * step_imag >= exit.step_squared)) break;
+			}
+			real[i] = z_real;
+			imag[i] = z_imag;
+			iterations[i] = iteration;
+		}
+	}
+
+	// In product form they're made of s = p'/p = sum(1 / (z - zeros[i])) and t = sum(1 / (z - zeros[i])^2), which is
+	// (p'/p)^2 - p''/p, and come to 2s / (s^2 + t) for Halley's, (3s^2 - t) / 2s^3 for Householder's and s / t for
+	// Schroeder's. t is summed blockwise like s: a block's share of it is minus the derivative of its fraction n/d, which
+	// is (n * d' - n' * d) / d^2, and n' and d' are carried along with n and d.
+	template<iteration_method method>
+	void higher_order_iterate_product_form(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept {
+		const size_t zero_count = zeros.count();
+		const double* zero_real = zeros.real.data();
+		const double* zero_imag = zeros.imag.data();
+
+		for (size_t i = 0; i < count; ++i) {
+			double z_real = real[i], z_imag = imag[i];
+			unsigned iteration = 0;
+			while (iteration < exit.iteration_count) {
+				if (exit.epsilon_squared > 0.0 && within_epsilon(zeros, exit.epsilon_squared, z_real, z_imag)) break;
+
+				double s_real = 0.0, s_imag = 0.0, t_real = 0.0, t_imag = 0.0;
+				for (size_t block = 0; block < zero_count; block += product_form_block_size) {
+					const size_t block_end = std::min(block + product_form_block_size, zero_count);
+
+					double n_real = 1.0, n_imag = 0.0, n_prime_real = 0.0, n_prime_imag = 0.0;
+					double d_real = z_real - zero_real[block], d_imag = z_imag - zero_imag[block];
+					double d_prime_real = 1.0, d_prime_imag = 0.0;
+					for (size_t j = block + 1; j < block_end; ++j) {
+						const double difference_real = z_real - zero_real[j], difference_imag = z_imag - zero_imag[j];
+
+						// n' = n' * (z - a) + n + d', and d' = d' * (z - a) + d, before n and d move on
+						const double next_n_prime_real = n_prime_real * difference_real - n_prime_imag * difference_imag + n_real + d_prime_real;
+						n_prime_imag = n_prime_real * difference_imag + n_prime_imag * difference_real + n_imag + d_prime_imag;
+						n_prime_real = next_n_prime_real;
+
+						const double next_n_real = n_real * difference_real - n_imag * difference_imag + d_real;
+						n_imag = n_real * difference_imag + n_imag * difference_real + d_imag;
+						n_real = next_n_real;
+
+						const double next_d_prime_real = d_prime_real * difference_real - d_prime_imag * difference_imag + d_real;
+						d_prime_imag = d_prime_real * difference_imag + d_prime_imag * difference_real + d_imag;
+						d_prime_real = next_d_prime_real;
+
+						const double next_d_real = d_real * difference_real - d_imag * difference_imag;
+						d_imag = d_real * difference_imag + d_imag * difference_real;
+						d_real = next_d_real;
+					}
+
+					const double inverse_norm = 1.0 / (d_real * d_real + d_imag * d_imag);
+					s_real += (n_real * d_real + n_imag * d_imag) * inverse_norm;
+					s_imag += (n_imag * d_real - n_real * d_imag) * inverse_norm;
+
+					// Divided by d twice rather than by d^2 once, which would underflow far sooner
+					const double m_real = n_real * d_prime_real - n_imag * d_prime_imag - (n_prime_real * d_real - n_prime_imag * d_imag);
+					const double m_imag = n_real * d_prime_imag + n_imag * d_prime_real - (n_prime_real * d_imag + n_prime_imag * d_real);
+					const double quotient_real = (m_real * d_real + m_imag * d_imag) * inverse_norm;
+					const double quotient_imag = (m_imag * d_real - m_real * d_imag) * inverse_norm;
+					t_real += (quotient_real * d_real + quotient_imag * d_imag) * inverse_norm;
+					t_imag += (quotient_imag * d_real - quotient_real * d_imag) * inverse_norm;
+				}
+
+				double numerator_real, numerator_imag, denominator_real, denominator_imag;
+				if constexpr (method == iteration_method::multiplicity) {
+					numerator_real = s_real;
+					numerator_imag = s_imag;
+					denominator_real = t_real;
+					denominator_imag = t_imag;
+				}
+				else {
+					const double square_real = s_real * s_real - s_imag * s_imag, square_imag = 2.0 * s_real * s_imag;
+					if constexpr (method == iteration_method::halley) {
+						numerator_real = 2.0 * s_real;
+						numerator_imag = 2.0 * s_imag;
+						denominator_real = square_real + t_real;
+						denominator_imag = square_imag + t_imag;
+					}
+					else {
+						numerator_real = 3.0 * square_real - t_real;
+						numerator_imag = 3.0 * square_imag - t_imag;
+						denominator_real = 2.0 * (s_real * square_real - s_imag * square_imag);
+						denominator_imag = 2.0 * (s_real * square_imag + s_imag * square_real);
+					}
+				}
+
+				// A point right on a zero gets inf / inf = NaN for a step, as in the Newton kernel, but it has converged
+				const double inverse_norm = 1.0 / (denominator_real * denominator_real + denominator_imag * denominator_imag);
+				const double step_real = (numerator_real * denominator_real + numerator_imag * denominator_imag) * inverse_norm;
+				const double step_imag = (numerator_imag * denominator_real - numerator_real * denominator_imag) * inverse_norm;
+				if (step_real == step_real && step_imag == step_imag) {
+					z_real -= step_real;
+					z_imag -= step_imag;
+				}
+				++iteration;
+
+				if (!(step_real * step_real + step_imag * step_imag >= exit.step_squared)) break;
+			}
+			real[i] = z_real;
+			imag[i] = z_imag;
+			iterations[i] = iteration;
+		}
+	}
+
+	void higher_order_iterate_scalar(iteration_method method, const newton_polynomial& polynomial, const newton_zeros& zeros,
+		const newton_exit& exit, double* real, double* imag, unsigned* iterations, size_t count) noexcept {
+		switch (method) {
+		case iteration_method::halley: return higher_order_iterate<iteration_method::halley>(polynomial, zeros, exit, real, imag, iterations, count);
+		case iteration_method::householder: return higher_order_iterate<iteration_method::householder>(polynomial, zeros, exit, real, imag, iterations, count);
+		case iteration_method::multiplicity: return higher_order_iterate<iteration_method::multiplicity>(polynomial, zeros, exit, real, imag, iterations, count);
+		default: return newton_iterate_scalar(polynomial, zeros, exit, real, imag, iterations, count);
+		}
+	}
+
+	void higher_order_iterate_product_form_scalar(iteration_method method, const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept {
+		switch (method) {
+		case iteration_method::halley: return higher_order_iterate_product_form<iteration_method::halley>(zeros, exit, real, imag, iterations, count);
+		case iteration_method::householder: return higher_order_iterate_product_form<iteration_method::householder>(zeros, exit, real, imag, iterations, count);
+		case iteration_method::multiplicity: return higher_order_iterate_product_form<iteration_method::multiplicity>(zeros, exit, real, imag, iterations, count);
+		default: return newton_iterate_product_form_scalar(zeros, exit, real, imag, iterations, count);
+		}
+	}
+
+	double flops_per_iteration(iteration_method method, evaluation_mode evaluation, size_t degree) noexcept {
+		const double n = static_cast<double>(degree);
+		// 5 per zero in within_epsilon
+		const double exit_test = 5.0 * n;
+
+		if (evaluation == evaluation_mode::coefficients) {
+			// 8 per coefficient for each of p, p' and p''/2, and then the step: 12 for the division, 2 to take it and 3
+			// to measure it, plus what goes into the numerator and denominator
+			switch (method) {
+			case iteration_method::halley: return exit_test + 24.0 * n + 36.0;
+			case iteration_method::householder: return exit_test + 24.0 * n + 42.0;
+			case iteration_method::multiplicity: return exit_test + 24.0 * n + 38.0;
+			default: return exit_test + 16.0 * n + 17.0;
+			}
+		}
+
+		// The first zero of a block costs only its difference, each of the others 16 for n and d and 18 more for n'
+		// and d'. Closing a block takes 14, and 32 more for its share of t.
+		const double blocks = std::ceil(n / static_cast<double>(product_form_block_size));
+		switch (method) {
+		case iteration_method::halley: return exit_test + 2.0 * blocks + 34.0 * (n - blocks) + 46.0 * blocks + 26.0;
+		case iteration_method::householder: return exit_test + 2.0 * blocks + 34.0 * (n - blocks) + 46.0 * blocks + 34.0;
+		case iteration_method::multiplicity: return exit_test + 2.0 * blocks + 34.0 * (n - blocks) + 46.0 * blocks + 17.0;
+		default: return exit_test + 2.0 * blocks + 16.0 * (n - blocks) + 14.0 * blocks + 11.0;
+		}
+	}
+
+	void newton_iterate_double_double_scalar(const newton_polynomial& polynomial, const newton_zeros& zeros,
+		const newton_exit& exit, double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations,
+		size_t count) noexcept {
+		const size_t degree = polynomial.degree();
+		const double* coefficient_real = polynomial.real.data();
+		const double* coefficient_imag = polynomial.imag.data();
+
+		for (size_t i = 0; i < count; ++i) {
+			double_double z_real(real[i], real_low[i]), z_imag(imag[i], imag_low[i]);
+			unsigned iteration = 0;
+			while (iteration < exit.iteration_count) {
+				if (exit.epsilon_squared > 0.0 && within_epsilon(zeros, exit.epsilon_squared, z_real.hi, z_imag.hi)) break;
+
+				// The same Horner's method as in double, operation for operation
+				double_double p_real = coefficient_real[0], p_imag = coefficient_imag[0];
+				double_double p_prime_real{}, p_prime_imag{};
+				for (size_t n = 1; n <= degree; ++n) {
+					const auto next_p_prime_real = sloppy_add(sloppy_subtract(p_prime_real * z_real, p_prime_imag * z_imag), p_real);
+					p_prime_imag = sloppy_add(sloppy_add(p_prime_real * z_imag, p_prime_imag * z_real), p_imag);
+					p_prime_real = next_p_prime_real;
+
+					const auto next_p_real = sloppy_add(sloppy_subtract(p_real * z_real, p_imag * z_imag), coefficient_real[n]);
+					p_imag = sloppy_add(sloppy_add(p_real * z_imag, p_imag * z_real), coefficient_imag[n]);
+					p_real = next_p_real;
+				}
+				const auto inverse_norm = double_double(1.0) / sloppy_add(p_prime_real * p_prime_real, p_prime_imag * p_prime_imag);
+				const auto step_real = sloppy_add(p_real * p_prime_real, p_imag * p_prime_imag) * inverse_norm;
+				const auto step_imag = sloppy_subtract(p_imag * p_prime_real, p_real * p_prime_imag) * inverse_norm;
+				z_real = sloppy_subtract(z_real, step_real);
+				z_imag = sloppy_subtract(z_imag, step_imag);
+				++iteration;
+
+				if (!(step_real.hi * step_real.hi + step_imag.hi * step_imag.hi >= exit.step_squared)) break;
+			}
+			real[i] = z_real.hi;
+			real_low[i] = z_real.lo;
+			imag[i] = z_imag.hi;
+			imag_low[i] = z_imag.lo;
+			iterations[i] = iteration;
+		}
+	}
+
+	void newton_iterate_product_form_double_double_scalar(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations, size_t count) noexcept {
+		const size_t zero_count = zeros.count();
+		const double* zero_real = zeros.real.data();
+		const double* zero_imag = zeros.imag.data();
+
+		for (size_t i = 0; i < count; ++i) {
+			double_double z_real(real[i], real_low[i]), z_imag(imag[i], imag_low[i]);
+			unsigned iteration = 0;
+			while (iteration < exit.iteration_count) {
+				if (exit.epsilon_squared > 0.0 && within_epsilon(zeros, exit.epsilon_squared, z_real.hi, z_imag.hi)) break;
+
+				double_double sum_real{}, sum_imag{};
+				for (size_t block = 0; block < zero_count; block += product_form_block_size) {
+					const size_t block_end = std::min(block + product_form_block_size, zero_count);
+
+					double_double n_real = 1.0, n_imag{};
+					double_double d_real = sloppy_subtract(z_real, zero_real[block]), d_imag = sloppy_subtract(z_imag, zero_imag[block]);
+					for (size_t j = block + 1; j < block_end; ++j) {
+						const auto difference_real = sloppy_subtract(z_real, zero_real[j]);
+						const auto difference_imag = sloppy_subtract(z_imag, zero_imag[j]);
+
+						const auto next_n_real = sloppy_add(sloppy_subtract(n_real * difference_real, n_imag * difference_imag), d_real);
+						n_imag = sloppy_add(sloppy_add(n_real * difference_imag, n_imag * difference_real), d_imag);
+						n_real = next_n_real;
+
+						const auto next_d_real = sloppy_subtract(d_real * difference_real, d_imag * difference_imag);
+						d_imag = sloppy_add(d_real * difference_imag, d_imag * difference_real);
+						d_real = next_d_real;
+					}
+
+					const auto inverse_norm = double_double(1.0) / sloppy_add(d_real * d_real, d_imag * d_imag);
+					sum_real = sloppy_add(sum_real, sloppy_add(n_real * d_real, n_imag * d_imag) * inverse_norm);
+					sum_imag = sloppy_add(sum_imag, sloppy_subtract(n_imag * d_real, n_real * d_imag) * inverse_norm);
+				}
+				const auto inverse_norm = double_double(1.0) / sloppy_add(sum_real * sum_real, sum_imag * sum_imag);
+				const auto step_real = sum_real * inverse_norm, step_imag = -(sum_imag * inverse_norm);
+				if (step_real.hi == step_real.hi && step_imag.hi == step_imag.hi) {
+					z_real = sloppy_subtract(z_real, step_real);
+					z_imag = sloppy_subtract(z_imag, step_imag);
+				}
+				++iteration;
+
+				if (!(step_real.hi * step_real.hi + step_imag.hi * step_imag.hi >= exit.step_squared)) break;
+			}
+			real[i] = z_real.hi;
+			real_low[i] = z_real.lo;
+			imag[i] = z_imag.hi;
+			imag_low[i] = z_imag.lo;
+			iterations[i] = iteration;
+		}
+	}
+
+	// Runs a single step of both the reference and the kernel under test, and measures how far apart they land
+	template<typename run_type>
+	double kernel_deviation(run_type run_kernel, run_type run_reference, std::span<const std::complex<double>> points) {
+		std::vector<double> reference_real, reference_imag;
+		for (auto point : points) {
+			reference_real.push_back(point.real());
+			reference_imag.push_back(point.imag());
+		}
+		auto kernel_real = reference_real, kernel_imag = reference_imag;
+		std::vector<unsigned> iterations(points.size());
+
+		run_reference(reference_real.data(), reference_imag.data(), iterations.data());
+		run_kernel(kernel_real.data(), kernel_imag.data(), iterations.data());
+
+		double deviation = 0.0;
+		for (size_t i = 0; i < points.size(); ++i) {
+			const std::complex<double> expected(reference_real[i], reference_imag[i]);
+			if (!std::isfinite(expected.real()) || !std::isfinite(expected.imag())) continue;
+			const std::complex<double> result(kernel_real[i], kernel_imag[i]);
+			deviation = std::max(deviation, std::abs(result - expected) / std::max(1.0, std::abs(expected)));
+		}
+		return deviation;
+	}
+
+	double newton_kernel_deviation(newton_kernel kernel, const newton_polynomial& polynomial, const newton_zeros& zeros,
+		std::span<const std::complex<double>> points) {
+		const newton_exit single_step{ 1 };
+		const auto bind = [&](newton_kernel bound) {
+			return std::function<void(double*, double*, unsigned*)>([&, bound](double* real, double* imag, unsigned* iterations) {
+				bound(polynomial, zeros, single_step, real, imag, iterations, points.size());
+			});
+		};
+		return kernel_deviation(bind(kernel), bind(newton_iterate_scalar), points);
+	}
+
+	double newton_kernel_deviation(product_form_kernel kernel, const newton_zeros& zeros,
+		std::span<const std::complex<double>> points) {
+		const newton_exit single_step{ 1 };
+		const auto bind = [&](product_form_kernel bound) {
+			return std::function<void(double*, double*, unsigned*)>([&, bound](double* real, double* imag, unsigned* iterations) {
+				bound(zeros, single_step, real, imag, iterations, points.size());
+			});
+		};
+		return kernel_deviation(bind(kernel), bind(newton_iterate_product_form_scalar), points);
+	}
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <span>
+
+namespace euleristic {
+
+	// The coefficients of a polynomial laid out for the iteration kernels: real and imaginary parts in separate arrays,
+	// highest power first, since the kernels evaluate p and p' together with Horner's method.
+	struct newton_polynomial {
+		std::vector<double> real;
+		std::vector<double> imag;
+
+		// The coefficients are lowest power first, as returned by zeros_to_coefficients.
+		explicit newton_polynomial(std::span<const std::complex<double>> coefficients);
+
+		size_t degree() const noexcept;
+	};
+
+	// The zeros of a polynomial laid out for the product form kernels, real and imaginary parts in separate arrays.
+	// Since p'/p = sum(1 / (z - zeros[i])), a Newton step is z - 1 / sum(1 / (z - zeros[i])), which needs no coefficients
+	// at all. That costs about as much per zero as Horner's method does per coefficient, but it doesn't lose accuracy
+	// with the degree the way the expanded coefficients do, so it is the way to go for hundreds or thousands of zeros.
+	struct newton_zeros {
+		std::vector<double> real;
+		std::vector<double> imag;
+
+		explicit newton_zeros(std::span<const std::complex<double>> zeros);
+
+		size_t count() const noexcept;
+	};
+
+	// How the Newton step is computed.
+	enum class evaluation_mode {
+		coefficients, // p and p' from the expanded coefficients, with Horner's method
+		zeros // p'/p from the zeros, in product form
+	};
+
+	const char* to_string(evaluation_mode mode) noexcept;
+
+	// Which step the points take. Newton's method converges quadratically to simple zeros, but only linearly to multiple
+	// ones, and near clusters of zeros it takes many steps before it gets there. The others need p'' as well, which
+	// makes each step more expensive, in exchange for fewer of them.
+	enum class iteration_method {
+		newton, // z - p/p'
+		halley, // z - 2pp' / (2p'^2 - pp''), cubic convergence to simple zeros
+		householder, // z - p/p' * (1 + pp'' / 2p'^2), Householder's third order method, also cubic
+		multiplicity // z - pp' / (p'^2 - pp''), Schroeder's: Newton's step times an estimate of the multiplicity, quadratic to multiple zeros too
+	};
+
+	const char* to_string(iteration_method method) noexcept;
+
+	// The reciprocals in the product form are summed in blocks of this many zeros, as fractions: n/d + 1/(z - a) is
+	// (n * (z - a) + d) / (d * (z - a)), so a block takes complex multiplications only, and one division at the end.
+	// Divisions are by far the slowest vector instructions, so this is what makes the product form kernels fast.
+	// The blocks are short enough that d can't overflow unless |z - zeros[i]| is around 1e77.
+	constexpr size_t product_form_block_size = 4;
+
+	// When a point stops iterating: after iteration_count steps at the latest, but before that as soon as it is within
+	// sqrt(epsilon_squared) of a zero, or as soon as a step is shorter than sqrt(step_squared). Most points get there in
+	// a handful of steps. Thresholds of 0 never stop early, which iterates every point the full count, like it used to.
+	// A step that isn't finite stops the point too, since no further step will be.
+	struct newton_exit {
+		unsigned iteration_count = 20;
+		double epsilon_squared = 0.0;
+		double step_squared = 0.0;
+	};
+
+	// The exit condition for coloring by which zero a point ends up within sqrt(epsilon_squared) of. Stopping the moment
+	// a point gets within epsilon of a zero would be wrong when the zeros are closer together than epsilon, because it
+	// may be within epsilon of more than one of them, and still on its way to the other. The exit radius is therefore
+	// shrunk to a quarter of the least distance between two zeros, where that is smaller.
+	newton_exit make_newton_exit(std::span<const std::complex<double>> zeros, unsigned iteration_count,
+		double epsilon_squared, double step_squared) noexcept;
+
+	// Whether (z_real, z_imag) is within sqrt(epsilon_squared) of any of the zeros.
+	bool within_epsilon(const newton_zeros& zeros, double epsilon_squared, double z_real, double z_imag) noexcept;
+
+	// Applies Newton steps to each of the count points whose real and imaginary parts are stored in the real and imag
+	// arrays, in place, until exit says to stop, and stores how many steps each point took in iterations. The zeros are
+	// only there to measure epsilon against.
+	using newton_kernel = void (*)(const newton_polynomial& polynomial, const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept;
+
+	// The same, in product form.
+	using product_form_kernel = void (*)(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept;
+
+	enum class instruction_set {
+		scalar,
+		avx2, // 4 points per instruction, requires AVX2 and FMA
+		avx512 // 8 points per instruction, requires AVX-512F
+	};
+
+	const char* to_string(instruction_set isa) noexcept;
+
+	// The widest instruction set that both the CPU and the OS support.
+	instruction_set best_supported_instruction_set() noexcept;
+
+	// Throws if isa isn't supported by the CPU.
+	newton_kernel select_newton_kernel(instruction_set isa);
+	product_form_kernel select_product_form_kernel(instruction_set isa);
+
+	// The scalar kernel is the reference the vectorized ones are checked against.
+	void newton_iterate_scalar(const newton_polynomial& polynomial, const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept;
+	void newton_iterate_avx2(const newton_polynomial& polynomial, const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept;
+	void newton_iterate_avx512(const newton_polynomial& polynomial, const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept;
+
+	void newton_iterate_product_form_scalar(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept;
+	void newton_iterate_product_form_avx2(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept;
+	void newton_iterate_product_form_avx512(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept;
+
+	// The methods other than Newton's, which are scalar only. Given iteration_method::newton they run the scalar Newton
+	// kernels. In the coefficient form p'' comes out of the same Horner loop as p and p', and in product form
+	// p''/p = (p'/p)^2 - sum(1 / (z - zeros[i])^2), with the second sum taken blockwise as the derivative of the first
+	// block's fraction, so it still takes a single division per block.
+	void higher_order_iterate_scalar(iteration_method method, const newton_polynomial& polynomial, const newton_zeros& zeros,
+		const newton_exit& exit, double* real, double* imag, unsigned* iterations, size_t count) noexcept;
+	void higher_order_iterate_product_form_scalar(iteration_method method, const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept;
+
+	// The floating point operations the scalar kernels take for a single step of the given method, exit test included,
+	// counted off the code: every addition, subtraction, multiplication and division counts as one, though a division
+	// takes several times as long. Both forms take one division per step and one per block of zeros whatever the method,
+	// so the count is a fair measure of how much more work a higher order step is.
+	double flops_per_iteration(iteration_method method, evaluation_mode evaluation, size_t degree) noexcept;
+
+	// The vectorized kernels (of either form) perform the same operations in the same order as the scalar one, except that they fuse
+	// multiplications and additions, which rounds once instead of twice. A single Newton step from the same starting
+	// point therefore lands within this distance of the scalar result, relative to max(1, |z|). Over many steps the
+	// differences may of course grow, and a pixel right on a basin boundary may end up in another basin.
+	constexpr double newton_kernel_tolerance = 1e-9;
+
+	// The largest deviation of a single step of kernel from the scalar reference over the given points, relative to
+	// max(1, |z|). Points where the reference step isn't finite (at the critical points of p) are skipped.
+	double newton_kernel_deviation(newton_kernel kernel, const newton_polynomial& polynomial, const newton_zeros& zeros,
+		std::span<const std::complex<double>> points);
+	double newton_kernel_deviation(product_form_kernel kernel, const newton_zeros& zeros,
+		std::span<const std::complex<double>> points);
+}
@@ -0,0 +1,368 @@
+#include "newton_kernel.hpp"
+#include "newton_kernel_double_double.hpp"
+
+#include <algorithm>
+#include <immintrin.h>
+
+// This file is compiled with AVX2 enabled (see the project file), so nothing in it may run before
+// best_supported_instruction_set has said so.
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#else
+#define AVX2_TARGET
+#endif
+
+namespace euleristic {
+
+	// All bits set in the lanes within sqrt(epsilon_squared) of a zero
+	AVX2_TARGET __m256d within_epsilon_avx2(const newton_zeros& zeros, __m256d epsilon_squared, __m256d z_real, __m256d z_imag) noexcept {
+		__m256d within = _mm256_setzero_pd();
+		for (size_t j = 0; j < zeros.count(); ++j) {
+			const __m256d difference_real = _mm256_sub_pd(z_real, _mm256_set1_pd(zeros.real[j]));
+			const __m256d difference_imag = _mm256_sub_pd(z_imag, _mm256_set1_pd(zeros.imag[j]));
+			const __m256d norm = _mm256_fmadd_pd(difference_real, difference_real, _mm256_mul_pd(difference_imag, difference_imag));
+			within = _mm256_or_pd(within, _mm256_cmp_pd(norm, epsilon_squared, _CMP_LT_OQ));
+		}
+		return within;
+	}
+
+	AVX2_TARGET void newton_iterate_avx2(const newton_polynomial& polynomial, const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept {
+		const size_t degree = polynomial.degree();
+		const double* coefficient_real = polynomial.real.data();
+		const double* coefficient_imag = polynomial.imag.data();
+		const __m256d one = _mm256_set1_pd(1.0);
+		const __m256d epsilon_squared = _mm256_set1_pd(exit.epsilon_squared);
+		const __m256d step_squared = _mm256_set1_pd(exit.step_squared);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m256d z_real = _mm256_loadu_pd(real + i);
+			__m256d z_imag = _mm256_loadu_pd(imag + i);
+			// Lanes that haven't stopped yet have all bits set. The four go on until the last of them stops, but the
+			// others are left as they are.
+			__m256d active = _mm256_cmp_pd(one, one, _CMP_EQ_OQ);
+			__m256d steps_taken = _mm256_setzero_pd();
+
+			for (unsigned iteration = 0; iteration < exit.iteration_count; ++iteration) {
+				if (exit.epsilon_squared > 0.0) {
+					active = _mm256_andnot_pd(within_epsilon_avx2(zeros, epsilon_squared, z_real, z_imag), active);
+				}
+				if (_mm256_movemask_pd(active) == 0) break;
+
+				// Same as the scalar kernel, four points at a time
+				__m256d p_real = _mm256_set1_pd(coefficient_real[0]);
+				__m256d p_imag = _mm256_set1_pd(coefficient_imag[0]);
+				__m256d p_prime_real = _mm256_setzero_pd();
+				__m256d p_prime_imag = _mm256_setzero_pd();
+
+				for (size_t n = 1; n <= degree; ++n) {
+					const __m256d next_p_prime_real = _mm256_fmadd_pd(p_prime_real, z_real, _mm256_fnmadd_pd(p_prime_imag, z_imag, p_real));
+					p_prime_imag = _mm256_fmadd_pd(p_prime_real, z_imag, _mm256_fmadd_pd(p_prime_imag, z_real, p_imag));
+					p_prime_real = next_p_prime_real;
+
+					const __m256d next_p_real = _mm256_fmadd_pd(p_real, z_real,
+						_mm256_fnmadd_pd(p_imag, z_imag, _mm256_set1_pd(coefficient_real[n])));
+					p_imag = _mm256_fmadd_pd(p_real, z_imag, _mm256_fmadd_pd(p_imag, z_real, _mm256_set1_pd(coefficient_imag[n])));
+					p_real = next_p_real;
+				}
+
+				const __m256d inverse_norm = _mm256_div_pd(one,
+					_mm256_fmadd_pd(p_prime_real, p_prime_real, _mm256_mul_pd(p_prime_imag, p_prime_imag)));
+				const __m256d step_real = _mm256_mul_pd(_mm256_fmadd_pd(p_real, p_prime_real, _mm256_mul_pd(p_imag, p_prime_imag)), inverse_norm);
+				const __m256d step_imag = _mm256_mul_pd(_mm256_fmsub_pd(p_imag, p_prime_real, _mm256_mul_pd(p_real, p_prime_imag)), inverse_norm);
+				z_real = _mm256_sub_pd(z_real, _mm256_and_pd(step_real, active));
+				z_imag = _mm256_sub_pd(z_imag, _mm256_and_pd(step_imag, active));
+				steps_taken = _mm256_add_pd(steps_taken, _mm256_and_pd(one, active));
+
+				// Not greater or equal, so that NaN stops too
+				const __m256d step_norm = _mm256_fmadd_pd(step_real, step_real, _mm256_mul_pd(step_imag, step_imag));
+				active = _mm256_andnot_pd(_mm256_cmp_pd(step_norm, step_squared, _CMP_NGE_UQ), active);
+			}
+
+			_mm256_storeu_pd(real + i, z_real);
+			_mm256_storeu_pd(imag + i, z_imag);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(iterations + i), _mm256_cvtpd_epi32(steps_taken));
+		}
+
+		// The last few points
+		newton_iterate_scalar(polynomial, zeros, exit, real + i, imag + i, iterations + i, count - i);
+	}
+
+	AVX2_TARGET void newton_iterate_product_form_avx2(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept {
+		const size_t zero_count = zeros.count();
+		const double* zero_real = zeros.real.data();
+		const double* zero_imag = zeros.imag.data();
+		const __m256d one = _mm256_set1_pd(1.0);
+		const __m256d epsilon_squared = _mm256_set1_pd(exit.epsilon_squared);
+		const __m256d step_squared = _mm256_set1_pd(exit.step_squared);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m256d z_real = _mm256_loadu_pd(real + i);
+			__m256d z_imag = _mm256_loadu_pd(imag + i);
+			__m256d active = _mm256_cmp_pd(one, one, _CMP_EQ_OQ);
+			__m256d steps_taken = _mm256_setzero_pd();
+
+			for (unsigned iteration = 0; iteration < exit.iteration_count; ++iteration) {
+				if (exit.epsilon_squared > 0.0) {
+					active = _mm256_andnot_pd(within_epsilon_avx2(zeros, epsilon_squared, z_real, z_imag), active);
+				}
+				if (_mm256_movemask_pd(active) == 0) break;
+
+				// Same as the scalar kernel, four points at a time
+				__m256d sum_real = _mm256_setzero_pd();
+				__m256d sum_imag = _mm256_setzero_pd();
+
+				for (size_t block = 0; block < zero_count; block += product_form_block_size) {
+					const size_t block_end = std::min(block + product_form_block_size, zero_count);
+
+					__m256d n_real = one;
+					__m256d n_imag = _mm256_setzero_pd();
+					__m256d d_real = _mm256_sub_pd(z_real, _mm256_set1_pd(zero_real[block]));
+					__m256d d_imag = _mm256_sub_pd(z_imag, _mm256_set1_pd(zero_imag[block]));
+
+					for (size_t j = block + 1; j < block_end; ++j) {
+						const __m256d difference_real = _mm256_sub_pd(z_real, _mm256_set1_pd(zero_real[j]));
+						const __m256d difference_imag = _mm256_sub_pd(z_imag, _mm256_set1_pd(zero_imag[j]));
+
+						const __m256d next_n_real = _mm256_fmadd_pd(n_real, difference_real, _mm256_fnmadd_pd(n_imag, difference_imag, d_real));
+						n_imag = _mm256_fmadd_pd(n_real, difference_imag, _mm256_fmadd_pd(n_imag, difference_real, d_imag));
+						n_real = next_n_real;
+
+						const __m256d next_d_real = _mm256_fmsub_pd(d_real, difference_real, _mm256_mul_pd(d_imag, difference_imag));
+						d_imag = _mm256_fmadd_pd(d_real, difference_imag, _mm256_mul_pd(d_imag, difference_real));
+						d_real = next_d_real;
+					}
+
+					const __m256d inverse_norm = _mm256_div_pd(one, _mm256_fmadd_pd(d_real, d_real, _mm256_mul_pd(d_imag, d_imag)));
+					sum_real = _mm256_fmadd_pd(_mm256_fmadd_pd(n_real, d_real, _mm256_mul_pd(n_imag, d_imag)), inverse_norm, sum_real);
+					sum_imag = _mm256_fmadd_pd(_mm256_fmsub_pd(n_imag, d_real, _mm256_mul_pd(n_real, d_imag)), inverse_norm, sum_imag);
+				}
+
+				const __m256d inverse_norm = _mm256_div_pd(one, _mm256_fmadd_pd(sum_real, sum_real, _mm256_mul_pd(sum_imag, sum_imag)));
+				// Points that have landed right on a zero get NaN for a step, which is masked to 0 here
+				const __m256d step_real = _mm256_mul_pd(sum_real, inverse_norm);
+				const __m256d step_imag = _mm256_mul_pd(sum_imag, inverse_norm);
+				const __m256d finite = _mm256_cmp_pd(_mm256_add_pd(step_real, step_imag), _mm256_add_pd(step_real, step_imag), _CMP_ORD_Q);
+				const __m256d update = _mm256_and_pd(finite, active);
+				z_real = _mm256_sub_pd(z_real, _mm256_and_pd(step_real, update));
+				z_imag = _mm256_add_pd(z_imag, _mm256_and_pd(step_imag, update));
+				steps_taken = _mm256_add_pd(steps_taken, _mm256_and_pd(one, active));
+
+				const __m256d step_norm = _mm256_fmadd_pd(step_real, step_real, _mm256_mul_pd(step_imag, step_imag));
+				active = _mm256_andnot_pd(_mm256_cmp_pd(step_norm, step_squared, _CMP_NGE_UQ), active);
+			}
+
+			_mm256_storeu_pd(real + i, z_real);
+			_mm256_storeu_pd(imag + i, z_imag);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(iterations + i), _mm256_cvtpd_epi32(steps_taken));
+		}
+
+		newton_iterate_product_form_scalar(zeros, exit, real + i, imag + i, iterations + i, count - i);
+	}
+
+	// Double-double arithmetic four points at a time, operation for operation the same as in double_double.hpp
+	struct double_double_avx2 {
+		__m256d hi, lo;
+	};
+
+	AVX2_TARGET inline double_double_avx2 two_sum_avx2(__m256d a, __m256d b) noexcept {
+		const __m256d sum = _mm256_add_pd(a, b);
+		const __m256d b_virtual = _mm256_sub_pd(sum, a);
+		return { sum, _mm256_add_pd(_mm256_sub_pd(a, _mm256_sub_pd(sum, b_virtual)), _mm256_sub_pd(b, b_virtual)) };
+	}
+
+	AVX2_TARGET inline double_double_avx2 two_difference_avx2(__m256d a, __m256d b) noexcept {
+		const __m256d difference = _mm256_sub_pd(a, b);
+		const __m256d b_virtual = _mm256_sub_pd(difference, a);
+		return { difference, _mm256_sub_pd(_mm256_sub_pd(a, _mm256_sub_pd(difference, b_virtual)), _mm256_add_pd(b, b_virtual)) };
+	}
+
+	AVX2_TARGET inline double_double_avx2 quick_two_sum_avx2(__m256d a, __m256d b) noexcept {
+		const __m256d sum = _mm256_add_pd(a, b);
+		return { sum, _mm256_sub_pd(b, _mm256_sub_pd(sum, a)) };
+	}
+
+	AVX2_TARGET inline double_double_avx2 add_avx2(double_double_avx2 a, double_double_avx2 b) noexcept {
+		const auto sum = two_sum_avx2(a.hi, b.hi);
+		return quick_two_sum_avx2(sum.hi, _mm256_add_pd(sum.lo, _mm256_add_pd(a.lo, b.lo)));
+	}
+
+	AVX2_TARGET inline double_double_avx2 add_avx2(double_double_avx2 a, __m256d b) noexcept {
+		const auto sum = two_sum_avx2(a.hi, b);
+		return quick_two_sum_avx2(sum.hi, _mm256_add_pd(sum.lo, a.lo));
+	}
+
+	AVX2_TARGET inline double_double_avx2 subtract_avx2(double_double_avx2 a, double_double_avx2 b) noexcept {
+		const auto difference = two_difference_avx2(a.hi, b.hi);
+		return quick_two_sum_avx2(difference.hi, _mm256_add_pd(difference.lo, _mm256_sub_pd(a.lo, b.lo)));
+	}
+
+	AVX2_TARGET inline double_double_avx2 subtract_avx2(double_double_avx2 a, __m256d b) noexcept {
+		const auto difference = two_difference_avx2(a.hi, b);
+		return quick_two_sum_avx2(difference.hi, _mm256_add_pd(difference.lo, a.lo));
+	}
+
+	AVX2_TARGET inline double_double_avx2 multiply_avx2(double_double_avx2 a, double_double_avx2 b) noexcept {
+		const __m256d product = _mm256_mul_pd(a.hi, b.hi);
+		const __m256d error = _mm256_fmsub_pd(a.hi, b.hi, product);
+		return quick_two_sum_avx2(product, _mm256_add_pd(error, _mm256_add_pd(_mm256_mul_pd(a.hi, b.lo), _mm256_mul_pd(a.lo, b.hi))));
+	}
+
+	AVX2_TARGET inline double_double_avx2 multiply_avx2(double_double_avx2 a, __m256d b) noexcept {
+		const __m256d product = _mm256_mul_pd(a.hi, b);
+		const __m256d error = _mm256_fmsub_pd(a.hi, b, product);
+		return quick_two_sum_avx2(product, _mm256_add_pd(error, _mm256_mul_pd(a.lo, b)));
+	}
+
+	AVX2_TARGET inline double_double_avx2 reciprocal_avx2(double_double_avx2 a) noexcept {
+		const __m256d first = _mm256_div_pd(_mm256_set1_pd(1.0), a.hi);
+		const auto remainder = subtract_avx2({ _mm256_set1_pd(1.0), _mm256_setzero_pd() }, multiply_avx2(a, first));
+		return quick_two_sum_avx2(first, _mm256_div_pd(remainder.hi, a.hi));
+	}
+
+	// Keeps a where mask is clear
+	AVX2_TARGET inline double_double_avx2 select_avx2(__m256d mask, double_double_avx2 a, double_double_avx2 b) noexcept {
+		return { _mm256_blendv_pd(a.hi, b.hi, mask), _mm256_blendv_pd(a.lo, b.lo, mask) };
+	}
+
+	AVX2_TARGET void newton_iterate_double_double_avx2(const newton_polynomial& polynomial, const newton_zeros& zeros,
+		const newton_exit& exit, double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations,
+		size_t count) noexcept {
+		const size_t degree = polynomial.degree();
+		const double* coefficient_real = polynomial.real.data();
+		const double* coefficient_imag = polynomial.imag.data();
+		const __m256d one = _mm256_set1_pd(1.0);
+		const __m256d epsilon_squared = _mm256_set1_pd(exit.epsilon_squared);
+		const __m256d step_squared = _mm256_set1_pd(exit.step_squared);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			double_double_avx2 z_real{ _mm256_loadu_pd(real + i), _mm256_loadu_pd(real_low + i) };
+			double_double_avx2 z_imag{ _mm256_loadu_pd(imag + i), _mm256_loadu_pd(imag_low + i) };
+			__m256d active = _mm256_cmp_pd(one, one, _CMP_EQ_OQ);
+			__m256d steps_taken = _mm256_setzero_pd();
+
+			for (unsigned iteration = 0; iteration < exit.iteration_count; ++iteration) {
+				if (exit.epsilon_squared > 0.0) {
+					active = _mm256_andnot_pd(within_epsilon_avx2(zeros, epsilon_squared, z_real.hi, z_imag.hi), active);
+				}
+				if (_mm256_movemask_pd(active) == 0) break;
+
+				// Same as the scalar double-double kernel, four points at a time
+				double_double_avx2 p_real{ _mm256_set1_pd(coefficient_real[0]), _mm256_setzero_pd() };
+				double_double_avx2 p_imag{ _mm256_set1_pd(coefficient_imag[0]), _mm256_setzero_pd() };
+				double_double_avx2 p_prime_real{ _mm256_setzero_pd(), _mm256_setzero_pd() };
+				double_double_avx2 p_prime_imag{ _mm256_setzero_pd(), _mm256_setzero_pd() };
+
+				for (size_t n = 1; n <= degree; ++n) {
+					const auto next_p_prime_real = add_avx2(subtract_avx2(multiply_avx2(p_prime_real, z_real), multiply_avx2(p_prime_imag, z_imag)), p_real);
+					p_prime_imag = add_avx2(add_avx2(multiply_avx2(p_prime_real, z_imag), multiply_avx2(p_prime_imag, z_real)), p_imag);
+					p_prime_real = next_p_prime_real;
+
+					const auto next_p_real = add_avx2(subtract_avx2(multiply_avx2(p_real, z_real), multiply_avx2(p_imag, z_imag)),
+						_mm256_set1_pd(coefficient_real[n]));
+					p_imag = add_avx2(add_avx2(multiply_avx2(p_real, z_imag), multiply_avx2(p_imag, z_real)), _mm256_set1_pd(coefficient_imag[n]));
+					p_real = next_p_real;
+				}
+
+				const auto inverse_norm = reciprocal_avx2(add_avx2(multiply_avx2(p_prime_real, p_prime_real), multiply_avx2(p_prime_imag, p_prime_imag)));
+				const auto step_real = multiply_avx2(add_avx2(multiply_avx2(p_real, p_prime_real), multiply_avx2(p_imag, p_prime_imag)), inverse_norm);
+				const auto step_imag = multiply_avx2(subtract_avx2(multiply_avx2(p_imag, p_prime_real), multiply_avx2(p_real, p_prime_imag)), inverse_norm);
+				z_real = select_avx2(active, z_real, subtract_avx2(z_real, step_real));
+				z_imag = select_avx2(active, z_imag, subtract_avx2(z_imag, step_imag));
+				steps_taken = _mm256_add_pd(steps_taken, _mm256_and_pd(one, active));
+
+				const __m256d step_norm = _mm256_fmadd_pd(step_real.hi, step_real.hi, _mm256_mul_pd(step_imag.hi, step_imag.hi));
+				active = _mm256_andnot_pd(_mm256_cmp_pd(step_norm, step_squared, _CMP_NGE_UQ), active);
+			}
+
+			_mm256_storeu_pd(real + i, z_real.hi);
+			_mm256_storeu_pd(real_low + i, z_real.lo);
+			_mm256_storeu_pd(imag + i, z_imag.hi);
+			_mm256_storeu_pd(imag_low + i, z_imag.lo);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(iterations + i), _mm256_cvtpd_epi32(steps_taken));
+		}
+
+		newton_iterate_double_double_scalar(polynomial, zeros, exit, real + i, real_low + i, imag + i, imag_low + i,
+			iterations + i, count - i);
+	}
+
+	AVX2_TARGET void newton_iterate_product_form_double_double_avx2(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations, size_t count) noexcept {
+		const size_t zero_count = zeros.count();
+		const double* zero_real = zeros.real.data();
+		const double* zero_imag = zeros.imag.data();
+		const __m256d one = _mm256_set1_pd(1.0);
+		const __m256d epsilon_squared = _mm256_set1_pd(exit.epsilon_squared);
+		const __m256d step_squared = _mm256_set1_pd(exit.step_squared);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			double_double_avx2 z_real{ _mm256_loadu_pd(real + i), _mm256_loadu_pd(real_low + i) };
+			double_double_avx2 z_imag{ _mm256_loadu_pd(imag + i), _mm256_loadu_pd(imag_low + i) };
+			__m256d active = _mm256_cmp_pd(one, one, _CMP_EQ_OQ);
+			__m256d steps_taken = _mm256_setzero_pd();
+
+			for (unsigned iteration = 0; iteration < exit.iteration_count; ++iteration) {
+				if (exit.epsilon_squared > 0.0) {
+					active = _mm256_andnot_pd(within_epsilon_avx2(zeros, epsilon_squared, z_real.hi, z_imag.hi), active);
+				}
+				if (_mm256_movemask_pd(active) == 0) break;
+
+				double_double_avx2 sum_real{ _mm256_setzero_pd(), _mm256_setzero_pd() };
+				double_double_avx2 sum_imag{ _mm256_setzero_pd(), _mm256_setzero_pd() };
+
+				for (size_t block = 0; block < zero_count; block += product_form_block_size) {
+					const size_t block_end = std::min(block + product_form_block_size, zero_count);
+
+					double_double_avx2 n_real{ one, _mm256_setzero_pd() };
+					double_double_avx2 n_imag{ _mm256_setzero_pd(), _mm256_setzero_pd() };
+					double_double_avx2 d_real = subtract_avx2(z_real, _mm256_set1_pd(zero_real[block]));
+					double_double_avx2 d_imag = subtract_avx2(z_imag, _mm256_set1_pd(zero_imag[block]));
+
+					for (size_t j = block + 1; j < block_end; ++j) {
+						const auto difference_real = subtract_avx2(z_real, _mm256_set1_pd(zero_real[j]));
+						const auto difference_imag = subtract_avx2(z_imag, _mm256_set1_pd(zero_imag[j]));
+
+						const auto next_n_real = add_avx2(subtract_avx2(multiply_avx2(n_real, difference_real), multiply_avx2(n_imag, difference_imag)), d_real);
+						n_imag = add_avx2(add_avx2(multiply_avx2(n_real, difference_imag), multiply_avx2(n_imag, difference_real)), d_imag);
+						n_real = next_n_real;
+
+						const auto next_d_real = subtract_avx2(multiply_avx2(d_real, difference_real), multiply_avx2(d_imag, difference_imag));
+						d_imag = add_avx2(multiply_avx2(d_real, difference_imag), multiply_avx2(d_imag, difference_real));
+						d_real = next_d_real;
+					}
+
+					const auto inverse_norm = reciprocal_avx2(add_avx2(multiply_avx2(d_real, d_real), multiply_avx2(d_imag, d_imag)));
+					sum_real = add_avx2(sum_real, multiply_avx2(add_avx2(multiply_avx2(n_real, d_real), multiply_avx2(n_imag, d_imag)), inverse_norm));
+					sum_imag = add_avx2(sum_imag, multiply_avx2(subtract_avx2(multiply_avx2(n_imag, d_real), multiply_avx2(n_real, d_imag)), inverse_norm));
+				}
+
+				// Points that have landed right on a zero get NaN for a step, and stay where they are
+				const auto inverse_norm = reciprocal_avx2(add_avx2(multiply_avx2(sum_real, sum_real), multiply_avx2(sum_imag, sum_imag)));
+				const auto step_real = multiply_avx2(sum_real, inverse_norm);
+				const auto step_imag = multiply_avx2(sum_imag, inverse_norm);
+				const __m256d finite = _mm256_cmp_pd(_mm256_add_pd(step_real.hi, step_imag.hi), _mm256_add_pd(step_real.hi, step_imag.hi), _CMP_ORD_Q);
+				const __m256d update = _mm256_and_pd(finite, active);
+				z_real = select_avx2(update, z_real, subtract_avx2(z_real, step_real));
+				z_imag = select_avx2(update, z_imag, add_avx2(z_imag, step_imag));
+				steps_taken = _mm256_add_pd(steps_taken, _mm256_and_pd(one, active));
+
+				const __m256d step_norm = _mm256_fmadd_pd(step_real.hi, step_real.hi, _mm256_mul_pd(step_imag.hi, step_imag.hi));
+				active = _mm256_andnot_pd(_mm256_cmp_pd(step_norm, step_squared, _CMP_NGE_UQ), active);
+			}
+
+			_mm256_storeu_pd(real + i, z_real.hi);
+			_mm256_storeu_pd(real_low + i, z_real.lo);
+			_mm256_storeu_pd(imag + i, z_imag.hi);
+			_mm256_storeu_pd(imag_low + i, z_imag.lo);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(iterations + i), _mm256_cvtpd_epi32(steps_taken));
+		}
+
+		newton_iterate_product_form_double_double_scalar(zeros, exit, real + i, real_low + i, imag + i, imag_low + i,
+			iterations + i, count - i);
+	}
+}
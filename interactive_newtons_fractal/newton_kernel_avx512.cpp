@@ -0,0 +1,368 @@
+#include "newton_kernel.hpp"
+#include "newton_kernel_double_double.hpp"
+
+#include <algorithm>
+#include <immintrin.h>
+
+// This file is compiled with AVX-512 enabled (see the project file), so nothing in it may run before
+// best_supported_instruction_set has said so.
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX512_TARGET __attribute__((target("avx512f")))
+#else
+#define AVX512_TARGET
+#endif
+
+namespace euleristic {
+
+	// The lanes within sqrt(epsilon_squared) of a zero
+	AVX512_TARGET __mmask8 within_epsilon_avx512(const newton_zeros& zeros, __m512d epsilon_squared, __m512d z_real, __m512d z_imag) noexcept {
+		__mmask8 within = 0;
+		for (size_t j = 0; j < zeros.count(); ++j) {
+			const __m512d difference_real = _mm512_sub_pd(z_real, _mm512_set1_pd(zeros.real[j]));
+			const __m512d difference_imag = _mm512_sub_pd(z_imag, _mm512_set1_pd(zeros.imag[j]));
+			const __m512d norm = _mm512_fmadd_pd(difference_real, difference_real, _mm512_mul_pd(difference_imag, difference_imag));
+			within |= _mm512_cmp_pd_mask(norm, epsilon_squared, _CMP_LT_OQ);
+		}
+		return within;
+	}
+
+	AVX512_TARGET void newton_iterate_avx512(const newton_polynomial& polynomial, const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept {
+		const size_t degree = polynomial.degree();
+		const double* coefficient_real = polynomial.real.data();
+		const double* coefficient_imag = polynomial.imag.data();
+		const __m512d one = _mm512_set1_pd(1.0);
+		const __m512d epsilon_squared = _mm512_set1_pd(exit.epsilon_squared);
+		const __m512d step_squared = _mm512_set1_pd(exit.step_squared);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m512d z_real = _mm512_loadu_pd(real + i);
+			__m512d z_imag = _mm512_loadu_pd(imag + i);
+			// The lanes that haven't stopped yet. The eight go on until the last of them stops, but the others are left
+			// as they are.
+			__mmask8 active = 0xff;
+			__m512d steps_taken = _mm512_setzero_pd();
+
+			for (unsigned iteration = 0; iteration < exit.iteration_count; ++iteration) {
+				if (exit.epsilon_squared > 0.0) {
+					active &= ~within_epsilon_avx512(zeros, epsilon_squared, z_real, z_imag);
+				}
+				if (active == 0) break;
+
+				// Same as the scalar kernel, eight points at a time
+				__m512d p_real = _mm512_set1_pd(coefficient_real[0]);
+				__m512d p_imag = _mm512_set1_pd(coefficient_imag[0]);
+				__m512d p_prime_real = _mm512_setzero_pd();
+				__m512d p_prime_imag = _mm512_setzero_pd();
+
+				for (size_t n = 1; n <= degree; ++n) {
+					const __m512d next_p_prime_real = _mm512_fmadd_pd(p_prime_real, z_real, _mm512_fnmadd_pd(p_prime_imag, z_imag, p_real));
+					p_prime_imag = _mm512_fmadd_pd(p_prime_real, z_imag, _mm512_fmadd_pd(p_prime_imag, z_real, p_imag));
+					p_prime_real = next_p_prime_real;
+
+					const __m512d next_p_real = _mm512_fmadd_pd(p_real, z_real,
+						_mm512_fnmadd_pd(p_imag, z_imag, _mm512_set1_pd(coefficient_real[n])));
+					p_imag = _mm512_fmadd_pd(p_real, z_imag, _mm512_fmadd_pd(p_imag, z_real, _mm512_set1_pd(coefficient_imag[n])));
+					p_real = next_p_real;
+				}
+
+				const __m512d inverse_norm = _mm512_div_pd(one,
+					_mm512_fmadd_pd(p_prime_real, p_prime_real, _mm512_mul_pd(p_prime_imag, p_prime_imag)));
+				const __m512d step_real = _mm512_mul_pd(_mm512_fmadd_pd(p_real, p_prime_real, _mm512_mul_pd(p_imag, p_prime_imag)), inverse_norm);
+				const __m512d step_imag = _mm512_mul_pd(_mm512_fmsub_pd(p_imag, p_prime_real, _mm512_mul_pd(p_real, p_prime_imag)), inverse_norm);
+				z_real = _mm512_mask_sub_pd(z_real, active, z_real, step_real);
+				z_imag = _mm512_mask_sub_pd(z_imag, active, z_imag, step_imag);
+				steps_taken = _mm512_mask_add_pd(steps_taken, active, steps_taken, one);
+
+				// Not greater or equal, so that NaN stops too
+				const __m512d step_norm = _mm512_fmadd_pd(step_real, step_real, _mm512_mul_pd(step_imag, step_imag));
+				active &= ~_mm512_cmp_pd_mask(step_norm, step_squared, _CMP_NGE_UQ);
+			}
+
+			_mm512_storeu_pd(real + i, z_real);
+			_mm512_storeu_pd(imag + i, z_imag);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(iterations + i), _mm512_cvtpd_epi32(steps_taken));
+		}
+
+		// The last few points
+		newton_iterate_scalar(polynomial, zeros, exit, real + i, imag + i, iterations + i, count - i);
+	}
+
+	AVX512_TARGET void newton_iterate_product_form_avx512(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* imag, unsigned* iterations, size_t count) noexcept {
+		const size_t zero_count = zeros.count();
+		const double* zero_real = zeros.real.data();
+		const double* zero_imag = zeros.imag.data();
+		const __m512d one = _mm512_set1_pd(1.0);
+		const __m512d epsilon_squared = _mm512_set1_pd(exit.epsilon_squared);
+		const __m512d step_squared = _mm512_set1_pd(exit.step_squared);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m512d z_real = _mm512_loadu_pd(real + i);
+			__m512d z_imag = _mm512_loadu_pd(imag + i);
+			__mmask8 active = 0xff;
+			__m512d steps_taken = _mm512_setzero_pd();
+
+			for (unsigned iteration = 0; iteration < exit.iteration_count; ++iteration) {
+				if (exit.epsilon_squared > 0.0) {
+					active &= ~within_epsilon_avx512(zeros, epsilon_squared, z_real, z_imag);
+				}
+				if (active == 0) break;
+
+				// Same as the scalar kernel, eight points at a time
+				__m512d sum_real = _mm512_setzero_pd();
+				__m512d sum_imag = _mm512_setzero_pd();
+
+				for (size_t block = 0; block < zero_count; block += product_form_block_size) {
+					const size_t block_end = std::min(block + product_form_block_size, zero_count);
+
+					__m512d n_real = one;
+					__m512d n_imag = _mm512_setzero_pd();
+					__m512d d_real = _mm512_sub_pd(z_real, _mm512_set1_pd(zero_real[block]));
+					__m512d d_imag = _mm512_sub_pd(z_imag, _mm512_set1_pd(zero_imag[block]));
+
+					for (size_t j = block + 1; j < block_end; ++j) {
+						const __m512d difference_real = _mm512_sub_pd(z_real, _mm512_set1_pd(zero_real[j]));
+						const __m512d difference_imag = _mm512_sub_pd(z_imag, _mm512_set1_pd(zero_imag[j]));
+
+						const __m512d next_n_real = _mm512_fmadd_pd(n_real, difference_real, _mm512_fnmadd_pd(n_imag, difference_imag, d_real));
+						n_imag = _mm512_fmadd_pd(n_real, difference_imag, _mm512_fmadd_pd(n_imag, difference_real, d_imag));
+						n_real = next_n_real;
+
+						const __m512d next_d_real = _mm512_fmsub_pd(d_real, difference_real, _mm512_mul_pd(d_imag, difference_imag));
+						d_imag = _mm512_fmadd_pd(d_real, difference_imag, _mm512_mul_pd(d_imag, difference_real));
+						d_real = next_d_real;
+					}
+
+					const __m512d inverse_norm = _mm512_div_pd(one, _mm512_fmadd_pd(d_real, d_real, _mm512_mul_pd(d_imag, d_imag)));
+					sum_real = _mm512_fmadd_pd(_mm512_fmadd_pd(n_real, d_real, _mm512_mul_pd(n_imag, d_imag)), inverse_norm, sum_real);
+					sum_imag = _mm512_fmadd_pd(_mm512_fmsub_pd(n_imag, d_real, _mm512_mul_pd(n_real, d_imag)), inverse_norm, sum_imag);
+				}
+
+				const __m512d inverse_norm = _mm512_div_pd(one, _mm512_fmadd_pd(sum_real, sum_real, _mm512_mul_pd(sum_imag, sum_imag)));
+				// Points that have landed right on a zero get NaN for a step, which is masked off here
+				const __m512d step_real = _mm512_mul_pd(sum_real, inverse_norm);
+				const __m512d step_imag = _mm512_mul_pd(sum_imag, inverse_norm);
+				const __mmask8 update = active
+					& _mm512_cmp_pd_mask(_mm512_add_pd(step_real, step_imag), _mm512_add_pd(step_real, step_imag), _CMP_ORD_Q);
+				z_real = _mm512_mask_sub_pd(z_real, update, z_real, step_real);
+				z_imag = _mm512_mask_add_pd(z_imag, update, z_imag, step_imag);
+				steps_taken = _mm512_mask_add_pd(steps_taken, active, steps_taken, one);
+
+				const __m512d step_norm = _mm512_fmadd_pd(step_real, step_real, _mm512_mul_pd(step_imag, step_imag));
+				active &= ~_mm512_cmp_pd_mask(step_norm, step_squared, _CMP_NGE_UQ);
+			}
+
+			_mm512_storeu_pd(real + i, z_real);
+			_mm512_storeu_pd(imag + i, z_imag);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(iterations + i), _mm512_cvtpd_epi32(steps_taken));
+		}
+
+		newton_iterate_product_form_scalar(zeros, exit, real + i, imag + i, iterations + i, count - i);
+	}
+
+	// Double-double arithmetic eight points at a time, operation for operation the same as in double_double.hpp
+	struct double_double_avx512 {
+		__m512d hi, lo;
+	};
+
+	AVX512_TARGET inline double_double_avx512 two_sum_avx512(__m512d a, __m512d b) noexcept {
+		const __m512d sum = _mm512_add_pd(a, b);
+		const __m512d b_virtual = _mm512_sub_pd(sum, a);
+		return { sum, _mm512_add_pd(_mm512_sub_pd(a, _mm512_sub_pd(sum, b_virtual)), _mm512_sub_pd(b, b_virtual)) };
+	}
+
+	AVX512_TARGET inline double_double_avx512 two_difference_avx512(__m512d a, __m512d b) noexcept {
+		const __m512d difference = _mm512_sub_pd(a, b);
+		const __m512d b_virtual = _mm512_sub_pd(difference, a);
+		return { difference, _mm512_sub_pd(_mm512_sub_pd(a, _mm512_sub_pd(difference, b_virtual)), _mm512_add_pd(b, b_virtual)) };
+	}
+
+	AVX512_TARGET inline double_double_avx512 quick_two_sum_avx512(__m512d a, __m512d b) noexcept {
+		const __m512d sum = _mm512_add_pd(a, b);
+		return { sum, _mm512_sub_pd(b, _mm512_sub_pd(sum, a)) };
+	}
+
+	AVX512_TARGET inline double_double_avx512 add_avx512(double_double_avx512 a, double_double_avx512 b) noexcept {
+		const auto sum = two_sum_avx512(a.hi, b.hi);
+		return quick_two_sum_avx512(sum.hi, _mm512_add_pd(sum.lo, _mm512_add_pd(a.lo, b.lo)));
+	}
+
+	AVX512_TARGET inline double_double_avx512 add_avx512(double_double_avx512 a, __m512d b) noexcept {
+		const auto sum = two_sum_avx512(a.hi, b);
+		return quick_two_sum_avx512(sum.hi, _mm512_add_pd(sum.lo, a.lo));
+	}
+
+	AVX512_TARGET inline double_double_avx512 subtract_avx512(double_double_avx512 a, double_double_avx512 b) noexcept {
+		const auto difference = two_difference_avx512(a.hi, b.hi);
+		return quick_two_sum_avx512(difference.hi, _mm512_add_pd(difference.lo, _mm512_sub_pd(a.lo, b.lo)));
+	}
+
+	AVX512_TARGET inline double_double_avx512 subtract_avx512(double_double_avx512 a, __m512d b) noexcept {
+		const auto difference = two_difference_avx512(a.hi, b);
+		return quick_two_sum_avx512(difference.hi, _mm512_add_pd(difference.lo, a.lo));
+	}
+
+	AVX512_TARGET inline double_double_avx512 multiply_avx512(double_double_avx512 a, double_double_avx512 b) noexcept {
+		const __m512d product = _mm512_mul_pd(a.hi, b.hi);
+		const __m512d error = _mm512_fmsub_pd(a.hi, b.hi, product);
+		return quick_two_sum_avx512(product, _mm512_add_pd(error, _mm512_add_pd(_mm512_mul_pd(a.hi, b.lo), _mm512_mul_pd(a.lo, b.hi))));
+	}
+
+	AVX512_TARGET inline double_double_avx512 multiply_avx512(double_double_avx512 a, __m512d b) noexcept {
+		const __m512d product = _mm512_mul_pd(a.hi, b);
+		const __m512d error = _mm512_fmsub_pd(a.hi, b, product);
+		return quick_two_sum_avx512(product, _mm512_add_pd(error, _mm512_mul_pd(a.lo, b)));
+	}
+
+	AVX512_TARGET inline double_double_avx512 reciprocal_avx512(double_double_avx512 a) noexcept {
+		const __m512d first = _mm512_div_pd(_mm512_set1_pd(1.0), a.hi);
+		const auto remainder = subtract_avx512({ _mm512_set1_pd(1.0), _mm512_setzero_pd() }, multiply_avx512(a, first));
+		return quick_two_sum_avx512(first, _mm512_div_pd(remainder.hi, a.hi));
+	}
+
+	// Keeps a where mask is clear
+	AVX512_TARGET inline double_double_avx512 select_avx512(__mmask8 mask, double_double_avx512 a, double_double_avx512 b) noexcept {
+		return { _mm512_mask_mov_pd(a.hi, mask, b.hi), _mm512_mask_mov_pd(a.lo, mask, b.lo) };
+	}
+
+	AVX512_TARGET void newton_iterate_double_double_avx512(const newton_polynomial& polynomial, const newton_zeros& zeros,
+		const newton_exit& exit, double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations,
+		size_t count) noexcept {
+		const size_t degree = polynomial.degree();
+		const double* coefficient_real = polynomial.real.data();
+		const double* coefficient_imag = polynomial.imag.data();
+		const __m512d one = _mm512_set1_pd(1.0);
+		const __m512d epsilon_squared = _mm512_set1_pd(exit.epsilon_squared);
+		const __m512d step_squared = _mm512_set1_pd(exit.step_squared);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			double_double_avx512 z_real{ _mm512_loadu_pd(real + i), _mm512_loadu_pd(real_low + i) };
+			double_double_avx512 z_imag{ _mm512_loadu_pd(imag + i), _mm512_loadu_pd(imag_low + i) };
+			__mmask8 active = 0xff;
+			__m512d steps_taken = _mm512_setzero_pd();
+
+			for (unsigned iteration = 0; iteration < exit.iteration_count; ++iteration) {
+				if (exit.epsilon_squared > 0.0) {
+					active &= ~within_epsilon_avx512(zeros, epsilon_squared, z_real.hi, z_imag.hi);
+				}
+				if (active == 0) break;
+
+				// Same as the scalar double-double kernel, eight points at a time
+				double_double_avx512 p_real{ _mm512_set1_pd(coefficient_real[0]), _mm512_setzero_pd() };
+				double_double_avx512 p_imag{ _mm512_set1_pd(coefficient_imag[0]), _mm512_setzero_pd() };
+				double_double_avx512 p_prime_real{ _mm512_setzero_pd(), _mm512_setzero_pd() };
+				double_double_avx512 p_prime_imag{ _mm512_setzero_pd(), _mm512_setzero_pd() };
+
+				for (size_t n = 1; n <= degree; ++n) {
+					const auto next_p_prime_real = add_avx512(subtract_avx512(multiply_avx512(p_prime_real, z_real), multiply_avx512(p_prime_imag, z_imag)), p_real);
+					p_prime_imag = add_avx512(add_avx512(multiply_avx512(p_prime_real, z_imag), multiply_avx512(p_prime_imag, z_real)), p_imag);
+					p_prime_real = next_p_prime_real;
+
+					const auto next_p_real = add_avx512(subtract_avx512(multiply_avx512(p_real, z_real), multiply_avx512(p_imag, z_imag)),
+						_mm512_set1_pd(coefficient_real[n]));
+					p_imag = add_avx512(add_avx512(multiply_avx512(p_real, z_imag), multiply_avx512(p_imag, z_real)), _mm512_set1_pd(coefficient_imag[n]));
+					p_real = next_p_real;
+				}
+
+				const auto inverse_norm = reciprocal_avx512(add_avx512(multiply_avx512(p_prime_real, p_prime_real), multiply_avx512(p_prime_imag, p_prime_imag)));
+				const auto step_real = multiply_avx512(add_avx512(multiply_avx512(p_real, p_prime_real), multiply_avx512(p_imag, p_prime_imag)), inverse_norm);
+				const auto step_imag = multiply_avx512(subtract_avx512(multiply_avx512(p_imag, p_prime_real), multiply_avx512(p_real, p_prime_imag)), inverse_norm);
+				z_real = select_avx512(active, z_real, subtract_avx512(z_real, step_real));
+				z_imag = select_avx512(active, z_imag, subtract_avx512(z_imag, step_imag));
+				steps_taken = _mm512_mask_add_pd(steps_taken, active, steps_taken, one);
+
+				const __m512d step_norm = _mm512_fmadd_pd(step_real.hi, step_real.hi, _mm512_mul_pd(step_imag.hi, step_imag.hi));
+				active &= ~_mm512_cmp_pd_mask(step_norm, step_squared, _CMP_NGE_UQ);
+			}
+
+			_mm512_storeu_pd(real + i, z_real.hi);
+			_mm512_storeu_pd(real_low + i, z_real.lo);
+			_mm512_storeu_pd(imag + i, z_imag.hi);
+			_mm512_storeu_pd(imag_low + i, z_imag.lo);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(iterations + i), _mm512_cvtpd_epi32(steps_taken));
+		}
+
+		newton_iterate_double_double_scalar(polynomial, zeros, exit, real + i, real_low + i, imag + i, imag_low + i,
+			iterations + i, count - i);
+	}
+
+	AVX512_TARGET void newton_iterate_product_form_double_double_avx512(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations, size_t count) noexcept {
+		const size_t zero_count = zeros.count();
+		const double* zero_real = zeros.real.data();
+		const double* zero_imag = zeros.imag.data();
+		const __m512d one = _mm512_set1_pd(1.0);
+		const __m512d epsilon_squared = _mm512_set1_pd(exit.epsilon_squared);
+		const __m512d step_squared = _mm512_set1_pd(exit.step_squared);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			double_double_avx512 z_real{ _mm512_loadu_pd(real + i), _mm512_loadu_pd(real_low + i) };
+			double_double_avx512 z_imag{ _mm512_loadu_pd(imag + i), _mm512_loadu_pd(imag_low + i) };
+			__mmask8 active = 0xff;
+			__m512d steps_taken = _mm512_setzero_pd();
+
+			for (unsigned iteration = 0; iteration < exit.iteration_count; ++iteration) {
+				if (exit.epsilon_squared > 0.0) {
+					active &= ~within_epsilon_avx512(zeros, epsilon_squared, z_real.hi, z_imag.hi);
+				}
+				if (active == 0) break;
+
+				double_double_avx512 sum_real{ _mm512_setzero_pd(), _mm512_setzero_pd() };
+				double_double_avx512 sum_imag{ _mm512_setzero_pd(), _mm512_setzero_pd() };
+
+				for (size_t block = 0; block < zero_count; block += product_form_block_size) {
+					const size_t block_end = std::min(block + product_form_block_size, zero_count);
+
+					double_double_avx512 n_real{ one, _mm512_setzero_pd() };
+					double_double_avx512 n_imag{ _mm512_setzero_pd(), _mm512_setzero_pd() };
+					double_double_avx512 d_real = subtract_avx512(z_real, _mm512_set1_pd(zero_real[block]));
+					double_double_avx512 d_imag = subtract_avx512(z_imag, _mm512_set1_pd(zero_imag[block]));
+
+					for (size_t j = block + 1; j < block_end; ++j) {
+						const auto difference_real = subtract_avx512(z_real, _mm512_set1_pd(zero_real[j]));
+						const auto difference_imag = subtract_avx512(z_imag, _mm512_set1_pd(zero_imag[j]));
+
+						const auto next_n_real = add_avx512(subtract_avx512(multiply_avx512(n_real, difference_real), multiply_avx512(n_imag, difference_imag)), d_real);
+						n_imag = add_avx512(add_avx512(multiply_avx512(n_real, difference_imag), multiply_avx512(n_imag, difference_real)), d_imag);
+						n_real = next_n_real;
+
+						const auto next_d_real = subtract_avx512(multiply_avx512(d_real, difference_real), multiply_avx512(d_imag, difference_imag));
+						d_imag = add_avx512(multiply_avx512(d_real, difference_imag), multiply_avx512(d_imag, difference_real));
+						d_real = next_d_real;
+					}
+
+					const auto inverse_norm = reciprocal_avx512(add_avx512(multiply_avx512(d_real, d_real), multiply_avx512(d_imag, d_imag)));
+					sum_real = add_avx512(sum_real, multiply_avx512(add_avx512(multiply_avx512(n_real, d_real), multiply_avx512(n_imag, d_imag)), inverse_norm));
+					sum_imag = add_avx512(sum_imag, multiply_avx512(subtract_avx512(multiply_avx512(n_imag, d_real), multiply_avx512(n_real, d_imag)), inverse_norm));
+				}
+
+				// Points that have landed right on a zero get NaN for a step, and stay where they are
+				const auto inverse_norm = reciprocal_avx512(add_avx512(multiply_avx512(sum_real, sum_real), multiply_avx512(sum_imag, sum_imag)));
+				const auto step_real = multiply_avx512(sum_real, inverse_norm);
+				const auto step_imag = multiply_avx512(sum_imag, inverse_norm);
+				const __mmask8 update = active
+					& _mm512_cmp_pd_mask(_mm512_add_pd(step_real.hi, step_imag.hi), _mm512_add_pd(step_real.hi, step_imag.hi), _CMP_ORD_Q);
+				z_real = select_avx512(update, z_real, subtract_avx512(z_real, step_real));
+				z_imag = select_avx512(update, z_imag, add_avx512(z_imag, step_imag));
+				steps_taken = _mm512_mask_add_pd(steps_taken, active, steps_taken, one);
+
+				const __m512d step_norm = _mm512_fmadd_pd(step_real.hi, step_real.hi, _mm512_mul_pd(step_imag.hi, step_imag.hi));
+				active &= ~_mm512_cmp_pd_mask(step_norm, step_squared, _CMP_NGE_UQ);
+			}
+
+			_mm512_storeu_pd(real + i, z_real.hi);
+			_mm512_storeu_pd(real_low + i, z_real.lo);
+			_mm512_storeu_pd(imag + i, z_imag.hi);
+			_mm512_storeu_pd(imag_low + i, z_imag.lo);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(iterations + i), _mm512_cvtpd_epi32(steps_taken));
+		}
+
+		newton_iterate_product_form_double_double_scalar(zeros, exit, real + i, real_low + i, imag + i, imag_low + i,
+			iterations + i, count - i);
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "newton_kernel.hpp"
+#include "double_double.hpp"
+
+namespace euleristic {
+
+	// Which arithmetic the points are iterated in.
+	enum class precision_mode {
+		automatic, // double_double once the pixels get too small for double to tell apart, otherwise standard
+		standard, // double
+		double_double // about 106 bits of mantissa, at three to four times the cost with AVX2 or AVX-512 and six or seven without
+	};
+
+	const char* to_string(precision_mode precision) noexcept;
+
+	// The double-double kernels work on points stored as hi + lo pairs, with the real and imaginary high and low parts
+	// in four arrays. Only the points are double-double, while the coefficients and zeros stay double: they define the
+	// polynomial whose fractal is drawn, and nothing gets blocky from them being rounded. That keeps the Horner and
+	// product form steps at double-double times double for the constants, which is much cheaper than double-double
+	// times double-double.
+	//
+	// The exit condition is checked on the high parts only; double is plenty for whether a point is near a zero.
+	using newton_kernel_double_double = void (*)(const newton_polynomial& polynomial, const newton_zeros& zeros,
+		const newton_exit& exit, double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations,
+		size_t count) noexcept;
+
+	using product_form_kernel_double_double = void (*)(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations, size_t count) noexcept;
+
+	// Throws if isa isn't supported by the CPU.
+	newton_kernel_double_double select_newton_kernel_double_double(instruction_set isa);
+	product_form_kernel_double_double select_product_form_kernel_double_double(instruction_set isa);
+
+	void newton_iterate_double_double_scalar(const newton_polynomial& polynomial, const newton_zeros& zeros,
+		const newton_exit& exit, double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations,
+		size_t count) noexcept;
+	void newton_iterate_double_double_avx2(const newton_polynomial& polynomial, const newton_zeros& zeros,
+		const newton_exit& exit, double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations,
+		size_t count) noexcept;
+	void newton_iterate_double_double_avx512(const newton_polynomial& polynomial, const newton_zeros& zeros,
+		const newton_exit& exit, double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations,
+		size_t count) noexcept;
+
+	void newton_iterate_product_form_double_double_scalar(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations, size_t count) noexcept;
+	void newton_iterate_product_form_double_double_avx2(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations, size_t count) noexcept;
+	void newton_iterate_product_form_double_double_avx512(const newton_zeros& zeros, const newton_exit& exit,
+		double* real, double* real_low, double* imag, double* imag_low, unsigned* iterations, size_t count) noexcept;
+}
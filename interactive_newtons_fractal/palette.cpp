@@ -0,0 +1,50 @@
+#include "palette.hpp"
+
+#include <cmath>
+#include <numbers>
+#include <cstdint>
+
+namespace euleristic {
+
+	glm::vec4 hsv_to_rgba(float hue, float saturation, float value) {
+		// Credit to Wikipedia: https://en.wikipedia.org/wiki/HSL_and_HSV#HSV_to_RGB
+
+		float chroma = value * saturation;
+		float x = chroma * (1.0f - std::fabs(std::fmod(hue * 6.0f, 2.0f) - 1.0f));
+
+		glm::vec3 rgb1;
+		if (hue <= 1.0 / 6.0)
+			rgb1 = glm::vec3(chroma, x, 0.0f);
+		else if (hue <= 2.0 / 6.0)
+			rgb1 = glm::vec3(x, chroma, 0.0f);
+		else if (hue <= 3.0 / 6.0)
+			rgb1 = glm::vec3(0.0f, chroma, x);
+		else if (hue <= 4.0 / 6.0)
+			rgb1 = glm::vec3(0.0f, x, chroma);
+		else if (hue <= 5.0 / 6.0)
+			rgb1 = glm::vec3(x, 0.0f, chroma);
+		else
+			rgb1 = glm::vec3(chroma, 0.0f, x);
+
+		float m = value - chroma;
+
+		return glm::vec4(rgb1.r + m, rgb1.g + m, rgb1.b + m, 1.0f);
+	}
+
+	glm::vec4 generate_color(const size_t index) {
+		constexpr float saturation = 1.0f;
+		constexpr float value = 0.5f;
+		// I'm sure I'm not the first to think of this, but the palette is basically selected by walking phi 
+		// circumferences around the color wheel from the previous one. Since phi is the "most irrational number",
+		// this method generates the an optimally uniform distribution of colors as the size of the palette approaches infinity.
+		return hsv_to_rgba(std::fmod((float)index * std::numbers::phi_v<float>, 1.0f), saturation, value);
+	}
+
+	glm::u8vec4 to_rgba8(const glm::vec4 color) noexcept {
+		return glm::u8vec4(
+			static_cast<std::uint8_t>(std::lround(255.0f * color.r)),
+			static_cast<std::uint8_t>(std::lround(255.0f * color.g)),
+			static_cast<std::uint8_t>(std::lround(255.0f * color.b)),
+			static_cast<std::uint8_t>(std::lround(255.0f * color.a)));
+	}
+}
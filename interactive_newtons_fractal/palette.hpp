@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#define GLM_FORCE_SWIZZLE
+#include <glm/glm.hpp>
+
+namespace euleristic {
+
+	// Where h, s, v are in [0, 1]
+	glm::vec4 hsv_to_rgba(float hue, float saturation, float value);
+
+	// The color of the basin (and the disk) of the zero at index.
+	glm::vec4 generate_color(const size_t index);
+
+	// Rounded to 8 bits a channel, like the framebuffer does
+	glm::u8vec4 to_rgba8(const glm::vec4 color) noexcept;
+}
@@ -0,0 +1,97 @@
+#include "polynomial.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+
+namespace euleristic {
+
+	std::vector<std::complex<double>> zeros_to_coefficients(std::span<const std::complex<double>> zeros) {
+		std::vector<std::complex<double>> coefs{ { 1.0, 0.0 } };
+		coefs.reserve(zeros.size() + 1);
+		for (auto zero : zeros) {
+			multiply_in_zero(coefs, zero);
+		}
+		return coefs;
+	}
+
+	// This could be any arithmetic type, but for clarity only complex is used there
+	std::vector<std::complex<double>> zeros_to_coefficients_by_subsets(std::span<const std::complex<double>> zeros) {
+
+		if (zeros.size() > 63) {
+			throw std::invalid_argument("Size of zeros was greater than 63.");
+		}
+
+		std::vector coefs(zeros.size() + 1, std::complex<double>{});
+
+		for (std::uint64_t bits = 0; bits < (std::uint64_t{ 1 } << zeros.size()); ++bits) {
+			std::complex<double> product(1.0f, 0.0f);
+			for (size_t i = 0; i < zeros.size(); ++i) {
+				if ((bits >> i) & std::uint64_t{ 1 }) {
+					product *= -zeros[i];
+				}
+			}
+			coefs[zeros.size() - std::popcount(bits)] += product;
+		}
+		return coefs;
+	}
+
+	void multiply_in_zero(std::vector<std::complex<double>>& coefficients, std::complex<double> zero) {
+		// (z - zero) * sum(a_k z^k) = sum((a_(k-1) - zero * a_k) z^k)
+		coefficients.push_back(coefficients.back());
+		for (size_t k = coefficients.size() - 2; k > 0; --k) {
+			coefficients[k] = coefficients[k - 1] - zero * coefficients[k];
+		}
+		coefficients[0] *= -zero;
+	}
+
+	void divide_out_zero(std::vector<std::complex<double>>& coefficients, std::complex<double> zero) {
+		if (coefficients.size() < 2) {
+			throw std::invalid_argument("Can't divide a zero out of a constant.");
+		}
+		const size_t degree = coefficients.size() - 1;
+		std::vector<std::complex<double>> quotient(degree);
+
+		if (std::norm(zero) <= 1.0) {
+			// Synthetic division: q_(k-1) = a_k + zero * q_k
+			quotient[degree - 1] = coefficients[degree];
+			for (size_t k = degree - 1; k > 0; --k) {
+				quotient[k - 1] = coefficients[k] + zero * quotient[k];
+			}
+		}
+		else {
+			// The same recurrence, solved for q_k from the constant term up: q_k = (q_(k-1) - a_k) / zero
+			const auto inverse_zero = 1.0 / zero;
+			quotient[0] = -coefficients[0] * inverse_zero;
+			for (size_t k = 1; k < degree; ++k) {
+				quotient[k] = (quotient[k - 1] - coefficients[k]) * inverse_zero;
+			}
+		}
+		coefficients = std::move(quotient);
+	}
+
+	void move_zero(std::vector<std::complex<double>>& coefficients, std::complex<double> old_zero, std::complex<double> new_zero) {
+		// With p = q * (z - old_zero), the new polynomial is q * (z - new_zero) = p + (old_zero - new_zero) * q
+		auto quotient = coefficients;
+		divide_out_zero(quotient, old_zero);
+		const auto difference = old_zero - new_zero;
+		for (size_t k = 0; k < quotient.size(); ++k) {
+			coefficients[k] += difference * quotient[k];
+		}
+	}
+
+	std::vector<std::complex<double>> make_monic(std::span<const std::complex<double>> coefficients) {
+		size_t size = coefficients.size();
+		while (size > 0 && coefficients[size - 1] == std::complex<double>{}) --size;
+		if (size == 0) {
+			throw std::invalid_argument("Every coefficient is zero.");
+		}
+		std::vector<std::complex<double>> monic(coefficients.begin(), coefficients.begin() + size);
+		const auto leading = monic.back();
+		for (auto& coefficient : monic) {
+			coefficient /= leading;
+		}
+		monic.back() = 1.0;
+		return monic;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <span>
+
+namespace euleristic {
+
+	// All coefficients are stored lowest power first, and all polynomials are monic.
+
+	// Expands (z - zeros[0]) * (z - zeros[1]) * ... into its coefficients by multiplying in one factor at a time, in O(n^2).
+	// Each coefficient is the elementary symmetric polynomial e_k(-zeros), summed with n multiply-adds, so its error is
+	// bounded by roughly 2n * machine epsilon * e_k(|zeros|). The subset routine below sums the very same products
+	// one by one, so its bound has the same shape, but with the 2^n terms it is never better and it is far slower. The
+	// polynomial/ benchmarks measure both against z^n + 1 and against each other, in units of e_k(|zeros|).
+	std::vector<std::complex<double>> zeros_to_coefficients(std::span<const std::complex<double>> zeros);
+
+	// The original expansion, which sums the products of every subset of the zeros in O(n * 2^n). Kept as a reference
+	// for zeros_to_coefficients, and limited to 63 zeros.
+	std::vector<std::complex<double>> zeros_to_coefficients_by_subsets(std::span<const std::complex<double>> zeros);
+
+	// Multiplies the polynomial by (z - zero) in place, in O(n).
+	void multiply_in_zero(std::vector<std::complex<double>>& coefficients, std::complex<double> zero);
+
+	// Divides the polynomial by (z - zero) in place, in O(n). The remainder is dropped, so zero should be one of its zeros.
+	// Zeros inside the unit disk are divided out from the highest power down and those outside it from the lowest power up,
+	// which is the numerically stable direction in either case.
+	void divide_out_zero(std::vector<std::complex<double>>& coefficients, std::complex<double> zero);
+
+	// Drops any zero leading coefficients and divides the rest by the leading one, for polynomials that come from
+	// elsewhere. Throws std::invalid_argument if every coefficient is zero.
+	std::vector<std::complex<double>> make_monic(std::span<const std::complex<double>> coefficients);
+
+	// Replaces the zero old_zero of the polynomial with new_zero in place, in O(n). This is what dragging a zero does.
+	// Each call adds a little rounding error, so after many calls the coefficients should be expanded from the zeros anew.
+	// Most of it comes from dividing out the old zero rather than from the calls adding up: with 80 zeros on the unit
+	// circle a single call can be off by 1e-5 of e_k(|zeros|), and ten thousand calls aren't much worse.
+	void move_zero(std::vector<std::complex<double>>& coefficients, std::complex<double> old_zero, std::complex<double> new_zero);
+}
@@ -0,0 +1,210 @@
+#include "program_cache.hpp"
+#include "fractal_window.hpp"
+
+#include "glad/glad.h"
+
+#include <array>
+#include <vector>
+#include <format>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <iostream>
+#include <system_error>
+
+using namespace std::string_literals;
+
+namespace euleristic {
+
+	// Bumped whenever the file layout or what goes into the key changes
+	constexpr std::uint32_t program_cache_version = 1;
+	constexpr std::array<char, 4> program_cache_magic = { 'N', 'F', 'P', 'B' };
+	// Far more than any driver's binary of these shaders, so a corrupt length doesn't allocate gigabytes
+	constexpr std::uint32_t max_program_binary_length = 64 << 20;
+
+	struct program_binary_header {
+		std::array<char, 4> magic = program_cache_magic;
+		std::uint32_t version = program_cache_version;
+		std::uint64_t key{};
+		std::uint32_t format{};
+		std::uint32_t length{};
+	};
+
+	std::optional<std::string> environment_variable(const char* name) {
+#ifdef _MSC_VER
+		char* value = nullptr;
+		size_t length = 0;
+		if (_dupenv_s(&value, &length, name) != 0 || !value) return {};
+		std::string result(value);
+		std::free(value);
+#else
+		const char* value = std::getenv(name);
+		if (!value) return {};
+		std::string result(value);
+#endif
+		if (result.empty()) return {};
+		return result;
+	}
+
+	void compile_shader(const unsigned int shader_id, std::string_view source, const char* shader_name) {
+		const char* text = source.data();
+		const auto length = static_cast<GLint>(source.size());
+		glShaderSource(shader_id, 1, &text, &length);
+		glCompileShader(shader_id);
+
+		int success;
+		glGetShaderiv(shader_id, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			char info_log[512];
+			glGetShaderInfoLog(shader_id, 512, nullptr, info_log);
+			throw graphics_error{ "COMPILATION_ERROR in : "s + shader_name, info_log };
+		}
+	}
+
+	std::filesystem::path program_cache::default_directory() {
+		if (auto path = environment_variable("NEWTONS_FRACTAL_SHADER_CACHE")) return *path;
+#ifdef _WIN32
+		if (auto path = environment_variable("LOCALAPPDATA")) return std::filesystem::path(*path) / "newtons_fractal" / "shader_cache";
+#else
+		if (auto path = environment_variable("XDG_CACHE_HOME")) return std::filesystem::path(*path) / "newtons_fractal" / "shader_cache";
+		if (auto path = environment_variable("HOME")) return std::filesystem::path(*path) / ".cache" / "newtons_fractal" / "shader_cache";
+#endif
+		std::error_code error;
+		const auto temporary = std::filesystem::temp_directory_path(error);
+		return error ? std::filesystem::path{} : temporary / "newtons_fractal_shader_cache";
+	}
+
+	program_cache::program_cache(std::filesystem::path directory) : directory(std::move(directory)) {
+		// Some drivers support the calls but have no formats to save in
+		GLint format_count = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+		if (format_count <= 0) this->directory.clear();
+
+		for (const auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION }) {
+			const auto* value = reinterpret_cast<const char*>(glGetString(name));
+			driver += value ? value : "";
+			driver += '\n';
+		}
+	}
+
+	std::uint64_t program_cache::key(std::span<const shader_stage> stages) const noexcept {
+		std::uint64_t hash = 0xcbf29ce484222325;
+		const auto add = [&](std::string_view bytes) {
+			for (const auto byte : bytes) {
+				hash = (hash ^ static_cast<unsigned char>(byte)) * 0x100000001b3;
+			}
+		};
+		add(std::to_string(program_cache_version));
+		add(driver);
+		for (const auto& stage : stages) {
+			// The lengths keep one stage's end from passing for the next one's start
+			add(std::format("{} {}\n", stage.type, stage.source.size()));
+			add(stage.source);
+		}
+		return hash;
+	}
+
+	bool program_cache::load(unsigned int program, std::uint64_t key) {
+		std::ifstream input(directory / std::format("{:016x}.bin", key), std::ios::binary);
+		if (!input.is_open()) return false;
+
+		program_binary_header header;
+		input.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!input || header.magic != program_cache_magic || header.version != program_cache_version || header.key != key
+			|| header.length == 0 || header.length > max_program_binary_length) {
+			return false;
+		}
+		std::vector<char> binary(header.length);
+		input.read(binary.data(), binary.size());
+		if (!input) return false;
+
+		glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+		GLint linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (!linked) {
+			// Usually a driver update that kept the same version string
+			++totals.rejected;
+			return false;
+		}
+		return true;
+	}
+
+	// Written to a temporary file and renamed over the old binary, so that another instance never loads half of one
+	void program_cache::save(unsigned int program, std::uint64_t key) const {
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0 || static_cast<std::uint32_t>(length) > max_program_binary_length) return;
+		std::vector<char> binary(static_cast<size_t>(length));
+		program_binary_header header;
+		header.key = key;
+		GLenum format = 0;
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+		header.format = format;
+		header.length = static_cast<std::uint32_t>(length);
+
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+		const auto path = directory / std::format("{:016x}.bin", key);
+		auto temporary = path;
+		temporary += ".tmp";
+		{
+			std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+			output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			output.write(binary.data(), header.length);
+			output.flush();
+			if (!output) {
+				std::cerr << "Could not save a shader binary to " << temporary.string() << ". It will be compiled again next time.\n";
+				return;
+			}
+		}
+		std::filesystem::rename(temporary, path, error);
+		if (error) std::filesystem::remove(temporary, error);
+	}
+
+	bool program_cache::build(unsigned int program, std::span<const shader_stage> stages) {
+		using clock = std::chrono::steady_clock;
+		const auto start = clock::now();
+		const auto program_key = key(stages);
+		if (enabled() && load(program, program_key)) {
+			++totals.hits;
+			totals.loading += clock::now() - start;
+			return true;
+		}
+
+		std::vector<unsigned int> shaders;
+		const auto release_shaders = [&] {
+			for (const auto shader : shaders) {
+				glDetachShader(program, shader);
+				glDeleteShader(shader);
+			}
+		};
+		try {
+			for (const auto& stage : stages) {
+				shaders.push_back(glCreateShader(stage.type));
+				glAttachShader(program, shaders.back());
+				compile_shader(shaders.back(), stage.source, stage.name);
+			}
+		} catch (...) {
+			release_shaders();
+			throw;
+		}
+		if (enabled()) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(program);
+		// The program keeps what it linked, so the shaders have done their job either way
+		release_shaders();
+
+		int success;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success) {
+			char info_log[512];
+			glGetProgramInfoLog(program, 512, nullptr, info_log);
+			throw graphics_error{ "SHADER_LINKING_ERROR", info_log };
+		}
+		++totals.misses;
+		totals.compiling += clock::now() - start;
+
+		if (enabled()) save(program, program_key);
+		return false;
+	}
+}
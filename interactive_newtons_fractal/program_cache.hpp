@@ -0,0 +1,55 @@
+#pragma once
+
+#include <span>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace euleristic {
+
+	struct shader_stage {
+		unsigned int type; // GL_VERTEX_SHADER or GL_FRAGMENT_SHADER
+		std::string_view source; // With any template parameters filled in
+		const char* name;
+	};
+
+	// Linked programs, saved with glGetProgramBinary, so that the next launch on the same driver doesn't run the GLSL
+	// compiler at all. A binary is keyed by the driver (vendor, renderer and version strings) and a hash of every stage's
+	// completed source, so template parameters are part of the key, and editing a shader or updating the driver just
+	// misses. A binary the driver refuses anyway, which it is allowed to, is compiled over.
+	class program_cache {
+	public:
+		struct statistics {
+			size_t hits{}, misses{}, rejected{};
+			std::chrono::duration<double, std::milli> loading{}, compiling{};
+		};
+
+		// An empty directory turns the cache off, which is also what happens if the driver has no binary formats
+		explicit program_cache(std::filesystem::path directory = default_directory());
+
+		// NEWTONS_FRACTAL_SHADER_CACHE if it's set, or newtons_fractal/shader_cache under LOCALAPPDATA on Windows and
+		// XDG_CACHE_HOME or ~/.cache elsewhere
+		static std::filesystem::path default_directory();
+
+		// Makes program out of the stages, from the cache if it can, or by compiling and linking them and saving the
+		// binary for next time. Returns whether it came from the cache. Throws graphics_error if the sources don't compile
+		// or link; failing to read or write the cache only costs the compile.
+		bool build(unsigned int program, std::span<const shader_stage> stages);
+
+		const statistics& stats() const noexcept { return totals; }
+		const std::filesystem::path& path() const noexcept { return directory; }
+		bool enabled() const noexcept { return !directory.empty(); }
+
+	private:
+		std::filesystem::path directory;
+		// The driver's strings, read once, since they're part of every key
+		std::string driver;
+		statistics totals;
+
+		std::uint64_t key(std::span<const shader_stage> stages) const noexcept;
+		bool load(unsigned int program, std::uint64_t key);
+		void save(unsigned int program, std::uint64_t key) const;
+	};
+}
@@ -0,0 +1,212 @@
+#include "root_finder.hpp"
+#include "polynomial.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+namespace euleristic {
+
+	bool root_finder_diagnostics::converged() const noexcept {
+		return converged_roots == degree;
+	}
+
+	// Starting points on the circles of the Newton polygon: the upper convex hull of the points (k, log |a_k|). Between
+	// two of its corners i < j there are j - i roots of magnitude around (|a_i| / |a_j|)^(1 / (j - i)), and each circle
+	// is turned a little against the others, so that no two starting points coincide or share an axis of symmetry.
+	std::vector<std::complex<double>> initial_roots(std::span<const std::complex<double>> coefficients) {
+		const size_t degree = coefficients.size() - 1;
+		std::vector<std::pair<double, double>> hull;
+		for (size_t k = 0; k <= degree; ++k) {
+			if (coefficients[k] == std::complex<double>{}) continue;
+			const std::pair point{ static_cast<double>(k), std::log(std::abs(coefficients[k])) };
+			// Pop corners that would make the hull dip, which is where the cross product turns counterclockwise
+			while (hull.size() >= 2) {
+				const auto& [x0, y0] = hull[hull.size() - 2];
+				const auto& [x1, y1] = hull.back();
+				if ((x1 - x0) * (point.second - y0) - (y1 - y0) * (point.first - x0) < 0.0) break;
+				hull.pop_back();
+			}
+			hull.push_back(point);
+		}
+
+		constexpr double twist = 0.7;
+		std::vector<std::complex<double>> roots;
+		roots.reserve(degree);
+		for (size_t corner = 0; corner + 1 < hull.size(); ++corner) {
+			const auto [x0, y0] = hull[corner];
+			const auto [x1, y1] = hull[corner + 1];
+			const double count = x1 - x0;
+			const double radius = std::exp((y0 - y1) / count);
+			for (double j = 0.0; j < count; ++j) {
+				const double angle = 2.0 * std::numbers::pi * (j / count + x0 / static_cast<double>(degree)) + twist;
+				roots.push_back(std::polar(radius, angle));
+			}
+		}
+		return roots;
+	}
+
+	struct root_evaluation {
+		// p'(z) / p(z), the reciprocal of the Newton step
+		std::complex<double> derivative_ratio;
+		double backward_error;
+		bool exact;
+	};
+
+	// Horner's rule straight on p inside the unit disk, and on the reversed polynomial w^n p(1 / w) outside it, so that
+	// neither ever raises z to a power that overflows
+	root_evaluation evaluate_root(std::span<const std::complex<double>> coefficients, std::span<const double> magnitudes,
+		std::complex<double> z) noexcept {
+		const size_t degree = coefficients.size() - 1;
+		const double magnitude = std::abs(z);
+		if (magnitude <= 1.0) {
+			std::complex<double> value = coefficients[degree], derivative{};
+			double bound = magnitudes[degree];
+			for (size_t k = degree; k-- > 0;) {
+				derivative = derivative * z + value;
+				value = value * z + coefficients[k];
+				bound = bound * magnitude + magnitudes[k];
+			}
+			if (value == std::complex<double>{}) return { {}, 0.0, true };
+			return { derivative / value, std::abs(value) / bound, false };
+		}
+
+		// With w = 1 / z and q(w) = w^n p(z), p'(z) / p(z) = (n - w q'(w) / q(w)) / z
+		const auto w = 1.0 / z;
+		const double w_magnitude = 1.0 / magnitude;
+		std::complex<double> value = coefficients[0], derivative{};
+		double bound = magnitudes[0];
+		for (size_t k = 1; k <= degree; ++k) {
+			derivative = derivative * w + value;
+			value = value * w + coefficients[k];
+			bound = bound * w_magnitude + magnitudes[k];
+		}
+		if (value == std::complex<double>{}) return { {}, 0.0, true };
+		return { (static_cast<double>(degree) - w * derivative / value) / z, std::abs(value) / bound, false };
+	}
+
+	// The sum of 1 / (z_i - z_j) over every j but i. It's kept in eight independent partial sums, so that the compiler
+	// may hold them in vector registers without reordering any of the additions, and the result doesn't depend on the ISA.
+	std::complex<double> reciprocal_distance_sum(const std::vector<double>& real, const std::vector<double>& imag, size_t i) noexcept {
+		constexpr size_t lanes = 8;
+		std::array<double, lanes> sum_real{}, sum_imag{};
+		const double x = real[i], y = imag[i];
+		const auto accumulate = [&](size_t begin, size_t end) {
+			size_t j = begin;
+			for (; j + lanes <= end; j += lanes) {
+				for (size_t lane = 0; lane < lanes; ++lane) {
+					const double dx = x - real[j + lane], dy = y - imag[j + lane];
+					const double reciprocal_norm = 1.0 / (dx * dx + dy * dy);
+					sum_real[lane] += dx * reciprocal_norm;
+					sum_imag[lane] -= dy * reciprocal_norm;
+				}
+			}
+			for (; j < end; ++j) {
+				const double dx = x - real[j], dy = y - imag[j];
+				const double reciprocal_norm = 1.0 / (dx * dx + dy * dy);
+				sum_real[0] += dx * reciprocal_norm;
+				sum_imag[0] -= dy * reciprocal_norm;
+			}
+		};
+		accumulate(0, i);
+		accumulate(i + 1, real.size());
+
+		std::complex<double> sum{};
+		for (size_t lane = 0; lane < lanes; ++lane) {
+			sum += std::complex(sum_real[lane], sum_imag[lane]);
+		}
+		return sum;
+	}
+
+	root_finder_result find_roots(std::span<const std::complex<double>> coefficients, const root_finder_settings& settings,
+		thread_pool* pool) {
+		const auto start = std::chrono::steady_clock::now();
+		auto monic = make_monic(coefficients);
+
+		// Zeros at the origin are exact, and are split off before they can slow the rest down
+		size_t zero_roots = 0;
+		while (zero_roots + 1 < monic.size() && monic[zero_roots] == std::complex<double>{}) ++zero_roots;
+		monic.erase(monic.begin(), monic.begin() + zero_roots);
+
+		root_finder_result result;
+		auto& diagnostics = result.diagnostics;
+		diagnostics.degree = monic.size() - 1 + zero_roots;
+		diagnostics.converged_roots = zero_roots;
+
+		const size_t degree = monic.size() - 1;
+		if (degree > 0) {
+			std::vector<double> magnitudes;
+			for (const auto coefficient : monic) magnitudes.push_back(std::abs(coefficient));
+
+			const auto roots = initial_roots(monic);
+			std::vector<double> real, imag;
+			for (const auto root : roots) {
+				real.push_back(root.real());
+				imag.push_back(root.imag());
+			}
+			std::vector<std::complex<double>> corrections(degree);
+			std::vector<char> converged(degree);
+			std::vector<root_evaluation> evaluations(degree);
+			const double tolerance = settings.tolerance * static_cast<double>(degree);
+
+			// Each task corrects a contiguous run of roots
+			constexpr size_t roots_per_task = 64;
+			const size_t task_count = (degree + roots_per_task - 1) / roots_per_task;
+			const auto correct = [&](size_t task_index, unsigned) {
+				const size_t end = std::min(degree, (task_index + 1) * roots_per_task);
+				for (size_t i = task_index * roots_per_task; i < end; ++i) {
+					corrections[i] = {};
+					if (converged[i]) continue;
+					evaluations[i] = evaluate_root(monic, magnitudes, std::complex(real[i], imag[i]));
+					if (evaluations[i].exact || evaluations[i].backward_error <= tolerance) {
+						converged[i] = true;
+						continue;
+					}
+					// The Newton step, pushed away from all the other roots: 1 / (p' / p - sum 1 / (z_i - z_j))
+					const auto correction = 1.0 / (evaluations[i].derivative_ratio - reciprocal_distance_sum(real, imag, i));
+					if (std::isfinite(correction.real()) && std::isfinite(correction.imag())) {
+						corrections[i] = correction;
+					}
+				}
+			};
+			const bool parallel = pool && degree >= settings.parallel_degree;
+
+			while (diagnostics.iterations < settings.max_iterations) {
+				if (parallel) {
+					pool->run(task_count, correct);
+				}
+				else {
+					for (size_t task = 0; task < task_count; ++task) correct(task, 0);
+				}
+				if (std::ranges::all_of(converged, [](char done) { return done; })) break;
+				for (size_t i = 0; i < degree; ++i) {
+					real[i] -= corrections[i].real();
+					imag[i] -= corrections[i].imag();
+				}
+				++diagnostics.iterations;
+			}
+
+			// The last sweep's evaluations are stale for the roots it moved
+			for (size_t i = 0; i < degree; ++i) {
+				const std::complex root(real[i], imag[i]);
+				if (!converged[i]) evaluations[i] = evaluate_root(monic, magnitudes, root);
+				diagnostics.converged_roots += converged[i] ? 1 : 0;
+				diagnostics.max_backward_error = std::max(diagnostics.max_backward_error, evaluations[i].backward_error);
+				if (!evaluations[i].exact) {
+					diagnostics.max_error_bound = std::max(diagnostics.max_error_bound,
+						static_cast<double>(degree) / std::abs(evaluations[i].derivative_ratio));
+				}
+				result.roots.push_back(root);
+			}
+		}
+		result.roots.insert(result.roots.end(), zero_roots, std::complex<double>{});
+
+		std::ranges::sort(result.roots, [](std::complex<double> a, std::complex<double> b) {
+			const auto key = [](std::complex<double> z) { return std::pair(std::arg(z), std::abs(z)); };
+			return key(a) < key(b);
+		});
+		diagnostics.elapsed = std::chrono::steady_clock::now() - start;
+		return result;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <span>
+#include <chrono>
+#include <limits>
+
+#include "thread_pool.hpp"
+
+namespace euleristic {
+
+	struct root_finder_settings {
+		// Sweeps over all the roots before giving up on the ones that haven't converged
+		size_t max_iterations = 1000;
+		// A root has converged once it is an exact root of a polynomial whose coefficients are all within degree times this
+		// relative distance of the given ones. Horner's rule itself rounds by about that much, so there's no getting closer.
+		double tolerance = 4.0 * std::numeric_limits<double>::epsilon();
+		// Below this degree a sweep is over too soon to be worth spreading over threads
+		size_t parallel_degree = 256;
+	};
+
+	struct root_finder_diagnostics {
+		size_t degree{};
+		// Sweeps, each of which updated every root that hadn't converged yet
+		size_t iterations{};
+		size_t converged_roots{};
+		// The largest |p(z)| / sum(|a_k| |z|^k) over the roots, which is how far the coefficients would have to move
+		// for each of them to be exact
+		double max_backward_error{};
+		// The largest degree * |p(z) / p'(z)| over the roots. A disk of that radius around a root holds a true root,
+		// so this bounds the error in absolute terms, though it's loose for clustered or multiple roots.
+		double max_error_bound{};
+		std::chrono::duration<double> elapsed{};
+
+		bool converged() const noexcept;
+	};
+
+	struct root_finder_result {
+		// Sorted by argument and then magnitude, so that the colors they're given don't depend on the order they converged in
+		std::vector<std::complex<double>> roots;
+		root_finder_diagnostics diagnostics;
+	};
+
+	// Finds every root of the polynomial, lowest power first, at once with the Aberth-Ehrlich method. The roots start out
+	// on circles with radii read off the Newton polygon of the coefficients' magnitudes, which puts them near their
+	// final magnitudes even when those span many orders, and are then all corrected together each sweep. Each sweep only
+	// reads the previous one's roots, so the roots can be corrected in any order, and are spread over pool if it isn't
+	// null and the degree is large enough, with the same result for any thread count.
+	// Throws std::invalid_argument if every coefficient is zero.
+	root_finder_result find_roots(std::span<const std::complex<double>> coefficients, const root_finder_settings& settings = {},
+		thread_pool* pool = nullptr);
+}
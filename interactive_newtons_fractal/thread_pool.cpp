@@ -0,0 +1,135 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace euleristic {
+
+	thread_pool::thread_pool(unsigned thread_count) {
+		if (thread_count == 0) {
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		for (unsigned i = 0; i < thread_count; ++i) {
+			queues.push_back(std::make_unique<worker_queue>());
+		}
+		for (unsigned i = 0; i < thread_count; ++i) {
+			workers.emplace_back([this, i](std::stop_token stop_token) { work(stop_token, i); });
+		}
+	}
+
+	void thread_pool::run(size_t task_count, const task_type& task) {
+		if (task_count == 0) return;
+
+		{
+			std::lock_guard lock(batch_mutex);
+
+			// Seed each queue with a contiguous run of tasks
+			const size_t queue_count = queues.size();
+			for (size_t i = 0; i < queue_count; ++i) {
+				std::lock_guard queue_lock(queues[i]->mutex);
+				for (size_t index = task_count * i / queue_count; index < task_count * (i + 1) / queue_count; ++index) {
+					queues[i]->tasks.push_back(index);
+				}
+			}
+
+			remaining_tasks = task_count;
+			current_task = &task;
+			first_error = nullptr;
+			steal_count = 0;
+			++generation;
+		}
+		batch_started.notify_all();
+
+		std::exception_ptr error;
+		{
+			std::unique_lock lock(batch_mutex);
+			batch_finished.wait(lock, [this] { return remaining_tasks == 0 && busy_workers == 0; });
+			// No worker may pick the task up after this point, since it dies with the caller's frame
+			current_task = nullptr;
+			error = first_error;
+		}
+
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	unsigned thread_pool::thread_count() const noexcept {
+		return static_cast<unsigned>(workers.size());
+	}
+
+	size_t thread_pool::last_steal_count() const noexcept {
+		return steal_count.load(std::memory_order_relaxed);
+	}
+
+	bool thread_pool::try_pop(unsigned worker_index, size_t& task_index) noexcept {
+		// Own work first, from the front...
+		{
+			auto& own = *queues[worker_index];
+			std::lock_guard lock(own.mutex);
+			if (!own.tasks.empty()) {
+				task_index = own.tasks.front();
+				own.tasks.pop_front();
+				return true;
+			}
+		}
+		// ...then someone else's, from the back, which is the work furthest from what its owner is doing right now.
+		for (size_t offset = 1; offset < queues.size(); ++offset) {
+			auto& victim = *queues[(worker_index + offset) % queues.size()];
+			std::lock_guard lock(victim.mutex);
+			if (!victim.tasks.empty()) {
+				task_index = victim.tasks.back();
+				victim.tasks.pop_back();
+				steal_count.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void thread_pool::work(std::stop_token stop_token, unsigned worker_index) {
+		size_t seen_generation = 0;
+		while (true) {
+			const task_type* task;
+			{
+				std::unique_lock lock(batch_mutex);
+				if (!batch_started.wait(lock, stop_token,
+					[&] { return current_task && generation != seen_generation; })) {
+					return;
+				}
+				seen_generation = generation;
+				task = current_task;
+				++busy_workers;
+			}
+
+			size_t task_index;
+			size_t completed = 0;
+			while (try_pop(worker_index, task_index)) {
+				try {
+					(*task)(task_index, worker_index);
+				}
+				catch (...) {
+					std::lock_guard lock(batch_mutex);
+					if (!first_error) {
+						first_error = std::current_exception();
+					}
+				}
+				++completed;
+			}
+
+			{
+				std::lock_guard lock(batch_mutex);
+				remaining_tasks -= completed;
+				--busy_workers;
+			}
+			batch_finished.notify_all();
+		}
+	}
+
+	thread_pool::~thread_pool() noexcept {
+		for (auto& worker : workers) {
+			worker.request_stop();
+		}
+		// The jthreads join on destruction
+	}
+}
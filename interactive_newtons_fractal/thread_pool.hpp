@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <condition_variable>
+
+namespace euleristic {
+
+	// A fixed set of worker threads that run batches of indexed tasks. Every worker owns a queue that is seeded with
+	// a contiguous run of task indices, so neighbouring tiles tend to stay on the same core. A worker that runs dry
+	// steals from the back of another worker's queue, which is what keeps the cores busy when a few tiles near the
+	// basin boundaries cost far more than the rest.
+	class thread_pool {
+	public:
+		using task_type = std::function<void(size_t task_index, unsigned worker_index)>;
+
+		// A thread count of 0 means one worker per hardware thread.
+		explicit thread_pool(unsigned thread_count = 0);
+
+		// Runs task for every index in [0, task_count) and blocks until all of them are done.
+		// The first exception thrown by a task is rethrown here, once the batch has drained.
+		void run(size_t task_count, const task_type& task);
+
+		unsigned thread_count() const noexcept;
+
+		// The number of tasks that were executed by another worker than the one they were seeded to, during the last run.
+		size_t last_steal_count() const noexcept;
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+		~thread_pool() noexcept;
+
+	private:
+		struct worker_queue {
+			std::mutex mutex;
+			std::deque<size_t> tasks;
+		};
+
+		std::vector<std::unique_ptr<worker_queue>> queues;
+
+		std::mutex batch_mutex;
+		std::condition_variable_any batch_started;
+		std::condition_variable batch_finished;
+		const task_type* current_task{};
+		size_t generation{};
+		unsigned busy_workers{};
+		size_t remaining_tasks{};
+		std::exception_ptr first_error{};
+
+		std::atomic<size_t> steal_count{};
+
+		// Declared last, so that the threads are joined before anything they touch is destroyed.
+		std::vector<std::jthread> workers;
+
+		bool try_pop(unsigned worker_index, size_t& task_index) noexcept;
+		void work(std::stop_token stop_token, unsigned worker_index);
+	};
+}
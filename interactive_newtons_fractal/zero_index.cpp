@@ -0,0 +1,188 @@
+#include "zero_index.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace euleristic {
+
+	template<typename visitor>
+	void zero_index::visit_ring(std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t ring, visitor&& visit) const {
+		const auto visit_cell = [&](std::ptrdiff_t cell_x, std::ptrdiff_t cell_y) {
+			if (cell_x < 0 || cell_y < 0 || cell_x >= static_cast<std::ptrdiff_t>(column_count) || cell_y >= static_cast<std::ptrdiff_t>(row_count)) return;
+			const size_t cell = static_cast<size_t>(cell_x) + static_cast<size_t>(cell_y) * column_count;
+			for (auto k = bucket_offsets[cell]; k < bucket_offsets[cell + 1]; ++k) {
+				visit(bucket_zeros[k]);
+			}
+		};
+
+		if (ring == 0) {
+			visit_cell(x, y);
+			return;
+		}
+		for (std::ptrdiff_t dx = -ring; dx <= ring; ++dx) {
+			visit_cell(x + dx, y - ring);
+			visit_cell(x + dx, y + ring);
+		}
+		for (std::ptrdiff_t dy = -ring + 1; dy < ring; ++dy) {
+			visit_cell(x - ring, y + dy);
+			visit_cell(x + ring, y + dy);
+		}
+	}
+
+	zero_index::zero_index(std::span<const std::complex<double>> zeros, double classification_radius) : zeros(zeros.begin(), zeros.end()) {
+		candidate_offsets.assign(1, 0);
+		if (zeros.empty()) return;
+
+		double min_real = zeros[0].real(), max_real = min_real, min_imag = zeros[0].imag(), max_imag = min_imag;
+		for (const auto& zero : zeros) {
+			min_real = std::min(min_real, zero.real());
+			max_real = std::max(max_real, zero.real());
+			min_imag = std::min(min_imag, zero.imag());
+			max_imag = std::max(max_imag, zero.imag());
+		}
+
+		// About a zero per cell, whether they fill an area or lie along a line. A radius far larger than the spacing of
+		// the zeros would make for a grid mostly of margin, so the cells grow until there are only a few per zero.
+		const double margin = std::max(classification_radius, 0.0);
+		const double count = static_cast<double>(zeros.size());
+		const double width = max_real - min_real, height = max_imag - min_imag;
+		cell_edge = std::max(std::sqrt(width * height / count), std::max(width, height) / count);
+		if (!(cell_edge > 0.0)) cell_edge = margin > 0.0 ? margin : 1.0;
+		const double max_cells = 4.0 * count + 64.0;
+		while (true) {
+			const double columns = std::floor((width + 2.0 * margin) / cell_edge) + 1.0;
+			const double rows = std::floor((height + 2.0 * margin) / cell_edge) + 1.0;
+			if (columns * rows <= max_cells) {
+				column_count = static_cast<size_t>(columns);
+				row_count = static_cast<size_t>(rows);
+				break;
+			}
+			cell_edge *= 1.5;
+		}
+		grid_origin = { min_real - margin, min_imag - margin };
+
+		const auto cell_of = [&](std::complex<double> zero) {
+			const auto x = std::min(static_cast<size_t>((zero.real() - grid_origin.real()) / cell_edge), column_count - 1);
+			const auto y = std::min(static_cast<size_t>((zero.imag() - grid_origin.imag()) / cell_edge), row_count - 1);
+			return x + y * column_count;
+		};
+
+		// Counting sort, which keeps each cell's zeros in order of index
+		const size_t cell_count = column_count * row_count;
+		bucket_offsets.assign(cell_count + 1, 0);
+		for (const auto& zero : zeros) ++bucket_offsets[cell_of(zero) + 1];
+		for (size_t cell = 0; cell < cell_count; ++cell) bucket_offsets[cell + 1] += bucket_offsets[cell];
+		bucket_zeros.resize(zeros.size());
+		{
+			auto next = bucket_offsets;
+			for (size_t i = 0; i < zeros.size(); ++i) {
+				bucket_zeros[next[cell_of(zeros[i])]++] = static_cast<std::int32_t>(i);
+			}
+		}
+
+		// Every point of a cell has a zero within the distance to the farthest corner of the cell from any one zero,
+		// so the zero a point in the cell is nearest to can be no farther from the cell than the least such distance,
+		// nor than the radius. The rings are searched outwards until they are farther away than that.
+		const auto max_ring = static_cast<std::ptrdiff_t>(std::max(column_count, row_count));
+		std::vector<std::int32_t> cell_candidates;
+		for (size_t y = 0; y < row_count; ++y) {
+			for (size_t x = 0; x < column_count; ++x) {
+				const double left = grid_origin.real() + static_cast<double>(x) * cell_edge, right = left + cell_edge;
+				const double bottom = grid_origin.imag() + static_cast<double>(y) * cell_edge, top = bottom + cell_edge;
+				const auto cell_x = static_cast<std::ptrdiff_t>(x), cell_y = static_cast<std::ptrdiff_t>(y);
+
+				double farthest = std::numeric_limits<double>::infinity();
+				for (std::ptrdiff_t ring = 0; ring <= max_ring && static_cast<double>(ring - 1) * cell_edge <= std::min(farthest, margin); ++ring) {
+					visit_ring(cell_x, cell_y, ring, [&](std::int32_t i) {
+						const double dx = std::max(std::abs(zeros[i].real() - left), std::abs(zeros[i].real() - right));
+						const double dy = std::max(std::abs(zeros[i].imag() - bottom), std::abs(zeros[i].imag() - top));
+						farthest = std::min(farthest, std::sqrt(dx * dx + dy * dy));
+					});
+				}
+				// Widened a hair, so that a point right on the edge of a cell is safe whichever way its cell is rounded
+				const double limit = std::min(farthest, margin) * (1.0 + 1e-9) + cell_edge * 1e-9;
+
+				cell_candidates.clear();
+				for (std::ptrdiff_t ring = 0; ring <= max_ring && static_cast<double>(ring - 1) * cell_edge <= limit; ++ring) {
+					visit_ring(cell_x, cell_y, ring, [&](std::int32_t i) {
+						const double dx = std::max({ left - zeros[i].real(), 0.0, zeros[i].real() - right });
+						const double dy = std::max({ bottom - zeros[i].imag(), 0.0, zeros[i].imag() - top });
+						if (dx * dx + dy * dy <= limit * limit) cell_candidates.push_back(i);
+					});
+				}
+				std::ranges::sort(cell_candidates);
+				candidate_zeros.insert(candidate_zeros.end(), cell_candidates.begin(), cell_candidates.end());
+				candidate_offsets.push_back(static_cast<std::int32_t>(candidate_zeros.size()));
+			}
+		}
+	}
+
+	std::optional<size_t> zero_index::nearest(std::complex<double> point, double radius) const {
+		if (zeros.empty() || !(radius >= 0.0) || !std::isfinite(point.real()) || !std::isfinite(point.imag())) return {};
+
+		// The cells the circle's bounding box overlaps, clamped to the grid
+		const double first_x = std::max(std::floor((point.real() - radius - grid_origin.real()) / cell_edge), 0.0);
+		const double last_x = std::min(std::floor((point.real() + radius - grid_origin.real()) / cell_edge), static_cast<double>(column_count) - 1.0);
+		const double first_y = std::max(std::floor((point.imag() - radius - grid_origin.imag()) / cell_edge), 0.0);
+		const double last_y = std::min(std::floor((point.imag() + radius - grid_origin.imag()) / cell_edge), static_cast<double>(row_count) - 1.0);
+		if (!(first_x <= last_x && first_y <= last_y)) return {};
+
+		std::optional<size_t> nearest_zero;
+		double nearest_distance_squared = radius * radius;
+		for (auto y = static_cast<size_t>(first_y); y <= static_cast<size_t>(last_y); ++y) {
+			for (auto x = static_cast<size_t>(first_x); x <= static_cast<size_t>(last_x); ++x) {
+				const size_t cell = x + y * column_count;
+				for (auto k = bucket_offsets[cell]; k < bucket_offsets[cell + 1]; ++k) {
+					const auto i = static_cast<size_t>(bucket_zeros[k]);
+					const double distance_squared = std::norm(zeros[i] - point);
+					if (distance_squared < nearest_distance_squared
+						|| (nearest_zero && distance_squared == nearest_distance_squared && i < *nearest_zero)) {
+						nearest_zero = i;
+						nearest_distance_squared = distance_squared;
+					}
+				}
+			}
+		}
+		return nearest_zero;
+	}
+
+	std::optional<size_t> zero_index::classify(std::complex<double> point, double radius) const {
+		const auto position = (point - grid_origin) / cell_edge;
+		// Written so that NaN is outside too
+		if (!(position.real() >= 0.0 && position.imag() >= 0.0 && position.real() < static_cast<double>(column_count)
+			&& position.imag() < static_cast<double>(row_count))) {
+			return {};
+		}
+		const size_t cell = static_cast<size_t>(position.real()) + static_cast<size_t>(position.imag()) * column_count;
+
+		std::optional<size_t> nearest_zero;
+		double nearest_distance_squared = radius * radius;
+		for (auto k = candidate_offsets[cell]; k < candidate_offsets[cell + 1]; ++k) {
+			const auto i = static_cast<size_t>(candidate_zeros[k]);
+			const double distance_squared = std::norm(zeros[i] - point);
+			if (distance_squared < nearest_distance_squared) {
+				nearest_zero = i;
+				nearest_distance_squared = distance_squared;
+			}
+		}
+		return nearest_zero;
+	}
+
+	double zero_index::closest_pair_distance_squared() const noexcept {
+		double closest = std::numeric_limits<double>::infinity();
+		const auto max_ring = static_cast<std::ptrdiff_t>(std::max(column_count, row_count));
+		for (size_t i = 0; i < zeros.size(); ++i) {
+			const auto x = static_cast<std::ptrdiff_t>(std::min(static_cast<size_t>((zeros[i].real() - grid_origin.real()) / cell_edge), column_count - 1));
+			const auto y = static_cast<std::ptrdiff_t>(std::min(static_cast<size_t>((zeros[i].imag() - grid_origin.imag()) / cell_edge), row_count - 1));
+			for (std::ptrdiff_t ring = 0; ring <= max_ring; ++ring) {
+				const double gap = static_cast<double>(ring - 1) * cell_edge;
+				if (ring > 1 && gap * gap > closest) break;
+				visit_ring(x, y, ring, [&](std::int32_t j) {
+					if (static_cast<size_t>(j) != i) closest = std::min(closest, std::norm(zeros[i] - zeros[j]));
+				});
+			}
+		}
+		return closest;
+	}
+}
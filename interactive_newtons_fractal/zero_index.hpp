@@ -0,0 +1,56 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <complex>
+#include <cstdint>
+#include <optional>
+
+namespace euleristic {
+
+	// A uniform grid over the zeros, sized so that a cell holds about one zero, for finding the zero nearest a point
+	// without looking at all of them. The window uses it to pick zeros under the mouse, and the fractal shader gets its
+	// candidate lists, so that telling which zero a pixel converged to costs the same at degree 3 as at degree 3000.
+	class zero_index {
+	public:
+		zero_index() = default;
+		// classification_radius is the largest radius candidates() is built for. The grid reaches that far past the
+		// outermost zeros, so a point outside of it isn't within that radius of any zero.
+		zero_index(std::span<const std::complex<double>> zeros, double classification_radius);
+
+		// The index of the zero nearest point, if it is within radius. Ties go to the lower index, like a linear scan
+		// keeping the first strictly nearer zero would. Only looks at the cells the circle overlaps.
+		std::optional<size_t> nearest(std::complex<double> point, double radius) const;
+
+		// The same for a radius no larger than the classification radius, from the candidates of point's cell alone, which
+		// is what the fractal shader does
+		std::optional<size_t> classify(std::complex<double> point, double radius) const;
+
+		// The squared distance between the closest two zeros, or infinity if there are fewer than two
+		double closest_pair_distance_squared() const noexcept;
+
+		// The grid's lower left corner, in fractal space, and its cells' edge
+		std::complex<double> origin() const noexcept { return grid_origin; }
+		double cell_size() const noexcept { return cell_edge; }
+		size_t columns() const noexcept { return column_count; }
+		size_t rows() const noexcept { return row_count; }
+
+		// The zeros which could be the nearest within the classification radius of some point in a cell, in order of
+		// index: those of cell x + y * columns() are candidates()[cell_offsets()[cell] .. cell_offsets()[cell + 1]).
+		std::span<const std::int32_t> cell_offsets() const noexcept { return candidate_offsets; }
+		std::span<const std::int32_t> candidates() const noexcept { return candidate_zeros; }
+
+	private:
+		std::vector<std::complex<double>> zeros;
+		std::complex<double> grid_origin{};
+		double cell_edge = 1.0;
+		size_t column_count{}, row_count{};
+		// The zeros in each cell, counting sorted the same way as the candidates
+		std::vector<std::int32_t> bucket_offsets, bucket_zeros;
+		std::vector<std::int32_t> candidate_offsets, candidate_zeros;
+
+		// Calls visit with the index of every zero in the cells at Chebyshev distance ring from cell (x, y)
+		template<typename visitor>
+		void visit_ring(std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t ring, visitor&& visit) const;
+	};
+}
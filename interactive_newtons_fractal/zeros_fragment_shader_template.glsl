@@ -3,10 +3,9 @@
 // This shader draws a disk with a border. The disk with the border has unit radius, the "inner disk" has sqrt(TEMPLATE_RADIUS_SQR).
 
 in vec2 square_coords;
+flat in vec4 color;
 out vec4 frag_color;
 
-uniform vec4 color;
-
 void main() {
 	float coord_magnitude_sqr = dot(square_coords, square_coords);
 	if (coord_magnitude_sqr > 1.0f)
@@ -1,12 +1,26 @@
 #version 410 core
 
+// One instance per zero. The square is scaled to the marker's radius in pixels around the zero's position on screen.
+
 layout (location = 0) in vec2 square_coordinate_attribute;
+layout (location = 1) in dvec2 zero_attribute; // In fractal space
+layout (location = 2) in vec4 color_attribute;
 
 out vec2 square_coords;
+flat out vec4 color;
 
-uniform mat3 transform;
+// Where the screen's origin is in fractal space, as a double-double, and the linear part of the fractal to screen transform.
+// The zero is taken relative to the origin before it is scaled, so that the markers stay put at deep zooms too.
+uniform dvec2 fractal_space_origin;
+uniform dvec2 fractal_space_origin_low;
+uniform dmat2 fractal_to_screen;
+uniform mat3 screen_to_normal;
+uniform float radius;
 
 void main() {
-	gl_Position = vec4((transform * vec3(square_coordinate_attribute, 1.0f)).xy, 0.0f, 1.0f);
+	dvec2 relative = (zero_attribute - fractal_space_origin) - fractal_space_origin_low;
+	vec2 screen_position = vec2(fractal_to_screen * relative) + radius * square_coordinate_attribute;
+	gl_Position = vec4((screen_to_normal * vec3(screen_position, 1.0f)).xy, 0.0f, 1.0f);
 	square_coords = square_coordinate_attribute;
-}
\ No newline at end of file
+	color = color_attribute;
+}
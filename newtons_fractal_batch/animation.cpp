@@ -0,0 +1,50 @@
+#include "batch_job.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace euleristic {
+
+	// The uniform Catmull-Rom spline through p1 at s = 0 and p2 at s = 1, whose tangents point from p0 to p2 and from p1 to p3
+	std::complex<double> catmull_rom(std::complex<double> p0, std::complex<double> p1, std::complex<double> p2,
+		std::complex<double> p3, double s) noexcept {
+		return 0.5 * (2.0 * p1 + (p2 - p0) * s + (2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3) * (s * s)
+			+ (3.0 * (p1 - p2) + p3 - p0) * (s * s * s));
+	}
+
+	size_t keyframe_animation::frame_count() const noexcept {
+		if (keyframes.empty()) return 0;
+		const double duration = keyframes.back().time - keyframes.front().time;
+		// A little slack, so that a keyframe landing exactly on a frame isn't lost to rounding
+		return static_cast<size_t>(std::floor(duration * frame_rate + 1e-9)) + 1;
+	}
+
+	batch_job keyframe_animation::frame(size_t frame_index) const {
+		const double time = keyframes.front().time + static_cast<double>(frame_index) / frame_rate;
+		const auto after = std::ranges::upper_bound(keyframes, time, {}, &keyframe::time);
+		if (after == keyframes.end()) return keyframes.back().job;
+
+		const size_t i = static_cast<size_t>(after - keyframes.begin()) - 1;
+		const auto& from = keyframes[i].job;
+		const auto& to = keyframes[i + 1].job;
+		// The spline's ends just repeat the first and last keyframes
+		const auto& before = keyframes[i == 0 ? 0 : i - 1].job;
+		const auto& beyond = keyframes[std::min(i + 2, keyframes.size() - 1)].job;
+		const double s = (time - keyframes[i].time) / (keyframes[i + 1].time - keyframes[i].time);
+
+		auto job = from;
+		for (size_t k = 0; k < job.zeros.size(); ++k) {
+			job.zeros[k] = catmull_rom(before.zeros[k], from.zeros[k], to.zeros[k], beyond.zeros[k], s);
+		}
+
+		const double_double from_real(from.center.real(), from.center_low.real()), from_imag(from.center.imag(), from.center_low.imag());
+		const double_double to_real(to.center.real(), to.center_low.real()), to_imag(to.center.imag(), to.center_low.imag());
+		const auto real = from_real + (to_real - from_real) * s;
+		const auto imag = from_imag + (to_imag - from_imag) * s;
+		job.center = { real.hi, imag.hi };
+		job.center_low = { real.lo, imag.lo };
+
+		job.pixels_per_unit = from.pixels_per_unit * std::pow(to.pixels_per_unit / from.pixels_per_unit, s);
+		return job;
+	}
+}
@@ -0,0 +1,418 @@
+#include "batch_job.hpp"
+#include "polynomial.hpp"
+
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <charconv>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <stdexcept>
+#include <string_view>
+#include <cmath>
+
+using namespace std::string_literals;
+
+namespace euleristic {
+
+	const char* const batch_usage =
+		"Usage: newtons_fractal_batch [options]\n"
+		"Renders Newton's fractal on the CPU, without a window.\n"
+		"\n"
+		"Frame options, which may also be given per line in a job file:\n"
+		"  --zeros RE,IM [RE,IM ...]    The zeros of the polynomial (default: the three roots of z^3 + 1)\n"
+		"  --coefficients A [A ...]     The polynomial's coefficients instead, lowest power first, each RE or RE,IM.\n"
+		"                               Its zeros are found before rendering.\n"
+		"  --coefficient-file PATH      The same, read from a file of whitespace separated coefficients\n"
+		"  --center RE,IM               Fractal space point in the middle of the image, to as many digits as a deep\n"
+		"                               zoom needs (default: 0,0)\n"
+		"  --pixels-per-unit N          Zoom (default: 200)\n"
+		"  --size WIDTHxHEIGHT          Resolution (default: 800x600)\n"
+		"  --iterations N               Newton iterations per pixel (default: 20)\n"
+		"  --epsilon-squared X          Squared distance to a zero that counts as converged (default: 0.1)\n"
+		"  --step-squared X             Stop iterating a pixel once its squared step is below X (default: 1e-24)\n"
+		"  --no-early-exit              Iterate every pixel the full count, even once it has converged\n"
+		"  --evaluation MODE            coefficients or zeros (default: coefficients)\n"
+		"  --method METHOD              newton, halley, householder or multiplicity: the step each pixel takes. The\n"
+		"                               others take fewer, costlier steps, and are iterated in double without SIMD\n"
+		"                               (default: newton)\n"
+		"  --precision MODE             auto, double or double-double (default: auto, which switches to double-double\n"
+		"                               once the pixels get too small for double)\n"
+		"  --scale K                    Multiply the size and the pixels per unit given along with it by K, which\n"
+		"                               renders the same view at K times the resolution\n"
+		"  --output PATH                File to write, - for stdout; {} is replaced with the job index (default: -)\n"
+		"  --format FORMAT              ppm, png or raw (default: from the extension, raw for stdout)\n"
+		"\n"
+		"Global options:\n"
+		"  --job-file PATH              Render one frame per line of PATH\n"
+		"  --animation PATH             Render an animation from the keyframes in PATH, one per line: a time in seconds\n"
+		"                               and then frame options. The zeros, center and zoom are interpolated.\n"
+		"  --frame-rate N               Frames per second of the animation (default: 30)\n"
+		"  --queue-depth N              Frames that may wait between preparing, rendering and encoding (default: 4)\n"
+		"  --encoders N                 Threads encoding and writing frames, always 1 for stdout (default: 2)\n"
+		"  --export                     Render each job in strips of rows straight into its file, so the image never\n"
+		"                               has to fit in memory, for gigapixel images\n"
+		"  --strip-rows N               Rows per strip of an export (default: about 32 MiB of pixels)\n"
+		"  --resume                     Carry on with an interrupted export of the same job where it left off\n"
+		"  --basin-maps                 Write which zero each pixel converged to and its step count, rather than its\n"
+		"                               color, to each output as a .basins file, to be colored later\n"
+		"  --recolor PATH               Color the .basins file at PATH and write it to --output, without rendering\n"
+		"  --workers N                  Render the frames on N worker processes of this program, in bands of rows\n"
+		"  --worker-command COMMAND     Start another worker with COMMAND, which runs newtons_fractal_batch --worker\n"
+		"                               somewhere, like ssh HOST newtons_fractal_batch --worker. May be repeated.\n"
+		"  --band-rows N                Rows per band handed to a worker (default: about 8 bands per worker)\n"
+		"  --band-timeout SECONDS       Hand a band out again if it hasn't come back after this long (default: four\n"
+		"                               times the mean a band has taken)\n"
+		"  --worker                     Render bands for a coordinator on stdin and stdout, with --threads and --isa\n"
+		"  --threads N                  Worker threads, 0 for one per hardware thread, split between the processes\n"
+		"                               of --workers (default: 0)\n"
+		"  --tile-size N                Edge of the square tiles in pixels (default: 32)\n"
+		"  --isa ISA                    scalar, avx2 or avx512 (default: the best the CPU supports)\n"
+		"  --no-subdivision             Iterate every pixel instead of filling basin interiors from their borders\n"
+		"  --quiet                      Don't report statistics on stderr\n"
+		"  --histogram                  Report how many pixels took each number of iterations, too\n"
+		"  --help                       Show this\n";
+
+	root_finder_diagnostics batch_job::find_zeros(thread_pool* pool) {
+		auto [roots, diagnostics] = find_roots(coefficients, {}, pool);
+		zeros = std::move(roots);
+		return diagnostics;
+	}
+
+	fractal_scene batch_job::scene() const {
+		fractal_scene scene;
+		scene.zeros = zeros;
+		if (evaluation == evaluation_mode::coefficients) {
+			// The given coefficients are exact, where expanding the zeros found from them again would only add error
+			scene.coefficients = coefficients.empty() ? zeros_to_coefficients(zeros) : coefficients;
+		}
+		set_viewport(scene, width, height, double_double(center.real(), center_low.real()),
+			double_double(center.imag(), center_low.imag()), pixels_per_unit);
+		scene.iteration_count = iteration_count;
+		scene.epsilon_squared = epsilon_squared;
+		scene.early_exit = early_exit;
+		scene.step_squared = step_squared;
+		scene.evaluation = evaluation;
+		scene.method = method;
+		scene.precision = precision;
+		return scene;
+	}
+
+	std::string batch_job::output_path(size_t job_index) const {
+		if (output.find('{') == std::string::npos) return output;
+		return std::vformat(output, std::make_format_args(job_index));
+	}
+
+	image_format batch_job::output_format() const noexcept {
+		if (format) return *format;
+		if (output == "-") return image_format::raw;
+		return image_format_from_path(output);
+	}
+
+	// Parsing
+
+	template<typename number_type>
+	number_type parse_number(std::string_view text, std::string_view option) {
+		number_type value{};
+		auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+		if (error != std::errc{} || end != text.data() + text.size()) {
+			throw std::invalid_argument("Malformed number for "s + std::string(option) + ": " + std::string(text));
+		}
+		return value;
+	}
+
+	std::complex<double> parse_complex(std::string_view text, std::string_view option) {
+		const auto comma = text.find(',');
+		if (comma == std::string_view::npos) {
+			throw std::invalid_argument("Expected RE,IM for "s + std::string(option) + ", got: " + std::string(text));
+		}
+		return { parse_number<double>(text.substr(0, comma), option), parse_number<double>(text.substr(comma + 1), option) };
+	}
+
+	// A coefficient may be real, without the comma
+	std::complex<double> parse_coefficient(std::string_view text, std::string_view option) {
+		if (text.find(',') == std::string_view::npos) return parse_number<double>(text, option);
+		return parse_complex(text, option);
+	}
+
+	std::vector<std::complex<double>> monic_coefficients(const std::vector<std::complex<double>>& coefficients, std::string_view option) {
+		if (coefficients.size() < 2) {
+			throw std::invalid_argument(std::string(option) + " needs at least two coefficients.");
+		}
+		auto monic = make_monic(coefficients);
+		if (monic.size() < 2) {
+			throw std::invalid_argument("The polynomial given by "s + std::string(option) + " is constant.");
+		}
+		return monic;
+	}
+
+	// For the center, which may be given to more digits than a double holds. Returns the rounded value and what's left.
+	std::pair<std::complex<double>, std::complex<double>> parse_complex_double_double(std::string_view text, std::string_view option) {
+		const auto comma = text.find(',');
+		if (comma == std::string_view::npos) {
+			throw std::invalid_argument("Expected RE,IM for "s + std::string(option) + ", got: " + std::string(text));
+		}
+		const auto real = parse_double_double(text.substr(0, comma));
+		const auto imag = parse_double_double(text.substr(comma + 1));
+		if (!real || !imag) {
+			throw std::invalid_argument("Malformed number for "s + std::string(option) + ": " + std::string(text));
+		}
+		return { { real->hi, imag->hi }, { real->lo, imag->lo } };
+	}
+
+	struct input_files {
+		std::string job_file, animation_file;
+	};
+
+	// Reads the options in tokens into job and, if options isn't null, the global options.
+	void parse_tokens(const std::vector<std::string>& tokens, batch_job& job, batch_options* options, input_files* files) {
+		double scale = 1.0;
+		for (size_t i = 0; i < tokens.size(); ++i) {
+			const std::string_view option = tokens[i];
+			auto value = [&]() -> std::string_view {
+				if (i + 1 >= tokens.size()) {
+					throw std::invalid_argument("Missing value for "s + std::string(option));
+				}
+				return tokens[++i];
+			};
+
+			if (option == "--zeros") {
+				job.zeros.clear();
+				// Negative numbers start with a dash too, but never with two
+				while (i + 1 < tokens.size() && !tokens[i + 1].starts_with("--")) {
+					job.zeros.push_back(parse_complex(tokens[++i], option));
+				}
+				if (job.zeros.empty()) {
+					throw std::invalid_argument("--zeros needs at least one zero.");
+				}
+				job.coefficients.clear();
+			}
+			else if (option == "--coefficients") {
+				std::vector<std::complex<double>> coefficients;
+				while (i + 1 < tokens.size() && !tokens[i + 1].starts_with("--")) {
+					coefficients.push_back(parse_coefficient(tokens[++i], option));
+				}
+				job.coefficients = monic_coefficients(coefficients, option);
+				job.zeros.clear();
+			}
+			else if (option == "--coefficient-file") {
+				const std::string path(value());
+				std::ifstream input(path);
+				if (!input.is_open()) {
+					throw std::invalid_argument("Could not open coefficient file: "s + path);
+				}
+				std::vector<std::complex<double>> coefficients;
+				std::string word;
+				while (input >> word) {
+					coefficients.push_back(parse_coefficient(word, option));
+				}
+				job.coefficients = monic_coefficients(coefficients, option);
+				job.zeros.clear();
+			}
+			else if (option == "--center") std::tie(job.center, job.center_low) = parse_complex_double_double(value(), option);
+			else if (option == "--pixels-per-unit") job.pixels_per_unit = parse_number<double>(value(), option);
+			else if (option == "--size") {
+				const auto size = value();
+				const auto x = size.find('x');
+				if (x == std::string_view::npos) {
+					throw std::invalid_argument("Expected WIDTHxHEIGHT for --size, got: "s + std::string(size));
+				}
+				job.width = parse_number<size_t>(size.substr(0, x), option);
+				job.height = parse_number<size_t>(size.substr(x + 1), option);
+			}
+			else if (option == "--scale") {
+				scale = parse_number<double>(value(), option);
+				if (!(scale > 0.0)) {
+					throw std::invalid_argument("--scale must be positive.");
+				}
+			}
+			else if (option == "--iterations") job.iteration_count = parse_number<unsigned>(value(), option);
+			else if (option == "--epsilon-squared") job.epsilon_squared = parse_number<double>(value(), option);
+			else if (option == "--step-squared") job.step_squared = parse_number<double>(value(), option);
+			else if (option == "--no-early-exit") job.early_exit = false;
+			else if (option == "--evaluation") {
+				const auto mode = value();
+				if (mode == "coefficients") job.evaluation = evaluation_mode::coefficients;
+				else if (mode == "zeros") job.evaluation = evaluation_mode::zeros;
+				else throw std::invalid_argument("Unknown evaluation mode: "s + std::string(mode));
+			}
+			else if (option == "--method") {
+				const auto method = value();
+				if (method == "newton") job.method = iteration_method::newton;
+				else if (method == "halley") job.method = iteration_method::halley;
+				else if (method == "householder") job.method = iteration_method::householder;
+				else if (method == "multiplicity") job.method = iteration_method::multiplicity;
+				else throw std::invalid_argument("Unknown iteration method: "s + std::string(method));
+			}
+			else if (option == "--precision") {
+				const auto precision = value();
+				if (precision == "auto") job.precision = precision_mode::automatic;
+				else if (precision == "double") job.precision = precision_mode::standard;
+				else if (precision == "double-double") job.precision = precision_mode::double_double;
+				else throw std::invalid_argument("Unknown precision: "s + std::string(precision));
+			}
+			else if (option == "--output") job.output = value();
+			else if (option == "--format") job.format = parse_image_format(value());
+			else if (options && option == "--job-file") files->job_file = value();
+			else if (options && option == "--animation") files->animation_file = value();
+			else if (options && option == "--frame-rate") {
+				if (!options->animation) options->animation.emplace();
+				options->animation->frame_rate = parse_number<double>(value(), option);
+				if (!(options->animation->frame_rate > 0.0)) {
+					throw std::invalid_argument("--frame-rate must be positive.");
+				}
+			}
+			else if (options && option == "--queue-depth") {
+				options->queue_depth = parse_number<size_t>(value(), option);
+				if (options->queue_depth == 0) {
+					throw std::invalid_argument("--queue-depth must be positive.");
+				}
+			}
+			else if (options && option == "--encoders") options->encoder_count = std::max(1u, parse_number<unsigned>(value(), option));
+			else if (options && option == "--export") options->export_images = true;
+			else if (options && option == "--strip-rows") {
+				options->strip_rows = parse_number<size_t>(value(), option);
+				if (options->strip_rows == 0) {
+					throw std::invalid_argument("--strip-rows must be positive.");
+				}
+			}
+			else if (options && option == "--resume") options->resume = true;
+			else if (options && option == "--basin-maps") options->basin_maps = true;
+			else if (options && option == "--recolor") options->recolor = value();
+			else if (options && option == "--workers") options->local_workers = parse_number<unsigned>(value(), option);
+			else if (options && option == "--worker-command") options->worker_commands.emplace_back(value());
+			else if (options && option == "--band-rows") {
+				options->band_rows = parse_number<size_t>(value(), option);
+				if (options->band_rows == 0) {
+					throw std::invalid_argument("--band-rows must be positive.");
+				}
+			}
+			else if (options && option == "--band-timeout") {
+				options->band_timeout = parse_number<double>(value(), option);
+				if (!(options->band_timeout > 0.0)) {
+					throw std::invalid_argument("--band-timeout must be positive.");
+				}
+			}
+			else if (options && option == "--worker") options->worker = true;
+			else if (options && option == "--threads") options->thread_count = parse_number<unsigned>(value(), option);
+			else if (options && option == "--tile-size") options->tile_size = parse_number<size_t>(value(), option);
+			else if (options && option == "--isa") {
+				const auto isa = value();
+				if (isa == "scalar") options->isa = instruction_set::scalar;
+				else if (isa == "avx2") options->isa = instruction_set::avx2;
+				else if (isa == "avx512") options->isa = instruction_set::avx512;
+				else throw std::invalid_argument("Unknown instruction set: "s + std::string(isa));
+			}
+			else if (options && option == "--no-subdivision") options->subdivide = false;
+			else if (options && option == "--quiet") options->quiet = true;
+			else if (options && option == "--histogram") options->histogram = true;
+			else throw std::invalid_argument("Unknown option: "s + std::string(option));
+		}
+
+		// Scaled after everything else, so it doesn't matter whether --scale comes before or after --size
+		if (scale != 1.0) {
+			job.width = static_cast<size_t>(std::llround(static_cast<double>(job.width) * scale));
+			job.height = static_cast<size_t>(std::llround(static_cast<double>(job.height) * scale));
+			job.pixels_per_unit *= scale;
+		}
+
+		if (job.width == 0 || job.height == 0) {
+			throw std::invalid_argument("The image size must be positive.");
+		}
+		if (!(job.pixels_per_unit > 0.0)) {
+			throw std::invalid_argument("--pixels-per-unit must be positive.");
+		}
+	}
+
+	// Calls parse_line with the number and the tokens of each non-empty line of path not starting with #, and puts
+	// the path and line number in front of any error it throws
+	void read_option_lines(const std::string& path, const char* kind,
+		const std::function<void(size_t line_number, std::vector<std::string>& tokens)>& parse_line) {
+		std::ifstream input(path);
+		if (!input.is_open()) {
+			throw std::invalid_argument("Could not open "s + kind + ": " + path);
+		}
+		std::string line;
+		size_t line_number = 0;
+		while (std::getline(input, line)) {
+			++line_number;
+			std::istringstream words(line);
+			std::vector<std::string> tokens{ std::istream_iterator<std::string>(words), std::istream_iterator<std::string>() };
+			if (tokens.empty() || tokens.front().starts_with('#')) continue;
+
+			try {
+				parse_line(line_number, tokens);
+			}
+			catch (const std::invalid_argument& error) {
+				throw std::invalid_argument(path + ':' + std::to_string(line_number) + ": " + error.what());
+			}
+		}
+	}
+
+	batch_options parse_command_line(int argc, const char* const* argv) {
+		batch_options options;
+		batch_job defaults;
+		input_files files;
+		parse_tokens(std::vector<std::string>(argv + 1, argv + argc), defaults, &options, &files);
+
+		if (!files.job_file.empty() && !files.animation_file.empty()) {
+			throw std::invalid_argument("Give either --job-file or --animation, not both.");
+		}
+		if (options.export_images && !files.animation_file.empty()) {
+			throw std::invalid_argument("--export renders single images, not animations.");
+		}
+		if (options.basin_maps && (options.export_images || !files.animation_file.empty())) {
+			throw std::invalid_argument("--basin-maps renders single basin maps, not exports or animations.");
+		}
+		if (!options.recolor.empty() && (options.basin_maps || options.export_images || !files.animation_file.empty()
+			|| !files.job_file.empty())) {
+			throw std::invalid_argument("--recolor doesn't render, so it goes with --output and --format only.");
+		}
+
+		if ((options.local_workers > 0 || !options.worker_commands.empty())
+			&& (options.export_images || options.basin_maps || !options.recolor.empty() || options.worker)) {
+			throw std::invalid_argument("Workers render whole frames, not exports, basin maps or recoloring, and don't have workers of their own.");
+		}
+
+		if (!files.animation_file.empty()) {
+			if (!options.animation) options.animation.emplace();
+			auto& keyframes = options.animation->keyframes;
+			read_option_lines(files.animation_file, "keyframe file", [&](size_t, std::vector<std::string>& tokens) {
+				const double time = parse_number<double>(tokens.front(), "the keyframe time");
+				if (!keyframes.empty() && !(time > keyframes.back().time)) {
+					throw std::invalid_argument("The keyframes' times must increase.");
+				}
+				auto job = keyframes.empty() ? defaults : keyframes.back().job;
+				parse_tokens(std::vector(tokens.begin() + 1, tokens.end()), job, nullptr, nullptr);
+				if (!job.coefficients.empty()) {
+					// Interpolated coefficients would have to be solved again every frame, and their zeros could swap places
+					throw std::invalid_argument("Keyframes take --zeros, not coefficients.");
+				}
+				if (!keyframes.empty() && job.zeros.size() != keyframes.back().job.zeros.size()) {
+					throw std::invalid_argument("Every keyframe needs the same number of zeros.");
+				}
+				keyframes.push_back({ time, std::move(job) });
+			});
+			if (keyframes.empty()) {
+				throw std::invalid_argument("The keyframe file has no keyframes: "s + files.animation_file);
+			}
+			return options;
+		}
+		options.animation.reset();
+
+		if (files.job_file.empty()) {
+			options.jobs.push_back(defaults);
+			return options;
+		}
+
+		read_option_lines(files.job_file, "job file", [&](size_t, std::vector<std::string>& tokens) {
+			auto job = defaults;
+			parse_tokens(tokens, job, nullptr, nullptr);
+			options.jobs.push_back(std::move(job));
+		});
+		return options;
+	}
+}
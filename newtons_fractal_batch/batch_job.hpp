@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <complex>
+#include <optional>
+
+#include "cpu_renderer.hpp"
+#include "image_io.hpp"
+#include "root_finder.hpp"
+
+namespace euleristic {
+
+	// One frame to render, and where to put it.
+	struct batch_job {
+		std::vector<std::complex<double>> zeros{ { -1.0, 0.0 }, { 0.5, 0.8660254037844386 }, { 0.5, -0.8660254037844386 } };
+		// The polynomial, monic and lowest power first, when it was given by its coefficients rather than its zeros.
+		// Then the zeros are left empty until find_zeros fills them in.
+		std::vector<std::complex<double>> coefficients;
+		std::complex<double> center{};
+		// What's left of the center after rounding it to double, for deep zooms
+		std::complex<double> center_low{};
+		double pixels_per_unit = 200.0;
+		size_t width = 800, height = 600;
+		unsigned iteration_count = 20;
+		double epsilon_squared = 0.1;
+		bool early_exit = true;
+		double step_squared = 1e-24;
+		evaluation_mode evaluation = evaluation_mode::coefficients;
+		iteration_method method = iteration_method::newton;
+		precision_mode precision = precision_mode::automatic;
+
+		// A path, or "-" for stdout. Any {} in it is replaced with the index of the job, as by std::format.
+		std::string output = "-";
+		// Deduced from the output path if empty, and raw for stdout
+		std::optional<image_format> format{};
+
+		// Finds the zeros of the given coefficients with the Aberth-Ehrlich method, across pool's threads for high degrees
+		root_finder_diagnostics find_zeros(thread_pool* pool = nullptr);
+		fractal_scene scene() const;
+		std::string output_path(size_t job_index) const;
+		image_format output_format() const noexcept;
+	};
+
+	// The frame options in effect at a point in time of an animation
+	struct keyframe {
+		double time{};
+		batch_job job;
+	};
+
+	// Frames sampled at frame_rate from the first keyframe's time to the last's. The zeros follow Catmull-Rom splines
+	// through the keyframes, so they move along smooth paths, the center moves in a straight line (in double-double,
+	// for deep zooms) and the zoom changes by the same factor every frame. Everything else is taken from the last
+	// keyframe at or before the frame.
+	struct keyframe_animation {
+		std::vector<keyframe> keyframes;
+		double frame_rate = 30.0;
+
+		size_t frame_count() const noexcept;
+		batch_job frame(size_t frame_index) const;
+	};
+
+	struct batch_options {
+		unsigned thread_count = 0;
+		size_t tile_size = 32;
+		std::optional<instruction_set> isa{};
+		bool subdivide = true;
+		bool quiet = false;
+		bool histogram = false;
+		std::vector<batch_job> jobs;
+		// Takes the place of jobs if given
+		std::optional<keyframe_animation> animation;
+		// Frames waiting between the stages of the pipeline, and threads encoding them
+		size_t queue_depth = 4;
+		unsigned encoder_count = 2;
+		// Render each job in strips straight into its file instead, for images too large to hold in memory
+		bool export_images = false;
+		// Rows per strip, 0 for about 32 MiB of pixels
+		size_t strip_rows = 0;
+		bool resume = false;
+		// Write each job's basin map (see basin_map_io.hpp) to its output path instead of its image
+		bool basin_maps = false;
+		// Color the basin map at this path and write it to the first job's output, instead of rendering anything
+		std::string recolor;
+		// Render the frames on worker processes instead: local_workers of this program, and one started by each of
+		// worker_commands, which may run it on another host. Frames are handed out in bands of band_rows rows, 0 for
+		// about 8 per worker, and a band out for longer than band_timeout seconds is handed out again, 0 for
+		// deciding from how long bands take.
+		unsigned local_workers = 0;
+		std::vector<std::string> worker_commands;
+		size_t band_rows = 0;
+		double band_timeout = 0.0;
+		// Be a worker: render bands for a coordinator on stdin and stdout
+		bool worker = false;
+	};
+
+	// The options on the command line describe a single job, unless a job file is given. Then each non-empty line
+	// of the job file not starting with # holds the options of one job, with the command line's as defaults.
+	// A keyframe file is read the same way, except that each line starts with the keyframe's time in seconds, and
+	// takes the previous keyframe's options as defaults.
+	// Throws std::invalid_argument on malformed options.
+	batch_options parse_command_line(int argc, const char* const* argv);
+
+	extern const char* const batch_usage;
+}
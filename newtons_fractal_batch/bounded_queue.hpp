@@ -0,0 +1,80 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <condition_variable>
+
+namespace euleristic {
+
+	// A FIFO queue shared between threads, which blocks producers while it's full and consumers while it's empty.
+	// Closing it wakes everyone up: producers give up, and consumers get what's left and then nothing.
+	template<typename value_type>
+	class bounded_queue {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		explicit bounded_queue(size_t capacity) : capacity(capacity), created(clock::now()), last_change(created) {
+			if (capacity == 0) {
+				throw std::invalid_argument("A bounded queue needs room for at least one item.");
+			}
+		}
+
+		// Blocks while the queue is full. Returns false, dropping value, if the queue is closed.
+		bool push(value_type value) {
+			std::unique_lock lock(mutex);
+			not_full.wait(lock, [this] { return closed || items.size() < capacity; });
+			if (closed) return false;
+			account(clock::now());
+			items.push_back(std::move(value));
+			not_empty.notify_one();
+			return true;
+		}
+
+		// Blocks while the queue is empty. Returns nothing once the queue is closed and drained.
+		std::optional<value_type> pop() {
+			std::unique_lock lock(mutex);
+			not_empty.wait(lock, [this] { return closed || !items.empty(); });
+			if (items.empty()) return std::nullopt;
+			account(clock::now());
+			auto value = std::move(items.front());
+			items.pop_front();
+			not_full.notify_one();
+			return value;
+		}
+
+		void close() {
+			std::lock_guard lock(mutex);
+			closed = true;
+			not_empty.notify_all();
+			not_full.notify_all();
+		}
+
+		// How many items were waiting on average, over the queue's life so far
+		double mean_length() {
+			std::lock_guard lock(mutex);
+			const auto now = clock::now();
+			account(now);
+			const double lifetime = std::chrono::duration<double>(now - created).count();
+			return lifetime > 0.0 ? length_integral / lifetime : 0.0;
+		}
+
+	private:
+		std::mutex mutex;
+		std::condition_variable not_empty, not_full;
+		std::deque<value_type> items;
+		size_t capacity;
+		bool closed{};
+
+		// The length integrated over time, in item seconds
+		clock::time_point created, last_change;
+		double length_integral{};
+
+		void account(clock::time_point now) noexcept {
+			length_integral += static_cast<double>(items.size()) * std::chrono::duration<double>(now - last_change).count();
+			last_change = now;
+		}
+	};
+}
@@ -0,0 +1,239 @@
+#include "child_process.hpp"
+
+#include <vector>
+#include <cerrno>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+extern char** environ;
+#endif
+
+using namespace std::string_literals;
+
+namespace euleristic {
+
+#ifdef _WIN32
+
+	child_process::child_process(const std::string& command) : command_line(command) {
+		SECURITY_ATTRIBUTES inheritable{ sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+		HANDLE child_input{}, child_output{};
+		if (!CreatePipe(&child_input, &input, &inheritable, 0)) {
+			throw std::runtime_error("Could not create a pipe for: "s + command);
+		}
+		if (!CreatePipe(&output, &child_output, &inheritable, 0)) {
+			CloseHandle(child_input);
+			CloseHandle(input);
+			throw std::runtime_error("Could not create a pipe for: "s + command);
+		}
+		// Only the child's ends are for it to inherit. If it inherited ours too, it would never see its stdin close.
+		SetHandleInformation(input, HANDLE_FLAG_INHERIT, 0);
+		SetHandleInformation(output, HANDLE_FLAG_INHERIT, 0);
+
+		STARTUPINFOA startup{ sizeof(STARTUPINFOA) };
+		startup.dwFlags = STARTF_USESTDHANDLES;
+		startup.hStdInput = child_input;
+		startup.hStdOutput = child_output;
+		startup.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+		PROCESS_INFORMATION information{};
+		std::vector<char> mutable_command(command.begin(), command.end());
+		mutable_command.push_back('\0');
+		const bool started = CreateProcessA(nullptr, mutable_command.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr,
+			&startup, &information);
+		CloseHandle(child_input);
+		CloseHandle(child_output);
+		if (!started) {
+			CloseHandle(input);
+			CloseHandle(output);
+			throw std::runtime_error("Could not start: "s + command);
+		}
+		CloseHandle(information.hThread);
+		process = information.hProcess;
+	}
+
+	child_process::~child_process() noexcept {
+		close_input();
+		if (WaitForSingleObject(process, static_cast<DWORD>(exit_grace_period.count())) != WAIT_OBJECT_0) {
+			terminate();
+		}
+		WaitForSingleObject(process, INFINITE);
+		CloseHandle(process);
+		CloseHandle(output);
+	}
+
+	void child_process::write(const void* data, size_t size) {
+		auto bytes = static_cast<const char*>(data);
+		while (size > 0) {
+			DWORD written = 0;
+			if (!input || !WriteFile(input, bytes, static_cast<DWORD>(std::min<size_t>(size, 1 << 30)), &written, nullptr)) {
+				throw std::runtime_error("Lost the pipe to: "s + command_line);
+			}
+			bytes += written;
+			size -= written;
+		}
+	}
+
+	void child_process::read(void* data, size_t size) {
+		auto bytes = static_cast<char*>(data);
+		while (size > 0) {
+			DWORD read = 0;
+			if (!ReadFile(output, bytes, static_cast<DWORD>(std::min<size_t>(size, 1 << 30)), &read, nullptr) || read == 0) {
+				throw std::runtime_error("Lost the pipe from: "s + command_line);
+			}
+			bytes += read;
+			size -= read;
+		}
+	}
+
+	void child_process::close_input() noexcept {
+		if (input) CloseHandle(input);
+		input = nullptr;
+	}
+
+	void child_process::terminate() noexcept {
+		TerminateProcess(process, 1);
+	}
+
+	std::filesystem::path current_executable() {
+		std::vector<wchar_t> path(MAX_PATH);
+		while (true) {
+			const DWORD length = GetModuleFileNameW(nullptr, path.data(), static_cast<DWORD>(path.size()));
+			if (length == 0) throw std::runtime_error("Could not find this program's executable.");
+			if (length < path.size()) return std::filesystem::path(std::wstring(path.data(), length));
+			path.resize(path.size() * 2);
+		}
+	}
+
+#else
+
+	// Pipes whose ends don't survive into other children, or those would keep each other's stdin open
+	void make_pipe(int ends[2], const std::string& command) {
+		if (pipe(ends) != 0) {
+			throw std::runtime_error("Could not create a pipe for: "s + command);
+		}
+		fcntl(ends[0], F_SETFD, FD_CLOEXEC);
+		fcntl(ends[1], F_SETFD, FD_CLOEXEC);
+	}
+
+	child_process::child_process(const std::string& command) : command_line(command) {
+		// A child that died would otherwise take this process with it, the moment anything was written to it
+		std::signal(SIGPIPE, SIG_IGN);
+
+		int to_child[2], from_child[2];
+		make_pipe(to_child, command);
+		try {
+			make_pipe(from_child, command);
+		} catch (...) {
+			::close(to_child[0]);
+			::close(to_child[1]);
+			throw;
+		}
+
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init(&actions);
+		posix_spawn_file_actions_adddup2(&actions, to_child[0], STDIN_FILENO);
+		posix_spawn_file_actions_adddup2(&actions, from_child[1], STDOUT_FILENO);
+		// In a process group of its own, so that terminate gets whatever the shell started too
+		posix_spawnattr_t attributes;
+		posix_spawnattr_init(&attributes);
+		posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+		posix_spawnattr_setpgroup(&attributes, 0);
+		const char* arguments[] = { "sh", "-c", command.c_str(), nullptr };
+		pid_t pid{};
+		const int error = posix_spawn(&pid, "/bin/sh", &actions, &attributes, const_cast<char* const*>(arguments), environ);
+		posix_spawnattr_destroy(&attributes);
+		posix_spawn_file_actions_destroy(&actions);
+		::close(to_child[0]);
+		::close(from_child[1]);
+		if (error != 0) {
+			::close(to_child[1]);
+			::close(from_child[0]);
+			throw std::runtime_error("Could not start " + command + ": " + std::strerror(error));
+		}
+		process = pid;
+		input = to_child[1];
+		output = from_child[0];
+	}
+
+	child_process::~child_process() noexcept {
+		close_input();
+		// A child that ignores its stdin closing, or is stuck on something else, gets a little while and then killed
+		int status = 0;
+		const auto deadline = std::chrono::steady_clock::now() + exit_grace_period;
+		pid_t exited = 0;
+		while ((exited = waitpid(process, &status, WNOHANG)) == 0 || (exited < 0 && errno == EINTR)) {
+			if (std::chrono::steady_clock::now() >= deadline) {
+				terminate();
+				while (waitpid(process, &status, 0) < 0 && errno == EINTR) {}
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		::close(output);
+	}
+
+	void child_process::write(const void* data, size_t size) {
+		auto bytes = static_cast<const char*>(data);
+		while (size > 0) {
+			const auto written = input < 0 ? -1 : ::write(input, bytes, size);
+			if (written < 0 && errno == EINTR) continue;
+			if (written <= 0) {
+				throw std::runtime_error("Lost the pipe to: "s + command_line);
+			}
+			bytes += written;
+			size -= static_cast<size_t>(written);
+		}
+	}
+
+	void child_process::read(void* data, size_t size) {
+		auto bytes = static_cast<char*>(data);
+		while (size > 0) {
+			const auto read = ::read(output, bytes, size);
+			if (read < 0 && errno == EINTR) continue;
+			if (read <= 0) {
+				throw std::runtime_error("Lost the pipe from: "s + command_line);
+			}
+			bytes += read;
+			size -= static_cast<size_t>(read);
+		}
+	}
+
+	void child_process::close_input() noexcept {
+		if (input >= 0) ::close(input);
+		input = -1;
+	}
+
+	void child_process::terminate() noexcept {
+		kill(-process, SIGKILL);
+	}
+
+	std::filesystem::path current_executable() {
+#ifdef __APPLE__
+		std::uint32_t size = 0;
+		_NSGetExecutablePath(nullptr, &size);
+		std::vector<char> path(size);
+		if (_NSGetExecutablePath(path.data(), &size) != 0) {
+			throw std::runtime_error("Could not find this program's executable.");
+		}
+		return std::filesystem::canonical(path.data());
+#else
+		return std::filesystem::read_symlink("/proc/self/exe");
+#endif
+	}
+
+#endif
+}
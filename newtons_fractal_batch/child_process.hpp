@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <cstddef>
+#include <filesystem>
+
+namespace euleristic {
+
+	// A process started from a command line, with pipes to its stdin and from its stdout. Its stderr is this process's,
+	// so whatever it complains about shows up. On Windows the command is run as it is, elsewhere by /bin/sh, so it may
+	// be anything the shell runs, like ssh to another host.
+	class child_process {
+	public:
+		explicit child_process(const std::string& command);
+		// Waits for the process to exit, after closing its stdin, which is its cue to. One that hasn't after
+		// exit_grace_period is terminated.
+		~child_process() noexcept;
+		child_process(const child_process&) = delete;
+		child_process& operator=(const child_process&) = delete;
+
+		// Both throw std::runtime_error once the process has gone away or the pipe broke. read only returns once all of
+		// size has arrived.
+		void write(const void* data, size_t size);
+		void read(void* data, size_t size);
+		// Tells the process there's nothing more coming
+		void close_input() noexcept;
+		// For a process that stopped responding. Any read waiting on it fails.
+		void terminate() noexcept;
+
+		const std::string& command() const noexcept { return command_line; }
+
+	private:
+		std::string command_line;
+#ifdef _WIN32
+		void* process{};
+		void* input{};
+		void* output{};
+#else
+		int process{ -1 };
+		int input{ -1 };
+		int output{ -1 };
+#endif
+	};
+
+	constexpr std::chrono::milliseconds exit_grace_period{ 5000 };
+
+	// The path of this program's executable, for starting more of itself
+	std::filesystem::path current_executable();
+}
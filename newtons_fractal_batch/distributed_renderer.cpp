@@ -0,0 +1,576 @@
+#include "distributed_renderer.hpp"
+
+#include <bit>
+#include <array>
+#include <format>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace euleristic {
+
+	// The protocol. Every message is a type byte and the length of what follows as 8 bytes, then the fields, all
+	// little-endian:
+	//
+	//   H  worker to coordinator, once at the start: "NFWORKER", version, thread count, instruction set (4 bytes each)
+	//   S  coordinator to worker: frame number, width, image height, tile size, subdivide, precision, evaluation,
+	//      method, early exit, iteration count (4 bytes each from subdivide on), epsilon squared, step squared, the 9
+	//      entries of screen_to_fractal_space column by column, translation_low, then the zeros and the coefficients,
+	//      each as a count and that many real and imaginary parts
+	//   B  coordinator to worker: frame number, first row, row count. Only ever for the last frame sent.
+	//   P  worker to coordinator, for each band in the order they came: frame number, first row, row count, pixels
+	//      iterated, seconds spent rendering, precision (4 bytes), then the band's RGBA pixels
+	//   E  worker to coordinator: what went wrong, as text, after which the worker exits
+	//
+	// The coordinator closing the worker's stdin is what tells it to exit.
+	constexpr std::array<char, 8> worker_magic = { 'N', 'F', 'W', 'O', 'R', 'K', 'E', 'R' };
+	constexpr std::uint32_t protocol_version = 2;
+	constexpr size_t message_header_size = 9;
+	// Bands out with a worker at a time
+	constexpr size_t bands_in_flight = 2;
+
+	class message {
+		std::vector<std::uint8_t> bytes;
+
+	public:
+		explicit message(char type) : bytes(message_header_size) {
+			bytes[0] = static_cast<std::uint8_t>(type);
+		}
+		void put(std::uint64_t value, int size = 8) {
+			for (int byte = 0; byte < size; ++byte) {
+				bytes.push_back(static_cast<std::uint8_t>(value >> (8 * byte)));
+			}
+		}
+		void put(double value) {
+			put(std::bit_cast<std::uint64_t>(value));
+		}
+		void put(std::complex<double> value) {
+			put(value.real());
+			put(value.imag());
+		}
+		void put(const void* data, size_t size) {
+			bytes.insert(bytes.end(), static_cast<const std::uint8_t*>(data), static_cast<const std::uint8_t*>(data) + size);
+		}
+		// Fills in the length
+		std::vector<std::uint8_t>& finish() noexcept {
+			const std::uint64_t length = bytes.size() - message_header_size;
+			for (int byte = 0; byte < 8; ++byte) {
+				bytes[1 + byte] = static_cast<std::uint8_t>(length >> (8 * byte));
+			}
+			return bytes;
+		}
+	};
+
+	// Reads the fields of a message's body in order, throwing if there are fewer than asked for
+	class message_reader {
+		const std::uint8_t* at;
+		const std::uint8_t* end;
+
+	public:
+		explicit message_reader(const std::vector<std::uint8_t>& body) : at(body.data()), end(body.data() + body.size()) {}
+
+		const std::uint8_t* take(size_t size) {
+			if (static_cast<size_t>(end - at) < size) {
+				throw std::runtime_error("A worker message was shorter than its fields.");
+			}
+			const auto taken = at;
+			at += size;
+			return taken;
+		}
+		std::uint64_t integer(int size = 8) {
+			const auto bytes = take(size);
+			std::uint64_t value = 0;
+			for (int byte = 0; byte < size; ++byte) {
+				value |= static_cast<std::uint64_t>(bytes[byte]) << (8 * byte);
+			}
+			return value;
+		}
+		double real() {
+			return std::bit_cast<double>(integer());
+		}
+		std::complex<double> complex() {
+			const double re = real();
+			return { re, real() };
+		}
+		std::string text() {
+			const auto size = static_cast<size_t>(end - at);
+			return std::string(reinterpret_cast<const char*>(take(size)), size);
+		}
+	};
+
+	double worker_statistics::megapixels_per_second() const noexcept {
+		return rendering.count() > 0.0 ? static_cast<double>(pixels) / rendering.count() * 1e-6 : 0.0;
+	}
+
+	double distributed_statistics::megapixels_per_second() const noexcept {
+		return elapsed.count() > 0.0 ? static_cast<double>(pixel_count) / elapsed.count() * 1e-6 : 0.0;
+	}
+
+	// Scenes
+
+	std::vector<std::uint8_t> scene_to_message(std::uint64_t frame, const fractal_scene& scene, size_t width, size_t height,
+		const distributed_settings& settings) {
+		message scene_message('S');
+		scene_message.put(frame);
+		scene_message.put(std::uint64_t{ width });
+		scene_message.put(std::uint64_t{ height });
+		scene_message.put(std::uint64_t{ settings.tile_size });
+		scene_message.put(std::uint64_t{ settings.subdivide }, 4);
+		scene_message.put(static_cast<std::uint64_t>(scene.precision), 4);
+		scene_message.put(static_cast<std::uint64_t>(scene.evaluation), 4);
+		scene_message.put(static_cast<std::uint64_t>(scene.method), 4);
+		scene_message.put(std::uint64_t{ scene.early_exit }, 4);
+		scene_message.put(std::uint64_t{ scene.iteration_count }, 4);
+		scene_message.put(scene.epsilon_squared);
+		scene_message.put(scene.step_squared);
+		for (int column = 0; column < 3; ++column) {
+			for (int row = 0; row < 3; ++row) {
+				scene_message.put(scene.screen_to_fractal_space[column][row]);
+			}
+		}
+		scene_message.put(scene.translation_low.x);
+		scene_message.put(scene.translation_low.y);
+		scene_message.put(std::uint64_t{ scene.zeros.size() });
+		for (const auto& zero : scene.zeros) scene_message.put(zero);
+		scene_message.put(std::uint64_t{ scene.coefficients.size() });
+		for (const auto& coefficient : scene.coefficients) scene_message.put(coefficient);
+		return std::move(scene_message.finish());
+	}
+
+	// The coordinator
+
+	distributed_renderer::distributed_renderer(const std::vector<std::string>& worker_commands, distributed_settings settings)
+		: settings(settings), workers(worker_commands.size()) {
+		if (worker_commands.empty()) {
+			throw std::invalid_argument("Distributed rendering needs at least one worker.");
+		}
+		if (settings.tile_size == 0) {
+			throw std::invalid_argument("Tile size must be positive.");
+		}
+		this->settings.max_attempts = std::max(this->settings.max_attempts, 1u);
+
+		// All the processes are started before any thread, which keeps the pipes of one out of the others
+		for (size_t i = 0; i < workers.size(); ++i) {
+			workers[i].statistics.command = worker_commands[i];
+			workers[i].started = std::chrono::steady_clock::now();
+			workers[i].process = std::make_unique<child_process>(worker_commands[i]);
+		}
+		for (auto& self : workers) {
+			self.thread = std::thread([this, &self] { serve(self); });
+		}
+	}
+
+	distributed_renderer::~distributed_renderer() noexcept {
+		{
+			std::unique_lock lock(mutex);
+			shutting_down = true;
+			// Anything still waiting for a band is stuck on one that was stolen from it, and won't be missed, and
+			// anything that hasn't introduced itself yet never will be
+			for (auto& self : workers) {
+				if (!self.finished && (!self.outstanding.empty() || !self.introduced)) self.process->terminate();
+			}
+			changed.notify_all();
+			// The rest should be done the moment they see shutting_down, unless they are stuck writing to a worker
+			// that stopped reading
+			changed.wait_for(lock, std::chrono::seconds(2), [&] { return std::ranges::all_of(workers, &worker::finished); });
+			for (auto& self : workers) {
+				if (!self.finished) self.process->terminate();
+			}
+		}
+		for (auto& self : workers) {
+			self.thread.join();
+		}
+	}
+
+	std::vector<worker_statistics> distributed_renderer::statistics() const {
+		std::lock_guard lock(mutex);
+		std::vector<worker_statistics> result;
+		for (const auto& self : workers) {
+			result.push_back(self.statistics);
+		}
+		return result;
+	}
+
+	distributed_statistics distributed_renderer::render(const fractal_scene& scene, image& frame_target) {
+		if (frame_target.pixels.size() != frame_target.width * frame_target.height) {
+			throw std::invalid_argument("The target image's pixel count doesn't match its dimensions.");
+		}
+		const auto start = std::chrono::steady_clock::now();
+
+		std::unique_lock lock(mutex);
+		// The first frame waits for the first worker to be ready, and the others join in as they introduce themselves
+		wait_until(lock, [&] {
+			return std::ranges::any_of(workers, &worker::ready) || std::ranges::none_of(workers, &worker::alive);
+		});
+		const size_t alive = static_cast<size_t>(std::ranges::count_if(workers, &worker::ready));
+		if (alive == 0) {
+			// Losing the last of them said why
+			if (error) std::rethrow_exception(error);
+			throw std::runtime_error("All the workers have failed.");
+		}
+
+		// Enough bands to go around a few times, so that the last ones to finish are small
+		size_t band_rows = settings.band_rows;
+		if (band_rows == 0) {
+			band_rows = (frame_target.height + 8 * alive - 1) / (8 * alive);
+		}
+		band_rows = std::max<size_t>(1, (band_rows + settings.tile_size - 1) / settings.tile_size) * settings.tile_size;
+
+		++frame;
+		frame_active = true;
+		target = &frame_target;
+		scene_message = std::make_shared<const std::vector<std::uint8_t>>(
+			scene_to_message(frame, scene, frame_target.width, frame_target.height, settings));
+		bands.clear();
+		queued.clear();
+		for (size_t first_row = 0; first_row < frame_target.height; first_row += band_rows) {
+			queued.push_back(bands.size());
+			bands.push_back({ first_row, std::min(band_rows, frame_target.height - first_row), 0, 0, false, {} });
+		}
+		remaining = bands.size();
+		error = nullptr;
+		frame_statistics = {};
+		frame_statistics.pixel_count = frame_target.width * frame_target.height;
+		frame_statistics.band_count = bands.size();
+		frame_statistics.worker_count = alive;
+		changed.notify_all();
+
+		wait_until(lock, [&] { return remaining == 0 || error; });
+		frame_active = false;
+		target = nullptr;
+		if (error) {
+			std::rethrow_exception(error);
+		}
+		frame_statistics.worker_count = std::max(alive, static_cast<size_t>(std::ranges::count_if(workers, &worker::ready)));
+		frame_statistics.elapsed = std::chrono::steady_clock::now() - start;
+		return frame_statistics;
+	}
+
+	std::optional<size_t> distributed_renderer::next_band(worker& self) {
+		const auto now = std::chrono::steady_clock::now();
+		const auto has = [&](size_t index) {
+			return std::ranges::any_of(self.outstanding, [&](const sent_band& sent) { return sent.frame == frame && sent.band == index; });
+		};
+		const auto hand_out = [&](size_t index) {
+			auto& stolen = bands[index];
+			if (stolen.copies == 0) stolen.sent = now;
+			else ++frame_statistics.stolen_bands;
+			++stolen.copies;
+			return index;
+		};
+
+		// Overdue bands first: whoever has them may have hung, or be far slower than the rest
+		auto timeout = settings.band_timeout;
+		if (timeout.count() <= 0.0 && bands_timed > 0) {
+			timeout = std::max(4.0 * band_time / static_cast<double>(bands_timed), std::chrono::duration<double>(0.25));
+		}
+		if (timeout.count() > 0.0) {
+			for (size_t index = 0; index < bands.size(); ++index) {
+				const auto& candidate = bands[index];
+				if (!candidate.done && candidate.copies == 1 && now - candidate.sent > timeout && !has(index)) {
+					return hand_out(index);
+				}
+			}
+		}
+
+		if (!queued.empty()) {
+			const size_t index = queued.front();
+			queued.pop_front();
+			return hand_out(index);
+		}
+
+		// The tail: rather than sit idle while the others finish, take over the band that has been out the longest
+		if (!self.outstanding.empty()) return std::nullopt;
+		std::optional<size_t> oldest;
+		for (size_t index = 0; index < bands.size(); ++index) {
+			const auto& candidate = bands[index];
+			if (!candidate.done && candidate.copies == 1 && !has(index) && (!oldest || candidate.sent < bands[*oldest].sent)) {
+				oldest = index;
+			}
+		}
+		if (oldest) return hand_out(*oldest);
+		return std::nullopt;
+	}
+
+	template<typename predicate>
+	void distributed_renderer::wait_until(std::unique_lock<std::mutex>& lock, predicate done) {
+		while (!done()) {
+			changed.wait_for(lock, std::chrono::milliseconds(50));
+			give_up_on_silent_workers();
+		}
+	}
+
+	void distributed_renderer::give_up_on_silent_workers() {
+		const auto now = std::chrono::steady_clock::now();
+		for (auto& self : workers) {
+			if (self.alive && !self.introduced && now - self.started > settings.handshake_timeout) {
+				lose(self, std::format("It didn't introduce itself within {} s.", settings.handshake_timeout.count()));
+				self.process->terminate();
+			}
+		}
+	}
+
+	void distributed_renderer::lose(worker& self, const std::string& reason) {
+		// Already given up on, and this is its thread noticing
+		if (!self.alive) return;
+		self.alive = false;
+		self.statistics.failure = reason;
+		self.statistics.lost_bands += self.outstanding.size();
+		for (const auto& sent : self.outstanding) {
+			if (!frame_active || sent.frame != frame) continue;
+			auto& lost = bands[sent.band];
+			--lost.copies;
+			if (lost.done || lost.copies > 0) continue;
+			if (++lost.attempts >= settings.max_attempts) {
+				if (!error) {
+					error = std::make_exception_ptr(std::runtime_error(std::format("Rows {} to {} failed on {} workers, the last time "
+						"because: {}", lost.first_row, lost.first_row + lost.rows - 1, lost.attempts, reason)));
+				}
+				continue;
+			}
+			queued.push_front(sent.band);
+			++frame_statistics.retried_bands;
+		}
+		self.outstanding.clear();
+		if (std::ranges::none_of(workers, &worker::alive) && !error) {
+			error = std::make_exception_ptr(std::runtime_error("All the workers have failed, the last because: " + reason));
+		}
+		changed.notify_all();
+	}
+
+	void distributed_renderer::serve(worker& self) {
+		std::vector<std::uint8_t> header(message_header_size), body;
+		const auto receive = [&] {
+			self.process->read(header.data(), header.size());
+			std::uint64_t length = 0;
+			for (int byte = 0; byte < 8; ++byte) {
+				length |= static_cast<std::uint64_t>(header[1 + byte]) << (8 * byte);
+			}
+			body.resize(length);
+			self.process->read(body.data(), body.size());
+			if (header[0] == 'E') {
+				throw std::runtime_error(message_reader(body).text());
+			}
+			return static_cast<char>(header[0]);
+		};
+
+		std::unique_lock lock(mutex, std::defer_lock);
+		try {
+			if (receive() != 'H') {
+				throw std::runtime_error("It didn't introduce itself as a worker.");
+			}
+			message_reader hello(body);
+			if (std::memcmp(hello.take(worker_magic.size()), worker_magic.data(), worker_magic.size()) != 0) {
+				throw std::runtime_error("It didn't introduce itself as a worker.");
+			}
+			if (const auto version = hello.integer(4); version != protocol_version) {
+				throw std::runtime_error(std::format("It speaks version {} of the protocol, not {}.", version, protocol_version));
+			}
+			lock.lock();
+			if (!self.alive) {
+				throw std::runtime_error("It introduced itself after it was given up on.");
+			}
+			self.statistics.thread_count = static_cast<unsigned>(hello.integer(4));
+			self.statistics.isa = static_cast<instruction_set>(hello.integer(4));
+			self.introduced = true;
+			changed.notify_all();
+
+			while (true) {
+				// Top up the bands out with the worker. A new scene only goes once the last frame's bands are back,
+				// since the worker could be stuck writing one while this is stuck writing a long scene.
+				while (!shutting_down && frame_active) {
+					if (self.frame != frame) {
+						if (!self.outstanding.empty()) break;
+						const auto scene = scene_message;
+						self.frame = frame;
+						lock.unlock();
+						self.process->write(scene->data(), scene->size());
+						lock.lock();
+						continue;
+					}
+					if (self.outstanding.size() >= bands_in_flight) break;
+					const auto index = next_band(self);
+					if (!index) break;
+					self.outstanding.push_back({ frame, *index, std::chrono::steady_clock::now() });
+					message request('B');
+					request.put(frame);
+					request.put(std::uint64_t{ bands[*index].first_row });
+					request.put(std::uint64_t{ bands[*index].rows });
+					lock.unlock();
+					const auto& bytes = request.finish();
+					self.process->write(bytes.data(), bytes.size());
+					lock.lock();
+				}
+				if (self.outstanding.empty()) {
+					if (shutting_down) break;
+					// Timed, so that an idle worker gets to see bands becoming overdue
+					changed.wait_for(lock, std::chrono::milliseconds(50));
+					continue;
+				}
+
+				lock.unlock();
+				if (receive() != 'P') {
+					throw std::runtime_error("It answered a band with something else.");
+				}
+				lock.lock();
+
+				const auto sent = self.outstanding.front();
+				message_reader reply(body);
+				const auto reply_frame = reply.integer();
+				const auto first_row = reply.integer();
+				const auto rows = reply.integer();
+				const auto evaluated = reply.integer();
+				const std::chrono::duration<double> rendering(reply.real());
+				const auto precision = static_cast<precision_mode>(reply.integer(4));
+				if (reply_frame != sent.frame || (sent.frame == frame && (first_row != bands[sent.band].first_row || rows != bands[sent.band].rows))) {
+					throw std::runtime_error("It answered with a band it wasn't asked for.");
+				}
+				self.outstanding.pop_front();
+				self.statistics.rendering += rendering;
+				self.statistics.round_trip += std::chrono::steady_clock::now() - sent.time;
+
+				if (!frame_active || sent.frame != frame || bands[sent.band].done) {
+					++self.statistics.duplicates;
+					if (frame_active && sent.frame == frame) --bands[sent.band].copies;
+					continue;
+				}
+				auto& finished = bands[sent.band];
+				const size_t row_bytes = target->width * sizeof(glm::u8vec4);
+				const auto pixels = reply.take(finished.rows * row_bytes);
+				std::memcpy(target->pixels.data() + finished.first_row * target->width, pixels, finished.rows * row_bytes);
+				finished.done = true;
+				--finished.copies;
+				band_time += std::chrono::steady_clock::now() - finished.sent;
+				++bands_timed;
+				++self.statistics.bands;
+				self.statistics.pixels += finished.rows * target->width;
+				frame_statistics.evaluated_pixels += evaluated;
+				frame_statistics.precision = precision;
+				if (--remaining == 0) {
+					changed.notify_all();
+				}
+			}
+		} catch (const std::exception& failure) {
+			if (!lock.owns_lock()) lock.lock();
+			lose(self, failure.what());
+		}
+		if (lock.owns_lock()) lock.unlock();
+		self.process->close_input();
+		lock.lock();
+		self.finished = true;
+		changed.notify_all();
+	}
+
+	// The worker
+
+	void write_message(std::ostream& output, message& contents) {
+		const auto& bytes = contents.finish();
+		output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		output.flush();
+		if (!output) {
+			throw std::runtime_error("Could not write to the coordinator.");
+		}
+	}
+
+	void serve_bands(std::istream& input, std::ostream& output, unsigned thread_count, std::optional<instruction_set> isa) {
+		const auto chosen_isa = isa.value_or(best_supported_instruction_set());
+		std::optional<cpu_renderer> renderer;
+		renderer.emplace(thread_count, 32, chosen_isa);
+		size_t tile_size = 32;
+
+		message hello('H');
+		hello.put(worker_magic.data(), worker_magic.size());
+		hello.put(std::uint64_t{ protocol_version }, 4);
+		hello.put(std::uint64_t{ renderer->thread_count() }, 4);
+		hello.put(static_cast<std::uint64_t>(chosen_isa), 4);
+		write_message(output, hello);
+
+		fractal_scene scene;
+		std::uint64_t frame{};
+		bool has_scene = false;
+		size_t width{}, height{};
+		image band;
+		std::vector<std::uint8_t> header(message_header_size), body;
+		try {
+			while (input.read(reinterpret_cast<char*>(header.data()), header.size())) {
+				std::uint64_t length = 0;
+				for (int byte = 0; byte < 8; ++byte) {
+					length |= static_cast<std::uint64_t>(header[1 + byte]) << (8 * byte);
+				}
+				body.resize(length);
+				if (!input.read(reinterpret_cast<char*>(body.data()), static_cast<std::streamsize>(body.size()))) {
+					throw std::runtime_error("The coordinator's message was cut short.");
+				}
+				message_reader request(body);
+
+				if (header[0] == 'S') {
+					frame = request.integer();
+					width = request.integer();
+					height = request.integer();
+					const auto tiles = request.integer();
+					const bool subdivide = request.integer(4) != 0;
+					if (tiles != tile_size) {
+						renderer.reset();
+						renderer.emplace(thread_count, tiles, chosen_isa);
+						tile_size = tiles;
+					}
+					renderer->subdivide = subdivide;
+					scene.precision = static_cast<precision_mode>(request.integer(4));
+					scene.evaluation = static_cast<evaluation_mode>(request.integer(4));
+					scene.method = static_cast<iteration_method>(request.integer(4));
+					scene.early_exit = request.integer(4) != 0;
+					scene.iteration_count = static_cast<unsigned>(request.integer(4));
+					scene.epsilon_squared = request.real();
+					scene.step_squared = request.real();
+					for (int column = 0; column < 3; ++column) {
+						for (int row = 0; row < 3; ++row) {
+							scene.screen_to_fractal_space[column][row] = request.real();
+						}
+					}
+					scene.translation_low.x = request.real();
+					scene.translation_low.y = request.real();
+					scene.zeros.resize(request.integer());
+					for (auto& zero : scene.zeros) zero = request.complex();
+					scene.coefficients.resize(request.integer());
+					for (auto& coefficient : scene.coefficients) coefficient = request.complex();
+					has_scene = true;
+				}
+				else if (header[0] == 'B') {
+					const auto band_frame = request.integer();
+					const auto first_row = request.integer();
+					const auto rows = request.integer();
+					if (!has_scene || band_frame != frame) {
+						throw std::runtime_error("Asked for a band of a frame it wasn't sent.");
+					}
+					if (band.width != width || band.height != rows) {
+						band = image(width, rows);
+					}
+					const auto statistics = renderer->render_rows(scene, band, first_row, height);
+
+					message reply('P');
+					reply.put(frame);
+					reply.put(first_row);
+					reply.put(rows);
+					reply.put(std::uint64_t{ statistics.evaluated_pixels });
+					reply.put(statistics.elapsed.count());
+					reply.put(static_cast<std::uint64_t>(statistics.precision), 4);
+					reply.put(band.pixels.data(), band.pixels.size() * sizeof(glm::u8vec4));
+					write_message(output, reply);
+				}
+				else {
+					throw std::runtime_error(std::format("Unknown message type {}.", static_cast<int>(header[0])));
+				}
+			}
+		} catch (const std::exception& failure) {
+			message report('E');
+			const std::string what = failure.what();
+			report.put(what.data(), what.size());
+			const auto& bytes = report.finish();
+			output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+			output.flush();
+			throw;
+		}
+	}
+}
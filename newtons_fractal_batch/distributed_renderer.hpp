@@ -0,0 +1,157 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <optional>
+#include <exception>
+#include <condition_variable>
+
+#include "cpu_renderer.hpp"
+#include "child_process.hpp"
+
+namespace euleristic {
+
+	struct distributed_settings {
+		// Rows per band handed to a worker, rounded up to a multiple of the tile size. 0 for about 8 bands per worker.
+		size_t band_rows = 0;
+		// A band that hasn't come back after this long is handed to another worker as well, whichever finishes first
+		// winning. 0 for four times the mean a band has taken so far.
+		std::chrono::duration<double> band_timeout{};
+		// How many workers a band may be lost with, when they fail or exit, before the render gives up on it
+		unsigned max_attempts = 3;
+		// The workers render their bands in tiles of this size, like cpu_renderer, with or without subdivision
+		size_t tile_size = 32;
+		bool subdivide = true;
+		// A worker that hasn't introduced itself after this long is given up on, like an ssh waiting on a password or
+		// a host that is down
+		std::chrono::duration<double> handshake_timeout{ 30.0 };
+	};
+
+	// Summed over every frame a worker took part in
+	struct worker_statistics {
+		std::string command;
+		// As the worker reported it when it started
+		unsigned thread_count{};
+		instruction_set isa{};
+		// Bands whose pixels made it into a frame, and those that came back after another worker's copy already had
+		size_t bands{}, duplicates{};
+		size_t pixels{};
+		// Bands that were out with the worker when it failed, and why it did
+		size_t lost_bands{};
+		std::string failure;
+		// Spent rendering, as the worker measured it, and from sending a band to having its pixels back
+		std::chrono::duration<double> rendering{}, round_trip{};
+
+		bool failed() const noexcept { return !failure.empty(); }
+		double megapixels_per_second() const noexcept;
+	};
+
+	struct distributed_statistics {
+		size_t pixel_count{};
+		size_t evaluated_pixels{};
+		size_t band_count{};
+		// Bands handed out again after their worker failed
+		size_t retried_bands{};
+		// Bands handed to a second worker while the first still had them, because they were overdue or because the
+		// second had nothing else left to do
+		size_t stolen_bands{};
+		size_t worker_count{};
+		precision_mode precision{};
+		std::chrono::duration<double> elapsed{};
+
+		double megapixels_per_second() const noexcept;
+	};
+
+	// Renders frames across worker processes, each rendering bands of rows of the frame with its own cpu_renderer.
+	// The workers may be anything that speaks the protocol on their stdin and stdout, like newtons_fractal_batch
+	// --worker on this machine or, through ssh, on another. Bands are cut at multiples of the tile size and rendered
+	// with cpu_renderer::render_rows, so the frame comes out the same as rendering it in one process would.
+	//
+	// Each worker gets a thread here, which keeps two bands out with it at a time, so that the next one is already
+	// waiting when it finishes one. A worker that fails or exits has its bands handed out again to the others. Once
+	// there are no bands left to hand out, a worker that runs out steals the band that has been out the longest, and
+	// a band that is overdue is handed to another worker even before that. Whichever copy comes back first is used.
+	class distributed_renderer {
+	public:
+		explicit distributed_renderer(const std::vector<std::string>& worker_commands, distributed_settings settings = {});
+		~distributed_renderer() noexcept;
+		distributed_renderer(const distributed_renderer&) = delete;
+		distributed_renderer& operator=(const distributed_renderer&) = delete;
+
+		// Throws std::runtime_error if all the workers failed, or a band failed on max_attempts of them
+		distributed_statistics render(const fractal_scene& scene, image& target);
+		std::vector<worker_statistics> statistics() const;
+
+	private:
+		// A band out with a worker, in the order they were sent, which is the order the worker answers in
+		struct sent_band {
+			std::uint64_t frame{};
+			size_t band{};
+			std::chrono::steady_clock::time_point time;
+		};
+		struct worker {
+			std::unique_ptr<child_process> process;
+			std::thread thread;
+			std::chrono::steady_clock::time_point started;
+			std::deque<sent_band> outstanding;
+			std::uint64_t frame{};
+			// Only workers that have introduced themselves are counted on, and one that fails is never again
+			bool introduced{}, alive = true;
+			// Its thread is done with it
+			bool finished{};
+			worker_statistics statistics;
+
+			bool ready() const noexcept { return introduced && alive; }
+		};
+		struct band {
+			size_t first_row{}, rows{};
+			// How many workers have it right now, and how many it was lost with
+			unsigned copies{}, attempts{};
+			bool done{};
+			std::chrono::steady_clock::time_point sent;
+		};
+
+		distributed_settings settings;
+		mutable std::mutex mutex;
+		// Signalled whenever there's something new for a worker thread to do, or a frame finished or failed
+		std::condition_variable changed;
+		std::vector<worker> workers;
+		bool shutting_down{};
+
+		// The frame being rendered
+		std::uint64_t frame{};
+		bool frame_active{};
+		std::shared_ptr<const std::vector<std::uint8_t>> scene_message;
+		image* target{};
+		std::vector<band> bands;
+		std::deque<size_t> queued;
+		size_t remaining{};
+		std::exception_ptr error;
+		distributed_statistics frame_statistics;
+		// Over all frames, for telling when a band is overdue
+		std::chrono::duration<double> band_time{};
+		size_t bands_timed{};
+
+		void serve(worker& self);
+		std::optional<size_t> next_band(worker& self);
+		void lose(worker& self, const std::string& reason);
+		// Gives up on the workers that are past the handshake deadline. Their threads are stuck reading, so their
+		// processes are terminated to get them out of it.
+		void give_up_on_silent_workers();
+		// Waits on changed until done says so, giving up on silent workers as it goes
+		template<typename predicate>
+		void wait_until(std::unique_lock<std::mutex>& lock, predicate done);
+	};
+
+	// The other end of a distributed_renderer: reads scenes and bands from input and writes their pixels to output,
+	// until input ends. Any error is sent back to the coordinator before it is thrown.
+	void serve_bands(std::istream& input, std::ostream& output, unsigned thread_count, std::optional<instruction_set> isa);
+}
@@ -0,0 +1,141 @@
+#include "frame_pipeline.hpp"
+#include "bounded_queue.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <exception>
+
+namespace euleristic {
+
+	double stage_statistics::occupancy(std::chrono::duration<double> elapsed) const noexcept {
+		return elapsed.count() > 0.0 ? busy / (elapsed * thread_count) : 0.0;
+	}
+
+	double stage_statistics::starved_share(std::chrono::duration<double> elapsed) const noexcept {
+		return elapsed.count() > 0.0 ? starved / (elapsed * thread_count) : 0.0;
+	}
+
+	double stage_statistics::blocked_share(std::chrono::duration<double> elapsed) const noexcept {
+		return elapsed.count() > 0.0 ? blocked / (elapsed * thread_count) : 0.0;
+	}
+
+	double pipeline_statistics::frames_per_second() const noexcept {
+		return elapsed.count() > 0.0 ? static_cast<double>(frame_count) / elapsed.count() : 0.0;
+	}
+
+	pipeline_statistics run_frame_pipeline(size_t frame_count, const pipeline_settings& settings,
+		const std::function<batch_job(size_t frame_index)>& job_at,
+		const std::function<void(size_t frame_index, const batch_job& job, const fractal_scene& scene, image& target)>& render,
+		const std::function<void(size_t frame_index, const batch_job& job, const image& frame)>& encode) {
+		using clock = std::chrono::steady_clock;
+
+		struct prepared_frame {
+			size_t index;
+			batch_job job;
+			fractal_scene scene;
+		};
+		struct rendered_frame {
+			size_t index;
+			batch_job job;
+			image* frame;
+		};
+
+		const unsigned encoder_count = std::max(1u, settings.encoder_count);
+		bounded_queue<prepared_frame> prepared(settings.queue_depth);
+		bounded_queue<rendered_frame> rendered(settings.queue_depth);
+		// Enough images for one being rendered, a full queue and one in every encoder, and no more
+		std::vector<image> images(settings.queue_depth + encoder_count + 1);
+		bounded_queue<image*> free_images(images.size());
+		for (auto& each : images) free_images.push(&each);
+
+		pipeline_statistics statistics;
+		statistics.stages = { { { "prepare", 1 }, { "render", 1 }, { "encode", encoder_count } } };
+		std::mutex statistics_mutex;
+
+		std::exception_ptr first_error;
+		std::mutex error_mutex;
+		const auto stop = [&](std::exception_ptr error) {
+			{
+				std::lock_guard lock(error_mutex);
+				if (!first_error) first_error = error;
+			}
+			prepared.close();
+			rendered.close();
+			free_images.close();
+		};
+
+		// Times a call into the given share of a stage's time
+		const auto timed = [](std::chrono::duration<double>& total, auto&& call) {
+			const auto start = clock::now();
+			auto result = call();
+			total += clock::now() - start;
+			return result;
+		};
+
+		const auto start = clock::now();
+		{
+			std::vector<std::jthread> threads;
+
+			threads.emplace_back([&] {
+				auto& stage = statistics.stages[0];
+				try {
+					for (size_t i = 0; i < frame_count; ++i) {
+						auto frame = timed(stage.busy, [&] {
+							auto job = job_at(i);
+							auto scene = job.scene();
+							return prepared_frame{ i, std::move(job), std::move(scene) };
+						});
+						if (!timed(stage.blocked, [&] { return prepared.push(std::move(frame)); })) return;
+					}
+					prepared.close();
+				} catch (...) {
+					stop(std::current_exception());
+				}
+			});
+
+			threads.emplace_back([&] {
+				auto& stage = statistics.stages[1];
+				try {
+					while (true) {
+						auto frame = timed(stage.starved, [&] { return prepared.pop(); });
+						if (!frame) break;
+						const auto target = timed(stage.blocked, [&] { return free_images.pop(); });
+						if (!target) return;
+						timed(stage.busy, [&] { render(frame->index, frame->job, frame->scene, **target); return 0; });
+						if (!timed(stage.blocked, [&] { return rendered.push({ frame->index, std::move(frame->job), *target }); })) return;
+					}
+					rendered.close();
+				} catch (...) {
+					stop(std::current_exception());
+				}
+			});
+
+			for (unsigned encoder = 0; encoder < encoder_count; ++encoder) {
+				threads.emplace_back([&] {
+					stage_statistics stage;
+					try {
+						while (true) {
+							auto frame = timed(stage.starved, [&] { return rendered.pop(); });
+							if (!frame) break;
+							timed(stage.busy, [&] { encode(frame->index, frame->job, *frame->frame); return 0; });
+							free_images.push(frame->frame);
+						}
+					} catch (...) {
+						stop(std::current_exception());
+					}
+					std::lock_guard lock(statistics_mutex);
+					statistics.stages[2].busy += stage.busy;
+					statistics.stages[2].starved += stage.starved;
+				});
+			}
+		}
+		statistics.elapsed = clock::now() - start;
+
+		if (first_error) std::rethrow_exception(first_error);
+		statistics.frame_count = frame_count;
+		statistics.mean_queue_lengths = { prepared.mean_length(), rendered.mean_length() };
+		return statistics;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <functional>
+
+#include "batch_job.hpp"
+
+namespace euleristic {
+
+	struct pipeline_settings {
+		// The most frames that may wait between two stages
+		size_t queue_depth = 4;
+		// Threads encoding and writing frames. Frames may be written out of order with more than one, so frames going to
+		// a stream need exactly one.
+		unsigned encoder_count = 1;
+	};
+
+	struct stage_statistics {
+		const char* name{};
+		unsigned thread_count{};
+		// Summed over the stage's threads: working, waiting for a frame from the stage before, and waiting for room in
+		// the queue to the stage after (or, for rendering, for an image to render into)
+		std::chrono::duration<double> busy{}, starved{}, blocked{};
+
+		// Each as a share of the stage's thread time, in [0, 1]
+		double occupancy(std::chrono::duration<double> elapsed) const noexcept;
+		double starved_share(std::chrono::duration<double> elapsed) const noexcept;
+		double blocked_share(std::chrono::duration<double> elapsed) const noexcept;
+	};
+
+	struct pipeline_statistics {
+		size_t frame_count{};
+		std::chrono::duration<double> elapsed{};
+		// Prepare, render and encode
+		std::array<stage_statistics, 3> stages{};
+		// How many frames waited for rendering and for encoding, on average
+		std::array<double, 2> mean_queue_lengths{};
+
+		double frames_per_second() const noexcept;
+	};
+
+	// Runs the frames through three stages on threads of their own, connected by bounded queues. Preparing a frame
+	// builds its job with job_at and expands its coefficients, rendering calls render with an image to render into,
+	// and encoding calls encode to write the image out. So while one frame renders, the next ones are prepared and
+	// the previous ones written, and the renderer never waits on the disk. A slow stage can't pile frames up in memory:
+	// at most queue_depth frames wait between two stages, and the images are recycled once they're written.
+	//
+	// render is only ever called from one thread, since cpu_renderer spreads each frame over all the cores anyway.
+	// encode is called from encoder_count threads. The first exception thrown by any of them stops the pipeline, and
+	// is rethrown once all the stages have stopped.
+	pipeline_statistics run_frame_pipeline(size_t frame_count, const pipeline_settings& settings,
+		const std::function<batch_job(size_t frame_index)>& job_at,
+		const std::function<void(size_t frame_index, const batch_job& job, const fractal_scene& scene, image& target)>& render,
+		const std::function<void(size_t frame_index, const batch_job& job, const image& frame)>& encode);
+}
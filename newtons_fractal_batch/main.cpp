@@ -0,0 +1,307 @@
+// Renders Newton's fractal without a window, for bulk image generation. Requires C++23 and GLM.
+
+#include <string>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <format>
+#include <cstring>
+#include <thread>
+#include <optional>
+#include "batch_job.hpp"
+#include "frame_pipeline.hpp"
+#include "tiled_export.hpp"
+#include "basin_map_io.hpp"
+#include "distributed_renderer.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+void write_frame(size_t job_index, const euleristic::batch_job& job, const euleristic::image& frame) {
+	const auto path = job.output_path(job_index);
+	if (path == "-") {
+		euleristic::write_image(std::cout, frame, job.output_format());
+		std::cout.flush();
+		return;
+	}
+	std::ofstream output(path, std::ios::binary);
+	if (!output.is_open()) {
+		throw std::runtime_error("Could not open " + path + " for writing.");
+	}
+	euleristic::write_image(output, frame, job.output_format());
+}
+
+// The commands starting the workers of a distributed render: the ones given, and this program for the local ones,
+// which split the threads between them
+std::vector<std::string> worker_commands(const euleristic::batch_options& options) {
+	auto commands = options.worker_commands;
+	if (options.local_workers == 0) return commands;
+	const unsigned threads = options.thread_count > 0 ? options.thread_count : std::max(1u, std::thread::hardware_concurrency());
+	auto command = std::format("\"{}\" --worker --threads {}", euleristic::current_executable().string(),
+		std::max(1u, threads / options.local_workers));
+	if (options.isa) {
+		command += options.isa == euleristic::instruction_set::scalar ? " --isa scalar"
+			: options.isa == euleristic::instruction_set::avx2 ? " --isa avx2" : " --isa avx512";
+	}
+	commands.insert(commands.end(), options.local_workers, command);
+	return commands;
+}
+
+// One line per iteration count that any pixel took, with a bar to eyeball the distribution by
+void print_histogram(const euleristic::iteration_histogram& histogram) {
+	const size_t pixels = histogram.pixel_count();
+	for (size_t n = 0; n < histogram.counts.size(); ++n) {
+		if (histogram.counts[n] == 0) continue;
+		const double share = static_cast<double>(histogram.counts[n]) / static_cast<double>(pixels);
+		std::cerr << std::format("  {:>4} {:>10} {:6.2f}% {}\n", n, histogram.counts[n], 100.0 * share,
+			std::string(static_cast<size_t>(share * 50.0 + 0.5), '#'));
+	}
+}
+
+auto main(int argc, char** argv) -> int {
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--help") == 0) {
+			std::cout << euleristic::batch_usage;
+			return 0;
+		}
+	}
+
+	try {
+		auto options = euleristic::parse_command_line(argc, argv);
+
+#ifdef _WIN32
+		// Frames go to stdout as they are, or the encoder on the other end of the pipe gets garbage
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+		if (options.worker) {
+#ifdef _WIN32
+			_setmode(_fileno(stdin), _O_BINARY);
+#endif
+			euleristic::serve_bands(std::cin, std::cout, options.thread_count, options.isa);
+			return 0;
+		}
+
+		// Coloring a basin map needs no zeros, only how many there were
+		if (!options.recolor.empty()) {
+			const auto start = std::chrono::steady_clock::now();
+			const euleristic::mapped_basin_map map(options.recolor);
+			const auto& view = map.view();
+			euleristic::thread_pool pool(options.thread_count);
+			euleristic::image frame;
+			euleristic::apply_palette(view, frame, &pool);
+			const std::chrono::duration<double> coloring = std::chrono::steady_clock::now() - start;
+			write_frame(0, options.jobs.front(), frame);
+			if (!options.quiet) {
+				std::cerr << std::format("Colored {}x{} from {} ({:.1f} MiB, {} bit indices) in {:.2f} ms, {:.1f} Mpixel/s.\n",
+					view.width, view.height, options.recolor, static_cast<double>(map.file_size()) / (1 << 20), view.index_bits,
+					1000.0 * coloring.count(), static_cast<double>(view.width * view.height) / coloring.count() * 1e-6);
+			}
+			return 0;
+		}
+
+		euleristic::cpu_renderer renderer(options.thread_count, options.tile_size,
+			options.isa.value_or(euleristic::best_supported_instruction_set()));
+		renderer.subdivide = options.subdivide;
+
+		// Polynomials given by their coefficients need their zeros before they can be colored. A job file usually
+		// repeats one polynomial on every line, so a polynomial is only solved again when it changes.
+		const euleristic::batch_job* solved = nullptr;
+		for (size_t i = 0; i < options.jobs.size(); ++i) {
+			auto& job = options.jobs[i];
+			if (job.coefficients.empty()) continue;
+			if (solved && solved->coefficients == job.coefficients) {
+				job.zeros = solved->zeros;
+				continue;
+			}
+			const auto diagnostics = job.find_zeros(&renderer.worker_pool());
+			solved = &job;
+			if (!diagnostics.converged()) {
+				std::cerr << std::format("Job {}: only {} of the {} zeros converged within {} iterations. The worst could be off by {:.3g}.\n",
+					i, diagnostics.converged_roots, diagnostics.degree, diagnostics.iterations, diagnostics.max_error_bound);
+			}
+			else if (!options.quiet) {
+				std::cerr << std::format("Job {}: found the {} zeros in {} iterations ({:.2f} ms), with a backward error of {:.2g} "
+					"and each within {:.2g} of a true zero.\n", i, diagnostics.degree, diagnostics.iterations,
+					1000.0 * diagnostics.elapsed.count(), diagnostics.max_backward_error, diagnostics.max_error_bound);
+			}
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+
+		if (options.export_images) {
+			const euleristic::export_settings settings{ options.strip_rows, options.resume };
+			for (size_t i = 0; i < options.jobs.size(); ++i) {
+				const auto& job = options.jobs[i];
+				const auto statistics = euleristic::export_job(job, i, renderer, options.tile_size, settings,
+					[&](const euleristic::export_statistics& so_far, size_t rows_done) {
+						if (options.quiet || rows_done == job.height) return;
+						std::cerr << std::format("Job {}: {} of {} rows ({:.1f}%) after {:.1f} s, {:.1f} s of it rendering\n", i, rows_done,
+							job.height, 100.0 * static_cast<double>(rows_done) / static_cast<double>(job.height),
+							std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), so_far.rendering.count());
+					});
+				if (!options.quiet) {
+					if (statistics.resumed_rows > 0) {
+						std::cerr << std::format("Job {}: resumed after {} rows.\n", i, statistics.resumed_rows);
+					}
+					std::cerr << std::format("Job {}: exported {}x{} to {} in {} strips of {} rows in {:.2f} s, {:.2f} Mpixel/s ({}), "
+						"{:.1f} s rendering and {:.1f} s waiting for the disk, with {:.1f} MiB of strips.\n",
+						i, job.width, job.height, job.output_path(i), statistics.strip_count, statistics.strip_rows,
+						statistics.elapsed.count(), statistics.megapixels_per_second(), euleristic::to_string(statistics.precision),
+						statistics.rendering.count(), statistics.waiting_for_disk.count(),
+						static_cast<double>(statistics.strip_bytes) / (1 << 20));
+				}
+			}
+			return 0;
+		}
+
+		if (options.basin_maps) {
+			for (size_t i = 0; i < options.jobs.size(); ++i) {
+				const auto& job = options.jobs[i];
+				euleristic::basin_map map(job.width, job.height);
+				const auto statistics = renderer.render(job.scene(), map);
+				const auto path = job.output_path(i);
+				if (path == "-") {
+					euleristic::write_basin_map(std::cout, map);
+					std::cout.flush();
+				}
+				else {
+					std::ofstream output(path, std::ios::binary);
+					if (!output.is_open()) {
+						throw std::runtime_error("Could not open " + path + " for writing.");
+					}
+					euleristic::write_basin_map(output, map);
+				}
+				if (!options.quiet) {
+					const auto bytes = static_cast<double>(euleristic::basin_map_file_size(map));
+					std::cerr << std::format("Job {}: {}x{} basin map in {:.2f} ms, {:.2f} Mpixel/s ({}), {:.1f} MiB, {:.2f}x smaller than RGBA.\n",
+						i, job.width, job.height, 1000.0 * statistics.elapsed.count(), statistics.megapixels_per_second(),
+						euleristic::to_string(statistics.precision), bytes / (1 << 20), 4.0 * static_cast<double>(job.width * job.height) / bytes);
+				}
+			}
+			return 0;
+		}
+
+		// Started once the zeros are known, so the workers aren't idle while they're found
+		std::optional<euleristic::distributed_renderer> cluster;
+		if (options.local_workers > 0 || !options.worker_commands.empty()) {
+			cluster.emplace(worker_commands(options), euleristic::distributed_settings{ options.band_rows,
+				std::chrono::duration<double>(options.band_timeout), 3, options.tile_size, options.subdivide });
+		}
+
+		double total_seconds = 0.0;
+		size_t total_pixels = 0, total_evaluated_pixels = 0;
+		// The frames' budgets may differ, so the share of the budget used is only meaningful per frame
+		euleristic::iteration_histogram total_iterations;
+
+		const size_t frame_count = options.animation ? options.animation->frame_count() : options.jobs.size();
+		const auto job_at = [&](size_t i) {
+			return options.animation ? options.animation->frame(i) : options.jobs[i];
+		};
+
+		// Frames written to stdout have to come out in order, so there's only one encoder then
+		euleristic::pipeline_settings pipeline{ options.queue_depth, options.encoder_count };
+		const auto to_stdout = [](const euleristic::batch_job& job) { return job.output == "-"; };
+		if (options.animation ? std::ranges::any_of(options.animation->keyframes, to_stdout, &euleristic::keyframe::job)
+			: std::ranges::any_of(options.jobs, to_stdout)) {
+			pipeline.encoder_count = 1;
+		}
+
+		const auto pipeline_statistics = euleristic::run_frame_pipeline(frame_count, pipeline, job_at,
+			[&](size_t i, const euleristic::batch_job& job, const euleristic::fractal_scene& scene, euleristic::image& frame) {
+				if (frame.width != job.width || frame.height != job.height) {
+					frame = euleristic::image(job.width, job.height);
+				}
+
+				if (cluster) {
+					const auto statistics = cluster->render(scene, frame);
+					total_seconds += statistics.elapsed.count();
+					total_pixels += statistics.pixel_count;
+					total_evaluated_pixels += statistics.evaluated_pixels;
+					if (!options.quiet) {
+						std::cerr << std::format("Frame {}: {}x{} in {:.2f} ms, {:.2f} Mpixel/s on {} worker{} ({}), {} bands, {} retried, "
+							"{} stolen, {} pixels iterated ({:.1f}% spared by subdivision).\n",
+							i, job.width, job.height, 1000.0 * statistics.elapsed.count(), statistics.megapixels_per_second(),
+							statistics.worker_count, statistics.worker_count == 1 ? "" : "s", euleristic::to_string(statistics.precision), statistics.band_count,
+							statistics.retried_bands, statistics.stolen_bands, statistics.evaluated_pixels,
+							100.0 * (1.0 - static_cast<double>(statistics.evaluated_pixels) / static_cast<double>(statistics.pixel_count)));
+					}
+					return;
+				}
+
+				auto statistics = renderer.render(scene, frame);
+				total_seconds += statistics.elapsed.count();
+				total_pixels += statistics.pixel_count;
+				total_evaluated_pixels += statistics.evaluated_pixels;
+				if (total_iterations.counts.size() < statistics.iterations.counts.size()) {
+					total_iterations.counts.resize(statistics.iterations.counts.size());
+				}
+				for (size_t n = 0; n < statistics.iterations.counts.size(); ++n) {
+					total_iterations.counts[n] += statistics.iterations.counts[n];
+				}
+				total_iterations.budget = std::max(total_iterations.budget, statistics.iterations.budget);
+				if (!options.quiet) {
+					std::cerr << std::format("Frame {}: {}x{} in {:.2f} ms, {:.2f} Mpixel/s on {} threads ({}, {}, {}), {} of {} tiles stolen, "
+						"{} pixels iterated ({:.1f}% spared by subdivision), {:.2f} iterations on average, {} at p99, {:.1f}% of the budget.\n",
+						i, job.width, job.height, 1000.0 * statistics.elapsed.count(), statistics.megapixels_per_second(),
+						statistics.thread_count, euleristic::to_string(statistics.isa), euleristic::to_string(statistics.precision),
+						euleristic::to_string(scene.method),
+						statistics.stolen_tiles, statistics.tile_count,
+						statistics.evaluated_pixels, 100.0 * statistics.subdivision_saving(), statistics.iterations.mean(),
+						statistics.iterations.percentile(0.99), 100.0 * statistics.iterations.budget_used());
+					if (options.histogram) {
+						print_histogram(statistics.iterations);
+					}
+				}
+			},
+			write_frame);
+
+		if (!options.quiet) {
+			const std::chrono::duration<double> wall_time = std::chrono::steady_clock::now() - start;
+			std::cerr << std::format("{} frames in {:.3f} s, {:.2f} Mpixel/s rendering, {:.2f} frames/s overall, "
+				"{:.1f}% of pixels spared by subdivision.\n",
+				frame_count, wall_time.count(), total_seconds > 0.0 ? total_pixels / total_seconds * 1e-6 : 0.0,
+				frame_count / wall_time.count(),
+				total_pixels > 0 ? 100.0 * (1.0 - static_cast<double>(total_evaluated_pixels) / total_pixels) : 0.0);
+			if (frame_count > 1 && !cluster) {
+				std::cerr << std::format("{:.2f} iterations on average, {} at p99.\n",
+					total_iterations.mean(), total_iterations.percentile(0.99));
+				if (options.histogram) {
+					print_histogram(total_iterations);
+				}
+			}
+			if (cluster) {
+				std::cerr << "Workers:\n";
+				for (const auto& worker : cluster->statistics()) {
+					if (worker.thread_count == 0) {
+						std::cerr << std::format("  {}: never started: {}\n", worker.command,
+							worker.failed() ? worker.failure : std::string("it hasn't introduced itself yet"));
+						continue;
+					}
+					std::cerr << std::format("  {}: {} thread{} ({}), {} bands, {:.2f} Mpixel/s while rendering, {:.1f} ms per band "
+						"from sending it to having it back, {} duplicates{}\n", worker.command, worker.thread_count, worker.thread_count == 1 ? "" : "s",
+						euleristic::to_string(worker.isa), worker.bands, worker.megapixels_per_second(),
+						worker.bands + worker.duplicates > 0 ? 1000.0 * worker.round_trip.count() / static_cast<double>(worker.bands + worker.duplicates) : 0.0,
+						worker.duplicates, worker.failed() ? std::format(", failed with {} bands out: {}", worker.lost_bands, worker.failure) : "");
+				}
+			}
+			// Whichever stage is busy all the time is the one holding the others up
+			std::cerr << std::format("Pipeline: {:.2f} frames/s, with {:.2f} frames waiting for rendering and {:.2f} for encoding on average.\n",
+				pipeline_statistics.frames_per_second(), pipeline_statistics.mean_queue_lengths[0], pipeline_statistics.mean_queue_lengths[1]);
+			for (const auto& stage : pipeline_statistics.stages) {
+				std::cerr << std::format("  {:<8} {:5.1f}% busy, {:5.1f}% waiting for frames, {:5.1f}% waiting for room, on {} thread{}.\n",
+					stage.name, 100.0 * stage.occupancy(pipeline_statistics.elapsed), 100.0 * stage.starved_share(pipeline_statistics.elapsed),
+					100.0 * stage.blocked_share(pipeline_statistics.elapsed), stage.thread_count, stage.thread_count == 1 ? "" : "s");
+			}
+		}
+	} catch (std::exception& err) {
+		std::cerr << err.what() << '\n';
+		return 1;
+	} catch (...) {
+		std::cerr << "Unknown error\n";
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,236 @@
+#include "tiled_export.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std::string_literals;
+
+namespace euleristic {
+
+	double export_statistics::megapixels_per_second() const noexcept {
+		const double pixels = static_cast<double>(width) * static_cast<double>(height - resumed_rows);
+		return elapsed.count() > 0.0 ? pixels / elapsed.count() * 1e-6 : 0.0;
+	}
+
+	// FNV-1a over everything that decides the image's bytes, so that a journal is never resumed into an export of
+	// something else
+	class fingerprint {
+		std::uint64_t hash = 0xcbf29ce484222325;
+
+	public:
+		void add(std::uint64_t value) noexcept {
+			for (int byte = 0; byte < 8; ++byte) {
+				hash = (hash ^ ((value >> (8 * byte)) & 0xff)) * 0x100000001b3;
+			}
+		}
+		void add(double value) noexcept {
+			add(std::bit_cast<std::uint64_t>(value));
+		}
+		void add(std::complex<double> value) noexcept {
+			add(value.real());
+			add(value.imag());
+		}
+		std::uint64_t value() const noexcept {
+			return hash;
+		}
+	};
+
+	std::uint64_t job_fingerprint(const batch_job& job, size_t tile_size, bool subdivide) {
+		fingerprint result;
+		result.add(std::uint64_t{ job.zeros.size() });
+		for (const auto& zero : job.zeros) result.add(zero);
+		result.add(std::uint64_t{ job.coefficients.size() });
+		for (const auto& coefficient : job.coefficients) result.add(coefficient);
+		result.add(job.center);
+		result.add(job.center_low);
+		result.add(job.pixels_per_unit);
+		result.add(std::uint64_t{ job.width });
+		result.add(std::uint64_t{ job.height });
+		result.add(std::uint64_t{ job.iteration_count });
+		result.add(job.epsilon_squared);
+		result.add(std::uint64_t{ job.early_exit });
+		result.add(job.step_squared);
+		result.add(static_cast<std::uint64_t>(job.evaluation));
+		result.add(static_cast<std::uint64_t>(job.method));
+		result.add(static_cast<std::uint64_t>(job.precision));
+		result.add(static_cast<std::uint64_t>(job.output_format()));
+		// The tiles decide where subdivision fills, so they have to line up with the ones before the interruption
+		result.add(std::uint64_t{ tile_size });
+		result.add(std::uint64_t{ subdivide });
+		return result.value();
+	}
+
+	// Where an export got to, as of the last strip that made it to disk
+	struct export_journal {
+		std::uint64_t fingerprint{};
+		image_row_writer::state progress;
+		// The size of the file up to and including that strip
+		std::uint64_t file_size{};
+	};
+
+	constexpr const char* journal_magic = "newtons_fractal_export";
+	constexpr int journal_version = 1;
+
+	// Written to a temporary file and renamed over the old journal, so that an interruption leaves one or the other
+	// whole, never half of each
+	void save_journal(const std::filesystem::path& path, const export_journal& journal) {
+		auto temporary = path;
+		temporary += ".tmp";
+		{
+			std::ofstream output(temporary, std::ios::trunc);
+			output << journal_magic << ' ' << journal_version << '\n'
+				<< "fingerprint " << journal.fingerprint << '\n'
+				<< "rows " << journal.progress.rows_written << '\n'
+				<< "adler " << journal.progress.adler << '\n'
+				<< "bytes " << journal.file_size << '\n';
+			output.flush();
+			if (!output) {
+				throw std::runtime_error("Could not write the export journal " + temporary.string());
+			}
+		}
+		std::filesystem::rename(temporary, path);
+	}
+
+	export_journal load_journal(const std::filesystem::path& path) {
+		std::ifstream input(path);
+		std::string magic, key;
+		int version{};
+		export_journal journal;
+		input >> magic >> version;
+		if (!input || magic != journal_magic || version != journal_version) {
+			throw std::invalid_argument("Not an export journal: " + path.string());
+		}
+		while (input >> key) {
+			if (key == "fingerprint") input >> journal.fingerprint;
+			else if (key == "rows") input >> journal.progress.rows_written;
+			else if (key == "adler") input >> journal.progress.adler;
+			else if (key == "bytes") input >> journal.file_size;
+			else throw std::invalid_argument("Unknown entry " + key + " in the export journal " + path.string());
+		}
+		if (!input.eof()) {
+			throw std::invalid_argument("Malformed export journal: " + path.string());
+		}
+		return journal;
+	}
+
+	export_statistics export_job(const batch_job& job, size_t job_index, cpu_renderer& renderer, size_t tile_size,
+		const export_settings& settings, const std::function<void(const export_statistics& so_far, size_t rows_done)>& on_strip) {
+		using clock = std::chrono::steady_clock;
+		const auto start = clock::now();
+
+		const std::filesystem::path path = job.output_path(job_index);
+		if (path == "-") {
+			throw std::invalid_argument("An export has to go to a file, since it may need to be resumed.");
+		}
+		auto journal_path = path;
+		journal_path += ".progress";
+
+		export_statistics statistics;
+		statistics.width = job.width;
+		statistics.height = job.height;
+		const size_t target_rows = settings.strip_rows > 0 ? settings.strip_rows
+			: std::max<size_t>(1, (size_t{ 32 } << 20) / (sizeof(glm::u8vec4) * job.width));
+		statistics.strip_rows = (target_rows + tile_size - 1) / tile_size * tile_size;
+
+		export_journal journal;
+		journal.fingerprint = job_fingerprint(job, tile_size, renderer.subdivide);
+		std::fstream output;
+		std::optional<export_journal> saved;
+		if (settings.resume && std::filesystem::exists(journal_path)) {
+			saved = load_journal(journal_path);
+			if (saved->fingerprint != journal.fingerprint) {
+				throw std::invalid_argument("The journal " + journal_path.string() + " is of an export with different options. "
+					"Export without resuming to start over.");
+			}
+			// Interrupted during the first strip, with only the header behind it. The writer only skips the header for
+			// rows already written, so this starts over, header and all.
+			if (saved->progress.rows_written == 0) saved.reset();
+		}
+		if (saved) {
+			if (!std::filesystem::exists(path) || std::filesystem::file_size(path) < saved->file_size) {
+				throw std::invalid_argument("The export's output " + path.string() + " is shorter than its journal says. "
+					"Export without resuming to start over.");
+			}
+			// Whatever was written after the last journaled strip may be torn, so it goes
+			journal = *saved;
+			std::filesystem::resize_file(path, journal.file_size);
+			output.open(path, std::ios::in | std::ios::out | std::ios::binary);
+			output.seekp(static_cast<std::streamoff>(journal.file_size));
+			statistics.resumed_rows = journal.progress.rows_written;
+		}
+		else {
+			output.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+		}
+		if (!output.is_open()) {
+			throw std::runtime_error("Could not open " + path.string() + " for writing.");
+		}
+
+		image_row_writer writer(output, job.width, job.height, job.output_format(), journal.progress);
+		const auto checkpoint = [&] {
+			output.flush();
+			if (!output) {
+				throw std::runtime_error("Failed to write " + path.string());
+			}
+			journal.progress = writer.current_state();
+			journal.file_size = static_cast<std::uint64_t>(output.tellp());
+			save_journal(journal_path, journal);
+		};
+		if (statistics.resumed_rows == 0) checkpoint();
+
+		const auto scene = job.scene();
+		std::array<image, 2> strips;
+		std::future<void> writing;
+		size_t strip_index = 0;
+		for (size_t first_row = statistics.resumed_rows; first_row < job.height; first_row += statistics.strip_rows, ++strip_index) {
+			auto& strip = strips[strip_index % 2];
+			const size_t rows = std::min(statistics.strip_rows, job.height - first_row);
+			if (strip.height != rows) {
+				strip = image(job.width, rows);
+			}
+
+			const auto rendered = renderer.render_rows(scene, strip, first_row, job.height);
+			statistics.rendering += rendered.elapsed;
+			statistics.evaluated_pixels += rendered.evaluated_pixels;
+			statistics.precision = rendered.precision;
+			++statistics.strip_count;
+
+			// The strip before this one has to be out of the way before this one is written, and before its image is
+			// rendered into again
+			if (writing.valid()) {
+				const auto wait_start = clock::now();
+				writing.get();
+				statistics.waiting_for_disk += clock::now() - wait_start;
+				if (on_strip) on_strip(statistics, first_row);
+			}
+			writing = std::async(std::launch::async, [&writer, &strip, &checkpoint] {
+				writer.write_rows(strip);
+				checkpoint();
+			});
+		}
+		if (writing.valid()) {
+			const auto wait_start = clock::now();
+			writing.get();
+			statistics.waiting_for_disk += clock::now() - wait_start;
+		}
+
+		writer.finish();
+		output.close();
+		if (!output) {
+			throw std::runtime_error("Failed to write " + path.string());
+		}
+		std::filesystem::remove(journal_path);
+
+		statistics.strip_bytes = 0;
+		for (const auto& strip : strips) statistics.strip_bytes += strip.pixels.size() * sizeof(glm::u8vec4);
+		statistics.elapsed = clock::now() - start;
+		if (on_strip) on_strip(statistics, job.height);
+		return statistics;
+	}
+}
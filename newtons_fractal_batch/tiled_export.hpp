@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+
+#include "batch_job.hpp"
+
+namespace euleristic {
+
+	struct export_settings {
+		// Rows rendered and written at a time, rounded up to a multiple of the tile size. 0 picks about 32 MiB of
+		// pixels per strip.
+		size_t strip_rows = 0;
+		// Carry on where an interrupted export of the same job left off, if it left a journal behind
+		bool resume = false;
+	};
+
+	struct export_statistics {
+		size_t width{}, height{};
+		size_t strip_rows{}, strip_count{};
+		// Rows that were already in the file from an interrupted export
+		size_t resumed_rows{};
+		size_t evaluated_pixels{};
+		precision_mode precision{};
+		// The memory the strips took, which is all the image memory the export needs whatever the image's size
+		size_t strip_bytes{};
+		std::chrono::duration<double> elapsed{}, rendering{};
+		// Time spent waiting for the previous strip to be written, once the next was rendered
+		std::chrono::duration<double> waiting_for_disk{};
+
+		double megapixels_per_second() const noexcept;
+	};
+
+	// Renders job's image in strips of rows straight into its output file, so an image of any size only ever needs two
+	// strips of memory: one being rendered while the one before is written. The strips are rendered with
+	// cpu_renderer::render_rows from the same transform a whole render would use, so the image comes out the same
+	// pixel for pixel.
+	//
+	// After each strip is written, a journal next to the output, its path with .progress appended, records how far the
+	// export got and what it was of. If the export is interrupted, running it again with resume set truncates the file
+	// to the last complete strip and carries on from there. The journal is removed once the image is complete.
+	// on_strip, if given, is called after each strip is written. Throws std::invalid_argument for an output the
+	// export can't go to, or a journal left by a different export.
+	export_statistics export_job(const batch_job& job, size_t job_index, cpu_renderer& renderer, size_t tile_size,
+		const export_settings& settings, const std::function<void(const export_statistics& so_far, size_t rows_done)>& on_strip = {});
+}
@@ -0,0 +1,184 @@
+#include "benchmark.hpp"
+#include "newton_kernel.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <format>
+#include <thread>
+#include <cmath>
+
+namespace euleristic {
+
+	using benchmark_clock = std::chrono::steady_clock;
+
+	std::vector<double> measure(const benchmark_settings& settings, const std::function<void()>& prepare,
+		const std::function<void()>& body) {
+		prepare();
+		body();
+
+		std::vector<double> seconds;
+		double total = 0.0;
+		while (seconds.size() < settings.max_repetitions
+			&& (seconds.size() < settings.min_repetitions || total < settings.min_time.count())) {
+			prepare();
+			const auto start = benchmark_clock::now();
+			body();
+			seconds.push_back(std::chrono::duration<double>(benchmark_clock::now() - start).count());
+			total += seconds.back();
+		}
+		return seconds;
+	}
+
+	std::vector<double> measure_batched(const benchmark_settings& settings, const std::function<void(size_t count)>& body) {
+		// Doubling the count until a batch is long enough doubles as the warm up
+		size_t count = 1;
+		while (true) {
+			const auto start = benchmark_clock::now();
+			body(count);
+			if (std::chrono::duration<double>(benchmark_clock::now() - start) >= settings.min_batch_time) break;
+			count *= 2;
+		}
+
+		std::vector<double> seconds;
+		double total = 0.0;
+		while (seconds.size() < settings.max_repetitions
+			&& (seconds.size() < settings.min_repetitions || total < settings.min_time.count())) {
+			const auto start = benchmark_clock::now();
+			body(count);
+			const double elapsed = std::chrono::duration<double>(benchmark_clock::now() - start).count();
+			seconds.push_back(elapsed / static_cast<double>(count));
+			total += elapsed;
+		}
+		return seconds;
+	}
+
+	double sink;
+
+	void keep(double value) noexcept {
+		// A volatile store to a variable any other file could read, so neither the store nor the value can be optimized away
+		*static_cast<volatile double*>(&sink) = value;
+	}
+
+	// Benchmark results
+
+	double benchmark_result::min_seconds() const {
+		return seconds.empty() ? 0.0 : *std::ranges::min_element(seconds);
+	}
+
+	double benchmark_result::median_seconds() const {
+		if (seconds.empty()) return 0.0;
+		auto sorted = seconds;
+		std::ranges::sort(sorted);
+		const size_t middle = sorted.size() / 2;
+		return sorted.size() % 2 == 1 ? sorted[middle] : 0.5 * (sorted[middle - 1] + sorted[middle]);
+	}
+
+	double benchmark_result::mean_seconds() const {
+		return seconds.empty() ? 0.0 : std::accumulate(seconds.begin(), seconds.end(), 0.0) / static_cast<double>(seconds.size());
+	}
+
+	double benchmark_result::max_seconds() const {
+		return seconds.empty() ? 0.0 : *std::ranges::max_element(seconds);
+	}
+
+	double benchmark_result::nanoseconds_per_item() const {
+		return 1e9 * median_seconds() / items_per_call;
+	}
+
+	benchmark_context current_benchmark_context(const benchmark_settings& settings) {
+		benchmark_context context;
+		context.date = std::format("{:%FT%TZ}", std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()));
+#if defined(_MSC_VER) && !defined(__clang__)
+		context.compiler = std::format("MSVC {}", _MSC_FULL_VER);
+#elif defined(__clang__)
+		context.compiler = "Clang " __clang_version__;
+#elif defined(__GNUC__)
+		context.compiler = "GCC " __VERSION__;
+#else
+		context.compiler = "unknown";
+#endif
+#ifdef NDEBUG
+		context.build = "release";
+#else
+		context.build = "debug";
+#endif
+		context.hardware_threads = std::thread::hardware_concurrency();
+		context.best_isa = to_string(best_supported_instruction_set());
+		context.settings = settings;
+		return context;
+	}
+
+	// JSON
+
+	std::string json_string(std::string_view text) {
+		std::string quoted = "\"";
+		for (const char character : text) {
+			switch (character) {
+			case '"': quoted += "\\\""; break;
+			case '\\': quoted += "\\\\"; break;
+			case '\n': quoted += "\\n"; break;
+			case '\t': quoted += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(character) < 0x20) {
+					quoted += std::format("\\u{:04x}", static_cast<unsigned>(character));
+				}
+				else {
+					quoted += character;
+				}
+			}
+		}
+		return quoted + '"';
+	}
+
+	// JSON has no infinities or NaN
+	std::string json_number(double value) {
+		return std::isfinite(value) ? std::format("{}", value) : "null";
+	}
+
+	std::string json_value(const benchmark_value& value) {
+		if (const auto number = std::get_if<double>(&value)) return json_number(*number);
+		return json_string(std::get<std::string>(value));
+	}
+
+	std::string json_object(const std::vector<std::pair<std::string, benchmark_value>>& members) {
+		std::string object = "{";
+		for (size_t i = 0; i < members.size(); ++i) {
+			object += std::format("{}{}: {}", i == 0 ? "" : ", ", json_string(members[i].first), json_value(members[i].second));
+		}
+		return object + "}";
+	}
+
+	void write_json(std::ostream& stream, const benchmark_context& context, const std::vector<benchmark_result>& results) {
+		stream << "{\n";
+		stream << "  \"schema\": 1,\n";
+		stream << "  \"context\": {\n";
+		stream << std::format("    \"date\": {},\n", json_string(context.date));
+		stream << std::format("    \"compiler\": {},\n", json_string(context.compiler));
+		stream << std::format("    \"build\": {},\n", json_string(context.build));
+		stream << std::format("    \"hardware_threads\": {},\n", context.hardware_threads);
+		stream << std::format("    \"best_isa\": {},\n", json_string(context.best_isa));
+		stream << std::format("    \"min_time_seconds\": {},\n", json_number(context.settings.min_time.count()));
+		stream << std::format("    \"min_repetitions\": {}\n", context.settings.min_repetitions);
+		stream << "  },\n";
+		stream << "  \"benchmarks\": [";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const auto& result = results[i];
+			stream << (i == 0 ? "\n" : ",\n");
+			stream << "    {\n";
+			stream << std::format("      \"group\": {},\n", json_string(result.group));
+			stream << std::format("      \"name\": {},\n", json_string(result.name));
+			stream << std::format("      \"parameters\": {},\n", json_object(result.parameters));
+			stream << std::format("      \"unit\": {},\n", json_string(result.unit));
+			stream << std::format("      \"items_per_call\": {},\n", json_number(result.items_per_call));
+			stream << std::format("      \"repetitions\": {},\n", result.seconds.size());
+			stream << std::format("      \"seconds_per_call\": {{\"min\": {}, \"median\": {}, \"mean\": {}, \"max\": {}}},\n",
+				json_number(result.min_seconds()), json_number(result.median_seconds()), json_number(result.mean_seconds()),
+				json_number(result.max_seconds()));
+			stream << std::format("      \"nanoseconds_per_item\": {},\n", json_number(result.nanoseconds_per_item()));
+			stream << std::format("      \"counters\": {}\n", json_object(result.counters));
+			stream << "    }";
+		}
+		stream << (results.empty() ? "]\n" : "\n  ]\n");
+		stream << "}\n";
+	}
+}
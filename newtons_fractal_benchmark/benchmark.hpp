@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <variant>
+#include <utility>
+#include <chrono>
+#include <ostream>
+#include <functional>
+
+namespace euleristic {
+
+	struct benchmark_settings {
+		// Each benchmark repeats until it has run for at least min_time and at least min_repetitions times
+		std::chrono::duration<double> min_time{ 0.25 };
+		size_t min_repetitions = 3;
+		size_t max_repetitions = 10000;
+		// Batched benchmarks run their body this long per repetition at least, so the clock's resolution doesn't matter
+		std::chrono::duration<double> min_batch_time{ 0.001 };
+	};
+
+	// Runs prepare and then body once per repetition, timing only body. Returns the seconds each repetition took.
+	// There is one untimed warm up run first.
+	std::vector<double> measure(const benchmark_settings& settings, const std::function<void()>& prepare,
+		const std::function<void()>& body);
+
+	// For operations far shorter than the clock's resolution: body(count) does the operation count times, and count
+	// is doubled until a repetition takes min_batch_time. Returns the seconds per operation of each repetition.
+	std::vector<double> measure_batched(const benchmark_settings& settings, const std::function<void(size_t count)>& body);
+
+	// Keeps the compiler from optimizing away a result that is otherwise unused
+	void keep(double value) noexcept;
+
+	using benchmark_value = std::variant<double, std::string>;
+
+	struct benchmark_result {
+		std::string group, name;
+		// What the benchmark was run with, such as the degree and resolution
+		std::vector<std::pair<std::string, benchmark_value>> parameters;
+		// What one call processes, and how many of them: pixels for the kernels, a frame for the scenes
+		std::string unit;
+		double items_per_call = 1.0;
+		// Seconds per call, one per repetition
+		std::vector<double> seconds;
+		// Anything else worth tracking, like the mean iteration count of a kernel
+		std::vector<std::pair<std::string, benchmark_value>> counters;
+
+		double min_seconds() const;
+		double median_seconds() const;
+		double mean_seconds() const;
+		double max_seconds() const;
+		// The median time per item. The median rather than the mean, since a preempted repetition shouldn't count.
+		double nanoseconds_per_item() const;
+	};
+
+	// Where and how the results were measured, to go with them
+	struct benchmark_context {
+		std::string date;
+		std::string compiler;
+		std::string build;
+		unsigned hardware_threads{};
+		std::string best_isa;
+		benchmark_settings settings;
+	};
+
+	benchmark_context current_benchmark_context(const benchmark_settings& settings);
+
+	// The results as a single JSON object, with the context first
+	void write_json(std::ostream& stream, const benchmark_context& context, const std::vector<benchmark_result>& results);
+}
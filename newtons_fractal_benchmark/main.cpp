@@ -0,0 +1,594 @@
+// Benchmarks the fractal math and the CPU render paths, and writes the results as JSON, so that releases can be
+// compared. Requires C++23 and GLM.
+
+#include <array>
+#include <span>
+#include <string>
+#include <numbers>
+#include <fstream>
+#include <iostream>
+#include <format>
+#include <charconv>
+#include <random>
+#include <cstring>
+#include <stdexcept>
+#include "benchmark.hpp"
+#include "cpu_renderer.hpp"
+#include "newton_kernel.hpp"
+#include "palette.hpp"
+#include "polynomial.hpp"
+#include "root_finder.hpp"
+#include "zero_index.hpp"
+
+using namespace std::string_literals;
+
+const char* const benchmark_usage =
+	"Usage: newtons_fractal_benchmark [options]\n"
+	"Times the polynomial expansion, the root finder, the zero index, the palette, the Newton kernels, the iteration methods\n"
+	"against each other and full frames of reference scenes, and writes the results as JSON.\n"
+	"\n"
+	"  --output PATH                File to write the JSON to, - for stdout (default: -)\n"
+	"  --filter TEXT                Only run benchmarks whose label contains TEXT, such as kernel/ or degree=20\n"
+	"  --min-time SECONDS           Repeat each benchmark for at least this long (default: 0.25)\n"
+	"  --min-repetitions N          And at least this many times (default: 3)\n"
+	"  --quick                      One repetition each, to check that everything runs\n"
+	"  --isa ISA                    scalar, avx2, avx512 or all (default: the best the CPU supports)\n"
+	"  --threads N                  Worker threads for the scenes and the root finder, 0 for one per hardware thread\n"
+	"                               (default: 0)\n"
+	"  --no-early-exit              Iterate every pixel the full count in the kernel benchmarks\n"
+	"  --quiet                      Don't print a summary on stderr\n"
+	"  --help                       Show this\n";
+
+struct benchmark_options {
+	std::string output = "-";
+	std::string filter;
+	euleristic::benchmark_settings settings;
+	std::vector<euleristic::instruction_set> isas{ euleristic::best_supported_instruction_set() };
+	unsigned thread_count = 0;
+	bool early_exit = true;
+	bool quiet = false;
+};
+
+template<typename number_type>
+number_type parse_number(std::string_view text, std::string_view option) {
+	number_type value{};
+	auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+	if (error != std::errc{} || end != text.data() + text.size()) {
+		throw std::invalid_argument("Malformed number for "s + std::string(option) + ": " + std::string(text));
+	}
+	return value;
+}
+
+benchmark_options parse_command_line(int argc, const char* const* argv) {
+	benchmark_options options;
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view option = argv[i];
+		const auto value = [&]() -> std::string_view {
+			if (i + 1 >= argc) {
+				throw std::invalid_argument("Missing value for "s + std::string(option));
+			}
+			return argv[++i];
+		};
+
+		if (option == "--output") options.output = value();
+		else if (option == "--filter") options.filter = value();
+		else if (option == "--min-time") options.settings.min_time = std::chrono::duration<double>(parse_number<double>(value(), option));
+		else if (option == "--min-repetitions") options.settings.min_repetitions = parse_number<size_t>(value(), option);
+		else if (option == "--quick") {
+			options.settings.min_time = std::chrono::duration<double>(0.0);
+			options.settings.min_repetitions = 1;
+		}
+		else if (option == "--isa") {
+			using euleristic::instruction_set;
+			const auto isa = value();
+			if (isa == "scalar") options.isas = { instruction_set::scalar };
+			else if (isa == "avx2") options.isas = { instruction_set::avx2 };
+			else if (isa == "avx512") options.isas = { instruction_set::avx512 };
+			else if (isa == "all") {
+				options.isas.clear();
+				for (const auto each : { instruction_set::scalar, instruction_set::avx2, instruction_set::avx512 }) {
+					if (each <= euleristic::best_supported_instruction_set()) options.isas.push_back(each);
+				}
+			}
+			else throw std::invalid_argument("Unknown instruction set: "s + std::string(isa));
+		}
+		else if (option == "--threads") options.thread_count = parse_number<unsigned>(value(), option);
+		else if (option == "--no-early-exit") options.early_exit = false;
+		else if (option == "--quiet") options.quiet = true;
+		else throw std::invalid_argument("Unknown option: "s + std::string(option));
+	}
+	return options;
+}
+
+// The roots of z^degree + 1, evenly spaced on the unit circle
+std::vector<std::complex<double>> ring_zeros(size_t degree) {
+	std::vector<std::complex<double>> zeros;
+	for (size_t k = 0; k < degree; ++k) {
+		zeros.push_back(std::polar(1.0, std::numbers::pi * static_cast<double>(2 * k + 1) / static_cast<double>(degree)));
+	}
+	return zeros;
+}
+
+std::string readable_duration(double nanoseconds) {
+	if (nanoseconds >= 1e6) return std::format("{:.2f} ms", nanoseconds / 1e6);
+	if (nanoseconds >= 1e3) return std::format("{:.2f} us", nanoseconds / 1e3);
+	return std::format("{:.2f} ns", nanoseconds);
+}
+
+// The benchmarks are listed up front with a label each, so that --filter can skip them without running them
+struct benchmark_case {
+	std::string label;
+	std::function<euleristic::benchmark_result()> run;
+};
+
+// The largest |a[k] - b[k]| over e_(n-k)(|zeros|), which is the scale the error bound of either expansion has (see
+// polynomial.hpp). Relative to the coefficients themselves would be meaningless, since z^n + 1 has little but zeros.
+double max_scaled_difference(std::span<const std::complex<double>> a, std::span<const std::complex<double>> b,
+	std::span<const std::complex<double>> zeros) {
+	// The coefficients of the product of (z + |zeros[i]|), all positive, so they come out accurate
+	std::vector<std::complex<double>> magnitudes;
+	for (const auto& zero : zeros) magnitudes.push_back(-std::abs(zero));
+	const auto scale = euleristic::zeros_to_coefficients(magnitudes);
+	double largest = 0.0;
+	for (size_t k = 0; k < a.size(); ++k) {
+		largest = std::max(largest, std::abs(a[k] - b[k]) / scale[k].real());
+	}
+	return largest;
+}
+
+void add_polynomial_benchmarks(std::vector<benchmark_case>& cases, const benchmark_options& options) {
+	using namespace euleristic;
+	// The expansions are also checked against z^degree + 1, whose zeros ring_zeros are, and the reference against the
+	// O(n^2) expansion, both in units of the error bound's scale, so that a value near degree * 1e-16 is what the
+	// bound leads one to expect
+	const auto add = [&](std::string name, size_t degree, auto expand, bool reference) {
+		cases.push_back({ std::format("polynomial/{} degree={}", name, degree), [&options, name, degree, expand, reference] {
+			const auto zeros = ring_zeros(degree);
+			benchmark_result result{ "polynomial", name, { { "degree", static_cast<double>(degree) } }, "call", 1.0, {}, {} };
+			result.seconds = measure_batched(options.settings, [&](size_t count) {
+				for (size_t i = 0; i < count; ++i) {
+					keep(expand(zeros)[0].real());
+				}
+			});
+			const auto coefficients = expand(zeros);
+			std::vector<std::complex<double>> exact(degree + 1);
+			exact.front() = exact.back() = 1.0;
+			result.counters = { { "max_relative_error", max_scaled_difference(coefficients, exact, zeros) } };
+			if (reference) {
+				result.counters.push_back({ "max_relative_difference", max_scaled_difference(coefficients, zeros_to_coefficients(zeros), zeros) });
+			}
+			return result;
+		} });
+	};
+	for (const size_t degree : { 3, 5, 10, 20, 40, 80 }) {
+		add("zeros_to_coefficients", degree, [](const auto& zeros) { return zeros_to_coefficients(zeros); }, false);
+	}
+	// The reference is O(n * 2^n), so it stops well short of the others
+	for (const size_t degree : { 3, 5, 10, 16 }) {
+		add("zeros_to_coefficients_by_subsets", degree, [](const auto& zeros) { return zeros_to_coefficients_by_subsets(zeros); }, true);
+	}
+
+	// Dragging a zero, as the window does: a move_zero a frame, and the coefficients expanded anew only once the zero is
+	// let go. The drift is how far the coefficients have strayed from a fresh expansion after that many moves, of a
+	// zero going around a circle of radius 0.5 a hundred steps at a time.
+	for (const size_t degree : { 3, 10, 20, 40, 80 }) {
+		cases.push_back({ std::format("polynomial/move_zero degree={}", degree), [&options, degree] {
+			auto zeros = ring_zeros(degree);
+			const auto start = zeros[0];
+			const auto position = [&](size_t step) {
+				return start + 0.5 * (std::polar(1.0, 2.0 * std::numbers::pi * static_cast<double>(step) / 100.0) - 1.0);
+			};
+			auto coefficients = zeros_to_coefficients(zeros);
+			benchmark_result result{ "polynomial", "move_zero", { { "degree", static_cast<double>(degree) } }, "call", 1.0, {}, {} };
+			size_t step = 0;
+			result.seconds = measure_batched(options.settings, [&](size_t count) {
+				for (size_t i = 0; i < count; ++i) {
+					const auto next = position(++step);
+					move_zero(coefficients, zeros[0], next);
+					zeros[0] = next;
+				}
+				keep(coefficients[0].real());
+			});
+
+			zeros = ring_zeros(degree);
+			coefficients = zeros_to_coefficients(zeros);
+			step = 0;
+			for (const size_t moves : { 10, 100, 1000, 10000 }) {
+				while (step < moves) {
+					const auto next = position(++step);
+					move_zero(coefficients, zeros[0], next);
+					zeros[0] = next;
+				}
+				result.counters.push_back({ std::format("drift_after_{}", moves),
+					max_scaled_difference(coefficients, zeros_to_coefficients(zeros), zeros) });
+			}
+			return result;
+		} });
+	}
+}
+
+// Polynomials with random complex coefficients, the same every run, which have their zeros spread around the unit circle
+void add_root_finder_benchmarks(std::vector<benchmark_case>& cases, const benchmark_options& options) {
+	using namespace euleristic;
+	for (const bool threaded : { false, true }) {
+		for (const size_t degree : { 20, 100, 400, 1000 }) {
+			const std::string name = threaded ? "find_roots_threaded" : "find_roots";
+			cases.push_back({ std::format("root_finder/{} degree={}", name, degree), [&options, name, threaded, degree] {
+				std::mt19937_64 generator(degree);
+				std::normal_distribution<double> distribution;
+				std::vector<std::complex<double>> coefficients;
+				for (size_t k = 0; k <= degree; ++k) {
+					coefficients.push_back({ distribution(generator), distribution(generator) });
+				}
+				thread_pool pool(threaded ? options.thread_count : 1);
+				root_finder_settings settings;
+				settings.parallel_degree = threaded ? 0 : settings.parallel_degree;
+
+				root_finder_result found;
+				benchmark_result result{ "root_finder", name, {
+					{ "degree", static_cast<double>(degree) },
+					{ "threads", static_cast<double>(threaded ? pool.thread_count() : 1) } }, "polynomial", 1.0, {}, {} };
+				result.seconds = measure(options.settings, [] {}, [&] { found = find_roots(coefficients, settings, threaded ? &pool : nullptr); });
+				result.counters = {
+					{ "iterations", static_cast<double>(found.diagnostics.iterations) },
+					{ "converged_roots", static_cast<double>(found.diagnostics.converged_roots) },
+					{ "max_backward_error", found.diagnostics.max_backward_error },
+					{ "max_error_bound", found.diagnostics.max_error_bound } };
+				return result;
+			} });
+		}
+	}
+}
+
+// Building the grid over the zeros, and looking up the zero nearest a point with it and with a linear scan: classifying
+// at the window's default epsilon, as the fractal shader does, and picking within a marker's radius at the window's
+// starting zoom. The zeros are the roots of z^degree + 1, and the points spread over the square around them.
+void add_zero_index_benchmarks(std::vector<benchmark_case>& cases, const benchmark_options& options) {
+	using namespace euleristic;
+	constexpr double radius = 0.31622776601683794; // sqrt(0.1)
+	constexpr double marker_radius = 10.0 / 200.0;
+	constexpr size_t point_count = 4096;
+	const auto points = [] {
+		std::mt19937_64 generator(1);
+		std::uniform_real_distribution<double> distribution(-1.5, 1.5);
+		std::vector<std::complex<double>> points;
+		for (size_t i = 0; i < point_count; ++i) {
+			points.push_back({ distribution(generator), distribution(generator) });
+		}
+		return points;
+	};
+
+	for (const size_t degree : { 3, 20, 100, 1000, 4000 }) {
+		cases.push_back({ std::format("zero_index/build degree={}", degree), [&options, degree] {
+			const auto zeros = ring_zeros(degree);
+			benchmark_result result{ "zero_index", "build", { { "degree", static_cast<double>(degree) } }, "call", 1.0, {}, {} };
+			zero_index index;
+			result.seconds = measure(options.settings, [] {}, [&] { index = zero_index(zeros, radius); });
+			result.counters = {
+				{ "cells", static_cast<double>(index.columns() * index.rows()) },
+				{ "mean_candidates", static_cast<double>(index.candidates().size()) / static_cast<double>(index.columns() * index.rows()) } };
+			return result;
+		} });
+		const auto add_lookup = [&](std::string name, auto lookup) {
+			cases.push_back({ std::format("zero_index/{} degree={}", name, degree), [&options, name, degree, points, lookup] {
+				const auto zeros = ring_zeros(degree);
+				const zero_index index(zeros, radius);
+				const auto queries = points();
+				benchmark_result result{ "zero_index", name, { { "degree", static_cast<double>(degree) } }, "point", 1.0, {}, {} };
+				result.seconds = measure_batched(options.settings, [&](size_t count) {
+					size_t found = 0;
+					for (size_t i = 0; i < count; ++i) {
+						found += lookup(index, queries[i % point_count]).value_or(0);
+					}
+					keep(found);
+				});
+				return result;
+			} });
+		};
+		add_lookup("classify", [](const zero_index& index, std::complex<double> point) { return index.classify(point, radius); });
+		add_lookup("nearest", [](const zero_index& index, std::complex<double> point) { return index.nearest(point, marker_radius); });
+		cases.push_back({ std::format("zero_index/linear_scan degree={}", degree), [&options, degree, points] {
+			const auto zeros = ring_zeros(degree);
+			const auto queries = points();
+			benchmark_result result{ "zero_index", "linear_scan", { { "degree", static_cast<double>(degree) } }, "point", 1.0, {}, {} };
+			result.seconds = measure_batched(options.settings, [&](size_t count) {
+				size_t found = 0;
+				for (size_t i = 0; i < count; ++i) {
+					const auto point = queries[i % point_count];
+					double nearest_distance_squared = radius * radius;
+					size_t nearest = 0;
+					for (size_t k = 0; k < zeros.size(); ++k) {
+						const double distance_squared = std::norm(zeros[k] - point);
+						if (distance_squared < nearest_distance_squared) {
+							nearest = k;
+							nearest_distance_squared = distance_squared;
+						}
+					}
+					found += nearest;
+				}
+				keep(found);
+			});
+			return result;
+		} });
+	}
+}
+
+void add_palette_benchmarks(std::vector<benchmark_case>& cases, const benchmark_options& options) {
+	using namespace euleristic;
+	cases.push_back({ "palette/generate_color", [&options] {
+		benchmark_result result{ "palette", "generate_color", {}, "call", 1.0, {}, {} };
+		result.seconds = measure_batched(options.settings, [](size_t count) {
+			float sum = 0.0f;
+			for (size_t i = 0; i < count; ++i) {
+				sum += generate_color(i % 1024).r;
+			}
+			keep(sum);
+		});
+		return result;
+	} });
+	cases.push_back({ "palette/hsv_to_rgba", [&options] {
+		benchmark_result result{ "palette", "hsv_to_rgba", {}, "call", 1.0, {}, {} };
+		result.seconds = measure_batched(options.settings, [](size_t count) {
+			float sum = 0.0f;
+			for (size_t i = 0; i < count; ++i) {
+				sum += hsv_to_rgba(static_cast<float>(i % 1024) / 1024.0f, 0.8f, 0.9f).g;
+			}
+			keep(sum);
+		});
+		return result;
+	} });
+}
+
+// One kernel call over every pixel of a width x height image of the window's starting viewport, on one thread
+void add_kernel_benchmarks(std::vector<benchmark_case>& cases, const benchmark_options& options) {
+	using namespace euleristic;
+	constexpr std::array<std::pair<size_t, size_t>, 3> resolutions{ { { 128, 96 }, { 512, 384 }, { 1024, 768 } } };
+	for (const auto isa : options.isas) {
+		for (const auto evaluation : { evaluation_mode::coefficients, evaluation_mode::zeros }) {
+			for (const size_t degree : { 3, 8, 20 }) {
+				for (const unsigned iteration_count : { 10u, 20u, 50u }) {
+					for (const auto& [width, height] : resolutions) {
+						const auto label = std::format("kernel/{} degree={} iterations={} {}x{} {}", to_string(evaluation), degree,
+							iteration_count, width, height, to_string(isa));
+						cases.push_back({ label, [&options, isa, evaluation, degree, iteration_count, width, height] {
+							const auto zeros = ring_zeros(degree);
+							const newton_polynomial polynomial(zeros_to_coefficients(zeros));
+							const newton_zeros soa_zeros(zeros);
+							const auto exit = options.early_exit ? make_newton_exit(zeros, iteration_count, 0.1, 1e-24) : newton_exit{ iteration_count };
+							const auto kernel = select_newton_kernel(isa);
+							const auto product_kernel = select_product_form_kernel(isa);
+
+							const auto transform = make_screen_to_fractal_space(width, height, {}, static_cast<double>(width) / 4.0);
+							std::vector<double> seed_real, seed_imag;
+							for (size_t y = 0; y < height; ++y) {
+								for (size_t x = 0; x < width; ++x) {
+									const auto point = transform * glm::dvec3(static_cast<double>(x) + 0.5, static_cast<double>(y) + 0.5, 1.0);
+									seed_real.push_back(point.x);
+									seed_imag.push_back(point.y);
+								}
+							}
+							auto real = seed_real, imag = seed_imag;
+							std::vector<unsigned> iterations(seed_real.size());
+
+							benchmark_result result{ "kernel", to_string(evaluation), {
+								{ "degree", static_cast<double>(degree) },
+								{ "iterations", static_cast<double>(iteration_count) },
+								{ "width", static_cast<double>(width) },
+								{ "height", static_cast<double>(height) },
+								{ "isa", to_string(isa) },
+								{ "early_exit", options.early_exit ? "on"s : "off"s } }, "pixel", static_cast<double>(seed_real.size()), {}, {} };
+							result.seconds = measure(options.settings, [&] {
+								real = seed_real;
+								imag = seed_imag;
+							}, [&] {
+								if (evaluation == evaluation_mode::coefficients) {
+									kernel(polynomial, soa_zeros, exit, real.data(), imag.data(), iterations.data(), real.size());
+								}
+								else {
+									product_kernel(soa_zeros, exit, real.data(), imag.data(), iterations.data(), real.size());
+								}
+							});
+
+							double total_iterations = 0.0;
+							for (const auto count : iterations) total_iterations += count;
+							const double mean_iterations = total_iterations / static_cast<double>(iterations.size());
+							result.counters = {
+								{ "mean_iterations", mean_iterations },
+								{ "nanoseconds_per_iteration", result.nanoseconds_per_item() / std::max(mean_iterations, 1.0) } };
+							return result;
+						} });
+					}
+				}
+			}
+		}
+	}
+}
+
+// Each iteration method over the same pixels with the scalar kernels, which are all the higher order methods have, so
+// Newton's method is held to scalar here too. The point is the total work to get a pixel to its zero: a higher order
+// step costs more than a Newton step, and pays off only if it takes enough fewer of them. The repeated zeros are
+// where Newton's and Halley's methods slow to linear convergence, and only the multiplicity-aware one doesn't.
+void add_method_benchmarks(std::vector<benchmark_case>& cases, const benchmark_options& options) {
+	using namespace euleristic;
+	struct method_scene {
+		std::string name;
+		std::vector<std::complex<double>> zeros;
+	};
+	std::vector<method_scene> scenes;
+	for (const size_t degree : { 3, 20, 100 }) {
+		scenes.push_back({ std::format("ring degree={}", degree), ring_zeros(degree) });
+	}
+	// Every zero of z^6 + 1, twice
+	auto doubled = ring_zeros(6);
+	doubled.insert(doubled.end(), doubled.begin(), doubled.end());
+	scenes.push_back({ "doubled degree=12", doubled });
+
+	constexpr size_t width = 256, height = 192;
+	constexpr unsigned iteration_count = 50;
+	for (const auto& scene : scenes) {
+		for (const auto evaluation : { evaluation_mode::coefficients, evaluation_mode::zeros }) {
+			for (const auto method : { iteration_method::newton, iteration_method::halley, iteration_method::householder,
+				iteration_method::multiplicity }) {
+				const auto label = std::format("method/{} {} {}", to_string(method), to_string(evaluation), scene.name);
+				cases.push_back({ label, [&options, scene, evaluation, method] {
+					const newton_polynomial polynomial(zeros_to_coefficients(scene.zeros));
+					const newton_zeros soa_zeros(scene.zeros);
+					const auto exit = make_newton_exit(scene.zeros, iteration_count, 0.1, 1e-24);
+
+					const auto transform = make_screen_to_fractal_space(width, height, {}, static_cast<double>(width) / 4.0);
+					std::vector<double> seed_real, seed_imag;
+					for (size_t y = 0; y < height; ++y) {
+						for (size_t x = 0; x < width; ++x) {
+							const auto point = transform * glm::dvec3(static_cast<double>(x) + 0.5, static_cast<double>(y) + 0.5, 1.0);
+							seed_real.push_back(point.x);
+							seed_imag.push_back(point.y);
+						}
+					}
+					auto real = seed_real, imag = seed_imag;
+					std::vector<unsigned> iterations(seed_real.size());
+
+					benchmark_result result{ "method", to_string(method), {
+						{ "evaluation", to_string(evaluation) },
+						{ "scene", scene.name },
+						{ "degree", static_cast<double>(scene.zeros.size()) },
+						{ "iterations", static_cast<double>(iteration_count) },
+						{ "width", static_cast<double>(width) },
+						{ "height", static_cast<double>(height) } }, "pixel", static_cast<double>(seed_real.size()), {}, {} };
+					result.seconds = measure(options.settings, [&] {
+						real = seed_real;
+						imag = seed_imag;
+					}, [&] {
+						if (evaluation == evaluation_mode::coefficients) {
+							higher_order_iterate_scalar(method, polynomial, soa_zeros, exit, real.data(), imag.data(), iterations.data(), real.size());
+						}
+						else {
+							higher_order_iterate_product_form_scalar(method, soa_zeros, exit, real.data(), imag.data(), iterations.data(), real.size());
+						}
+					});
+
+					// Converged the way the renderers color a pixel: within the window's default epsilon of a zero once it
+					// stopped. The exit radius may be smaller, which is what a pixel has to get through to stop early.
+					double total_iterations = 0.0;
+					size_t converged = 0;
+					for (size_t i = 0; i < iterations.size(); ++i) {
+						total_iterations += iterations[i];
+						if (within_epsilon(soa_zeros, 0.1, real[i], imag[i])) ++converged;
+					}
+					const double pixels = static_cast<double>(iterations.size());
+					const double converged_pixels = static_cast<double>(std::max<size_t>(converged, 1));
+					const double flops = flops_per_iteration(method, evaluation, scene.zeros.size());
+					result.counters = {
+						{ "mean_iterations", total_iterations / pixels },
+						{ "converged_share", static_cast<double>(converged) / pixels },
+						{ "flops_per_iteration", flops },
+						{ "flops_per_converged_pixel", flops * total_iterations / converged_pixels },
+						{ "nanoseconds_per_converged_pixel", result.nanoseconds_per_item() * pixels / converged_pixels } };
+					return result;
+				} });
+			}
+		}
+	}
+}
+
+// Whole frames through cpu_renderer, subdivision, threads and all
+void add_scene_benchmarks(std::vector<benchmark_case>& cases, const benchmark_options& options) {
+	using namespace euleristic;
+	struct reference_scene {
+		std::string name;
+		std::vector<std::complex<double>> zeros;
+		std::string_view center_real, center_imag;
+		double pixels_per_unit;
+		unsigned iteration_count;
+	};
+	// The window's cubic, to the last bit: the deep zoom sits on one of its basin boundaries, some 1e20 pixels per unit
+	// in, where it takes double-double to see anything, and rounding the zeros differently would move the boundary away.
+	const std::vector<std::complex<double>> default_cubic{ { -1.0, 0.0 }, { 0.5, 0.8660254037844386 }, { 0.5, -0.8660254037844386 } };
+	const std::array<reference_scene, 3> scenes{ {
+		{ "default_cubic", default_cubic, "0", "0", 200.0, 20 },
+		{ "ring20", ring_zeros(20), "0", "0", 200.0, 20 },
+		{ "deep_zoom", default_cubic, "-0.3641017609658009904071878520752", "0.2999999999999999888977697537484", 1e20, 300 } } };
+	constexpr size_t width = 800, height = 600;
+
+	for (const auto isa : options.isas) {
+		for (const auto& reference : scenes) {
+			cases.push_back({ std::format("scene/{} {}", reference.name, to_string(isa)), [&options, reference, isa] {
+				fractal_scene scene;
+				scene.zeros = reference.zeros;
+				scene.coefficients = zeros_to_coefficients(scene.zeros);
+				set_viewport(scene, width, height, *parse_double_double(reference.center_real),
+					*parse_double_double(reference.center_imag), reference.pixels_per_unit);
+				scene.iteration_count = reference.iteration_count;
+
+				cpu_renderer renderer(options.thread_count, 32, isa);
+				image frame(width, height);
+				render_statistics statistics;
+				benchmark_result result{ "scene", reference.name, {
+					{ "degree", static_cast<double>(reference.zeros.size()) },
+					{ "width", static_cast<double>(width) },
+					{ "height", static_cast<double>(height) },
+					{ "pixels_per_unit", reference.pixels_per_unit },
+					{ "iterations", static_cast<double>(reference.iteration_count) },
+					{ "isa", to_string(isa) } }, "frame", 1.0, {}, {} };
+				result.seconds = measure(options.settings, [] {}, [&] { statistics = renderer.render(scene, frame); });
+
+				result.counters = {
+					{ "megapixels_per_second", static_cast<double>(width * height) / result.median_seconds() / 1e6 },
+					{ "threads", static_cast<double>(statistics.thread_count) },
+					{ "precision", to_string(statistics.precision) },
+					{ "subdivision_saving", statistics.subdivision_saving() },
+					{ "mean_iterations", statistics.iterations.mean() },
+					{ "stolen_tiles", static_cast<double>(statistics.stolen_tiles) } };
+				return result;
+			} });
+		}
+	}
+}
+
+auto main(int argc, char** argv) -> int {
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--help") == 0) {
+			std::cout << benchmark_usage;
+			return 0;
+		}
+	}
+
+	try {
+		const auto options = parse_command_line(argc, argv);
+
+		std::vector<benchmark_case> cases;
+		add_polynomial_benchmarks(cases, options);
+		add_root_finder_benchmarks(cases, options);
+		add_zero_index_benchmarks(cases, options);
+		add_palette_benchmarks(cases, options);
+		add_kernel_benchmarks(cases, options);
+		add_method_benchmarks(cases, options);
+		add_scene_benchmarks(cases, options);
+
+		std::vector<euleristic::benchmark_result> results;
+		for (const auto& benchmark : cases) {
+			if (benchmark.label.find(options.filter) == std::string::npos) continue;
+			results.push_back(benchmark.run());
+			if (!options.quiet) {
+				const auto& result = results.back();
+				std::cerr << std::format("{:<64} {:>12} per {} ({} repetitions)\n", benchmark.label,
+					readable_duration(result.nanoseconds_per_item()), result.unit, result.seconds.size());
+			}
+		}
+
+		const auto context = euleristic::current_benchmark_context(options.settings);
+		if (options.output == "-") {
+			euleristic::write_json(std::cout, context, results);
+		}
+		else {
+			std::ofstream output(options.output);
+			if (!output.is_open()) {
+				throw std::runtime_error("Could not open " + options.output + " for writing.");
+			}
+			euleristic::write_json(output, context, results);
+		}
+	} catch (std::exception& err) {
+		std::cerr << err.what() << '\n';
+		return 1;
+	}
+	return 0;
+}